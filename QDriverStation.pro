@@ -51,6 +51,7 @@ QT += svg
 QT += core
 QT += quick
 QT += widgets
+QT += network
 
 #-------------------------------------------------------------------------------
 # Compiler options
@@ -109,15 +110,64 @@ SOURCES += \
   $$PWD/src/utilities.cpp \
   $$PWD/src/beeper.cpp \
   $$PWD/src/dashboards.cpp \
-  $$PWD/src/shortcuts.cpp
+  $$PWD/src/shortcuts.cpp \
+  $$PWD/src/joysticks.cpp \
+  $$PWD/src/benchmarks.cpp \
+  $$PWD/src/latency.cpp \
+  $$PWD/src/hostprobe.cpp \
+  $$PWD/src/plotitem.cpp \
+  $$PWD/src/history.cpp \
+  $$PWD/src/dsstate.cpp \
+  $$PWD/src/recorder.cpp \
+  $$PWD/src/inputlog.cpp \
+  $$PWD/src/messagemodel.cpp \
+  $$PWD/src/floodcontrol.cpp \
+  $$PWD/src/asynclogger.cpp \
+  $$PWD/src/logfile.cpp \
+  $$PWD/src/startupprofiler.cpp \
+  $$PWD/src/sdlloader.cpp \
+  $$PWD/src/headless.cpp \
+  $$PWD/src/controlserver.cpp \
+  $$PWD/src/statepublisher.cpp \
+  $$PWD/src/appsettings.cpp
   
 HEADERS += \
   $$PWD/src/utilities.h \
   $$PWD/src/beeper.h \
   $$PWD/src/dashboards.h \
   $$PWD/src/versions.h \
-  $$PWD/src/shortcuts.h
+  $$PWD/src/shortcuts.h \
+  $$PWD/src/joysticks.h \
+  $$PWD/src/benchmarks.h \
+  $$PWD/src/latency.h \
+  $$PWD/src/hostprobe.h \
+  $$PWD/src/ringbuffer.h \
+  $$PWD/src/plotitem.h \
+  $$PWD/src/history.h \
+  $$PWD/src/dsstate.h \
+  $$PWD/src/recorder.h \
+  $$PWD/src/inputlog.h \
+  $$PWD/src/messagemodel.h \
+  $$PWD/src/floodcontrol.h \
+  $$PWD/src/asynclogger.h \
+  $$PWD/src/logfile.h \
+  $$PWD/src/startupprofiler.h \
+  $$PWD/src/sdlloader.h \
+  $$PWD/src/headless.h \
+  $$PWD/src/controlserver.h \
+  $$PWD/src/statepublisher.h \
+  $$PWD/src/sharedstate.h \
+  $$PWD/src/varint.h \
+  $$PWD/src/appsettings.h
     
+linux:!android {
+    SOURCES += $$PWD/src/cpusampler.cpp \
+               $$PWD/src/powersupply.cpp
+    HEADERS += $$PWD/src/cpusampler.h \
+               $$PWD/src/powersupply.h
+    LIBS += -lrt                                             # shm_open
+}
+
 RESOURCES += \
   $$PWD/qml/qml.qrc \
   $$PWD/etc/resources/resources.qrc
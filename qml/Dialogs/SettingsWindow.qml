@@ -36,8 +36,8 @@ Window {
     title: qsTr ("Settings")
     minimumWidth: Globals.scale (420)
     maximumWidth: Globals.scale (420)
-    minimumHeight: Globals.scale (340)
-    maximumHeight: Globals.scale (340)
+    minimumHeight: Globals.scale (575)
+    maximumHeight: Globals.scale (575)
     color: Globals.Colors.WindowBackground
 
     //
@@ -77,7 +77,17 @@ Window {
     function apply() {
         updatePlaceholders()
         CppBeeper.setEnabled (enableSoundEffects.checked)
+        CppBeeper.setBufferSize (parseInt (audioBuffer.currentText))
+        CppBeeper.setIdleTimeout (Globals.audioIdleTimeouts [audioIdle.currentIndex])
         CppUtilities.setAutoScaleEnabled (autoScale.checked)
+        CppRecorder.setEnabled (recordTelemetry.checked)
+        CppMessages.setCapacity (parseInt (consoleLines.currentText))
+        CppDashboard.setPriority (dashboardPriority.currentIndex)
+        CppDashboard.setReserveCore (dashboardReserveCore.checked)
+        CppDashboard.setLimitResources (dashboardLimits.checked)
+        CppDashboard.setKeepStandby (dashboardStandby.checked)
+        CppShortcuts.setEmergencyStopKey (emergencyStopKey.currentIndex)
+        CppShortcuts.setEmergencyStopButton (emergencyStopButton.currentIndex - 1)
 		
         CppDS.customFMSAddress = fmsAddress.text
         CppDS.customRadioAddress = radioAddress.text
@@ -115,7 +125,18 @@ Window {
         property alias y: window.y
         property alias address: robotAddress.text
         property alias autoScale: autoScale.checked
+        property alias recordTelemetry: recordTelemetry.checked
         property alias enableSoundEffects: enableSoundEffects.checked
+        property alias audioBuffer: audioBuffer.currentIndex
+        property alias audioIdle: audioIdle.currentIndex
+        property alias consoleLines: consoleLines.currentIndex
+        property alias prelaunchDashboard: prelaunchDashboard.checked
+        property alias dashboardPriority: dashboardPriority.currentIndex
+        property alias dashboardReserveCore: dashboardReserveCore.checked
+        property alias dashboardLimits: dashboardLimits.checked
+        property alias dashboardStandby: dashboardStandby.checked
+        property alias emergencyStopKey: emergencyStopKey.currentIndex
+        property alias emergencyStopButton: emergencyStopButton.currentIndex
     }
 
     //
@@ -233,16 +254,162 @@ Window {
                         spacing: Globals.spacing
 
                         Checkbox {
-                            checked: true
+                            checked: CppSettings.defaultValue ("SettingsWindow/enableSoundEffects")
                             id: enableSoundEffects
                             text: qsTr ("Enable UI sound effects")
                         }
 
+                        //
+                        // Audio buffer size (in samples) & measured latency
+                        //
+                        RowLayout {
+                            spacing: Globals.spacing
+                            enabled: enableSoundEffects.checked
+
+                            Label {
+                                text: qsTr ("Audio buffer") + ":"
+                            }
+
+                            Combobox {
+                                id: audioBuffer
+                                currentIndex: CppSettings.defaultValue ("SettingsWindow/audioBuffer")
+                                model: Globals.audioBufferSizes
+                            }
+
+                            Label {
+                                size: small
+                                color: Globals.Colors.IconColor
+                                text: CppBeeper.latency > 0 ?
+                                          qsTr ("%1 ms at %2 Hz").arg (CppBeeper.latency).arg (CppBeeper.sampleRate) :
+                                          qsTr ("%1 Hz").arg (CppBeeper.sampleRate)
+                            }
+                        }
+
+                        //
+                        // Time without sounds after which the audio device is closed
+                        //
+                        RowLayout {
+                            spacing: Globals.spacing
+                            enabled: enableSoundEffects.checked
+
+                            Label {
+                                text: qsTr ("Close audio device after") + ":"
+                            }
+
+                            Combobox {
+                                id: audioIdle
+                                currentIndex: CppSettings.defaultValue ("SettingsWindow/audioIdle")
+                                model: [qsTr ("5 seconds"),
+                                        qsTr ("30 seconds"),
+                                        qsTr ("2 minutes"),
+                                        qsTr ("Never")]
+                            }
+                        }
+
+                        //
+                        // Number of messages kept by the console
+                        //
+                        RowLayout {
+                            spacing: Globals.spacing
+
+                            Label {
+                                text: qsTr ("Console lines") + ":"
+                            }
+
+                            Combobox {
+                                id: consoleLines
+                                currentIndex: CppSettings.defaultValue ("SettingsWindow/consoleLines")
+                                model: Globals.consoleLineCounts
+                            }
+                        }
+
+                        //
+                        // Key & joystick button that trigger the emergency stop
+                        //
+                        RowLayout {
+                            spacing: Globals.spacing
+
+                            Label {
+                                text: qsTr ("E-Stop") + ":"
+                            }
+
+                            Combobox {
+                                id: emergencyStopKey
+                                currentIndex: CppSettings.defaultValue ("SettingsWindow/emergencyStopKey")
+                                model: [qsTr ("Space"),
+                                        qsTr ("Backspace"),
+                                        qsTr ("Escape"),
+                                        qsTr ("F12")]
+                            }
+
+                            Combobox {
+                                id: emergencyStopButton
+                                currentIndex: CppSettings.defaultValue ("SettingsWindow/emergencyStopButton")
+                                model: {
+                                    var buttons = [qsTr ("No joystick button")]
+                                    for (var i = 1; i <= 12; ++i)
+                                        buttons.push (qsTr ("Button %1").arg (i))
+
+                                    return buttons
+                                }
+                            }
+                        }
+
                         Checkbox {
-                            checked: true
+                            checked: CppSettings.defaultValue ("SettingsWindow/autoScale")
                             id: autoScale
                             text: qsTr ("Auto-scale text and UI items")
                         }
+
+                        Checkbox {
+                            checked: CppSettings.defaultValue ("SettingsWindow/recordTelemetry")
+                            id: recordTelemetry
+                            text: qsTr ("Record robot telemetry and joystick input")
+                        }
+
+                        Checkbox {
+                            checked: CppSettings.defaultValue ("SettingsWindow/prelaunchDashboard")
+                            id: prelaunchDashboard
+                            text: qsTr ("Launch the dashboard while the DS starts")
+                        }
+
+                        //
+                        // Resources given to the dashboard (applied when it is launched)
+                        //
+                        RowLayout {
+                            spacing: Globals.spacing
+
+                            Label {
+                                text: qsTr ("Dashboard priority") + ":"
+                            }
+
+                            Combobox {
+                                id: dashboardPriority
+                                currentIndex: CppSettings.defaultValue ("SettingsWindow/dashboardPriority")
+                                model: [qsTr ("Normal"),
+                                        qsTr ("Low"),
+                                        qsTr ("Lowest")]
+                            }
+                        }
+
+                        Checkbox {
+                            checked: CppSettings.defaultValue ("SettingsWindow/dashboardReserveCore")
+                            id: dashboardReserveCore
+                            text: qsTr ("Keep a CPU core free from the dashboard")
+                        }
+
+                        Checkbox {
+                            checked: CppSettings.defaultValue ("SettingsWindow/dashboardLimits")
+                            id: dashboardLimits
+                            visible: CppDashboard.resourceLimitsAvailable
+                            text: qsTr ("Limit the dashboard to %1% CPU and %2 MB").arg (50).arg (1024)
+                        }
+
+                        Checkbox {
+                            checked: CppSettings.defaultValue ("SettingsWindow/dashboardStandby")
+                            id: dashboardStandby
+                            text: qsTr ("Keep the previous dashboard running for %1 minutes").arg (2)
+                        }
                     }
                 }  
 
@@ -148,7 +148,7 @@ Window {
         //
         Spinbox {
             id: spin
-            value: 100
+            value: CppSettings.defaultValue ("VirtualJoystick/range")
             from: 0
             to: 100
             Layout.fillWidth: true
@@ -167,7 +167,7 @@ Window {
             //
             Checkbox {
                 id: checkbox
-                checked: false
+                checked: CppSettings.defaultValue ("VirtualJoystick/enabled")
                 Layout.fillWidth: true
                 text: qsTr ("Use my keyboard as a joystick")
                 backgroundColor: Globals.Colors.WidgetBackground
@@ -68,6 +68,15 @@ var spacing = scale (10)
 //
 var invalidStr = "--.--"
 
+//
+// Choices of the audio buffer (in samples), audio idle timeout (in ms, 0 to
+// never close the device) and console size (in lines), shared by the
+// settings window and the settings applied on launch
+//
+var audioBufferSizes = ["64", "128", "256", "512", "1024"]
+var audioIdleTimeouts = [5000, 30000, 120000, 0]
+var consoleLineCounts = ["500", "1000", "2000", "5000", "10000"]
+
 //
 // Specified the UI and monospace fonts used by the application
 //
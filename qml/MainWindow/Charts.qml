@@ -21,6 +21,7 @@
  */
 
 import QtQuick 2.0
+import QDriverStation 1.0
 import QtQuick.Window 2.0
 import QtQuick.Layouts 1.0
 import Qt.labs.settings 1.0
@@ -30,13 +31,11 @@ import "../Globals.js" as Globals
 
 Item {
     //
-    // Changes the horizontal refresh rate of the charts
+    // Changes the time window of the charts, they are redrawn from the history
     //
     function updateGraphTimes (seconds) {
-        loss.clear()
-        voltage.clear()
-        loss.setSpeed (seconds)
-        voltage.setSpeed (seconds)
+        loss.timeSpan = seconds
+        voltage.timeSpan = seconds
     }
 
     //
@@ -147,13 +146,13 @@ Item {
         Plot {
             id: loss
             value: 0
-            from: 0
+            from: 1
             to: 100
             Layout.fillWidth: true
             Layout.fillHeight: true
+            history: CppHistory
+            channel: History.kPacketLoss
             barColor: Globals.Colors.PacketLoss
-            onRefreshed: value = Math.max (1, CppDS.robotPacketLoss)
-            Component.onCompleted: value = Math.max (1, CppDS.robotPacketLoss)
         }
 
         //
@@ -168,6 +167,9 @@ Item {
         //
         VoltageGraph {
             id: voltage
+            history: CppHistory
+            channel: History.kVoltage
+            barColor: Globals.Colors.IndicatorGood
             Layout.fillWidth: true
             Layout.fillHeight: true
         }
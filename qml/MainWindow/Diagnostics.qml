@@ -150,4 +150,168 @@ RowLayout {
     Item {
         Layout.fillWidth: true
     }
+
+    //
+    // Input latency items (time from joystick input to the DS)
+    //
+    ColumnLayout {
+        Layout.fillHeight: true
+        spacing: Globals.spacing
+
+        Label {
+            font.bold: true
+            text: qsTr ("Input Latency") + ":"
+        }
+
+        Grid {
+            columns: 2
+            rowSpacing: Globals.scale (1)
+            columnSpacing: Globals.spacing
+
+            Label {
+                text: qsTr ("Median")
+            }
+
+            Label {
+                text: CppJoysticks.latencySamples > 0 ? CppJoysticks.latencyP50.toFixed (1) + " ms" :
+                                                        Globals.invalidStr
+            }
+
+            Label {
+                text: qsTr ("99th %")
+            }
+
+            Label {
+                text: CppJoysticks.latencySamples > 0 ? CppJoysticks.latencyP99.toFixed (1) + " ms" :
+                                                        Globals.invalidStr
+            }
+
+            Label {
+                text: qsTr ("Maximum")
+            }
+
+            Label {
+                text: CppJoysticks.latencySamples > 0 ? CppJoysticks.latencyMax.toFixed (1) + " ms" :
+                                                        Globals.invalidStr
+            }
+
+            Label {
+                text: qsTr ("Samples")
+            }
+
+            Label {
+                text: CppJoysticks.latencySamples
+            }
+        }
+
+        Item {
+            Layout.fillHeight: true
+        }
+
+        ColumnLayout {
+            spacing: Globals.scale (-1)
+
+            Button {
+                Layout.fillWidth: true
+                text: qsTr ("Export") + "..."
+                onClicked: CppJoysticks.exportLatency()
+            }
+
+            Button {
+                Layout.fillWidth: true
+                text: qsTr ("Reset")
+                onClicked: CppJoysticks.resetLatency()
+            }
+        }
+    }
+
+    //
+    // Yet another spacer
+    //
+    Item {
+        Layout.fillWidth: true
+    }
+
+    //
+    // Emergency stop dispatch items (time from the e-stop key or button
+    // event to the DS accepting the emergency stop, the packet is sent by
+    // the DS on its next cycle)
+    //
+    ColumnLayout {
+        Layout.fillHeight: true
+        spacing: Globals.spacing
+
+        Label {
+            font.bold: true
+            text: qsTr ("E-Stop Dispatch") + ":"
+        }
+
+        Grid {
+            columns: 2
+            rowSpacing: Globals.scale (1)
+            columnSpacing: Globals.spacing
+
+            Label {
+                text: qsTr ("Median")
+            }
+
+            Label {
+                text: CppShortcuts.latencySamples > 0 ? CppShortcuts.latencyP50.toFixed (1) + " ms" :
+                                                        Globals.invalidStr
+            }
+
+            Label {
+                text: qsTr ("99th %")
+            }
+
+            Label {
+                text: CppShortcuts.latencySamples > 0 ? CppShortcuts.latencyP99.toFixed (1) + " ms" :
+                                                        Globals.invalidStr
+            }
+
+            Label {
+                text: qsTr ("Maximum")
+            }
+
+            Label {
+                text: CppShortcuts.latencySamples > 0 ? CppShortcuts.latencyMax.toFixed (1) + " ms" :
+                                                        Globals.invalidStr
+            }
+
+            Label {
+                text: qsTr ("Samples")
+            }
+
+            Label {
+                text: CppShortcuts.latencySamples
+            }
+        }
+
+        Item {
+            Layout.fillHeight: true
+        }
+
+        ColumnLayout {
+            spacing: Globals.scale (-1)
+
+            Button {
+                Layout.fillWidth: true
+                text: qsTr ("Export") + "..."
+                onClicked: CppShortcuts.exportLatency()
+            }
+
+            Button {
+                Layout.fillWidth: true
+                text: qsTr ("Reset")
+                onClicked: CppShortcuts.resetLatency()
+            }
+        }
+    }
+
+    //
+    // Last spacer
+    //
+    Item {
+        Layout.fillWidth: true
+    }
 }
@@ -85,36 +85,13 @@ Item {
     }
 
     //
-    // Regenerate the UI when a joystick is removed or attached and
-    // update DriverStation joysticks
+    // Regenerate the UI when a joystick is removed or attached.
+    // Joystick input is sent to the DriverStation from C++ (see joysticks.cpp)
     //
     Connections {
         target: QJoysticks
-
         function onCountChanged() {
             updateControls()
-            CppDS.resetJoysticks()
-
-            for (var i = 0; i < QJoysticks.count; ++i) {
-                CppDS.addJoystick (QJoysticks.getNumAxes (i),
-                                   QJoysticks.getNumPOVs (i),
-                                   QJoysticks.getNumButtons (i))
-            }
-        }
-
-        function onPovChanged(js, pov, angle) {
-            var val = QJoysticks.isBlacklisted (currentJoystick) ? 0 : angle
-            CppDS.setJoystickHat (js, pov, val)
-        }
-
-        function onAxisChanged(js, axis, value) {
-            var val = QJoysticks.isBlacklisted (currentJoystick) ? 0 : value
-            CppDS.setJoystickAxis (js, axis, val)
-        }
-
-        function onButtonChanged(js, button, pressed) {
-            var val = QJoysticks.isBlacklisted (currentJoystick) ? false : pressed
-            CppDS.setJoystickButton (js, button, val)
         }
     }
 
@@ -121,12 +121,14 @@ RowLayout {
         function showPreferences() {
             hideWidgets()
             updateWidth()
+            preferences.active = true
             preferences.opacity = 1
         }
 
         function showDiagnostics() {
             hideWidgets()
             updateWidth()
+            diagnostics.active = true
             diagnostics.opacity = 1
         }
 
@@ -148,20 +150,28 @@ RowLayout {
             onWindowModeChanged: tab.windowModeChanged (isDocked)
         }
 
-        Diagnostics {
+        //
+        // The diagnostics and preferences pages are created when they are
+        // first shown
+        //
+        Loader {
             opacity: 0
+            active: false
             id: diagnostics
             visible: opacity > 0
             anchors.fill: parent
             anchors.margins: Globals.spacing
+            sourceComponent: Diagnostics {}
         }
 
-        Preferences {
+        Loader {
             opacity: 0
+            active: false
             id: preferences
             visible: opacity > 0
             anchors.fill: parent
             anchors.margins: Globals.spacing
+            sourceComponent: Preferences {}
         }
 
         Joysticks {
@@ -24,6 +24,7 @@ import QtQuick 2.0
 import QtQuick.Layouts 1.0
 import QtQuick.Controls 2.15
 import Qt.labs.settings 1.0
+import QDriverStation 1.0
 
 import "../Widgets"
 import "../Globals.js" as Globals
@@ -32,20 +33,11 @@ ColumnLayout {
     spacing: Globals.spacing
 
     //
-    // Save protocol value between runs
+    // Save protocol value and console filter between runs
     //
     Settings {
         property alias protocolVersion: protocol.currentIndex
-    }
-
-    //
-    // Write to the console every time the DS receives a message
-    //
-    Connections {
-        target: CppDS
-        function onNewMessage(message) {
-            messages.editor.append (message)
-        }
+        property alias messageFilter: filter.currentIndex
     }
 
     //
@@ -56,12 +48,22 @@ ColumnLayout {
 
         MenuItem {
             text: qsTr ("Open Application Logs")
-            onTriggered: CppDSLogger.openLogsPath()
+            onTriggered: {
+                if (CppLogger.enabled)
+                    CppLogger.openLogsPath()
+                else
+                    CppDSLogger.openLogsPath()
+            }
         }
 
         MenuItem {
             text: qsTr ("Open Current Log")
-            onTriggered: CppDSLogger.openCurrentLog()
+            onTriggered: {
+                if (CppLogger.enabled)
+                    CppLogger.openCurrentLog()
+                else
+                    CppDSLogger.openCurrentLog()
+            }
         }
     }
 
@@ -89,8 +91,8 @@ ColumnLayout {
             iconSize: Globals.scale (12)
 
             onClicked: {
-                messages.copy()
-                messages.editor.append ("<font color=#888>** <font color=#AAA> "
+                CppUtilities.copy (CppMessages.plainText())
+                CppFloodControl.ingest ("<font color=#888>** <font color=#AAA> "
                                         + qsTr ("Information")
                                         + ":</font> "
                                         + qsTr ("Console output copied to clipboard")
@@ -103,13 +105,60 @@ ColumnLayout {
             width: Globals.scale (48)
             height: Globals.scale (24)
             iconSize: Globals.scale (12)
-            onClicked: messages.text = ""
+            onClicked: {
+                CppMessages.clear()
+                CppFloodControl.resetCounters()
+            }
+        }
+
+        Item {
+            width: Globals.spacing
+            height: Globals.spacing
+        }
+
+        //
+        // Number of messages hidden by the flood control
+        //
+        Label {
+            size: small
+            color: Globals.Colors.IconColor
+            visible: CppFloodControl.collapsed + CppFloodControl.dropped > 0
+            text: qsTr ("%1 repeated, %2 dropped").arg (CppFloodControl.collapsed)
+                                                  .arg (CppFloodControl.dropped)
         }
 
         Item {
             Layout.fillWidth: true
         }
 
+        //
+        // Shows only the messages of the selected severity
+        //
+        Combobox {
+            id: filter
+            width: 92
+            alignRight: true
+            Layout.fillHeight: true
+            model: [qsTr ("All"),
+                    qsTr ("Errors"),
+                    qsTr ("Warnings"),
+                    qsTr ("Information"),
+                    qsTr ("Robot Output")]
+
+            property var severities: [MessageModel.kAll,
+                                      MessageModel.kError,
+                                      MessageModel.kWarning,
+                                      MessageModel.kInformation,
+                                      MessageModel.kOutput]
+
+            onCurrentIndexChanged: CppMessages.setFilter (severities [currentIndex])
+        }
+
+        Item {
+            width: Globals.spacing
+            height: Globals.spacing
+        }
+
         Combobox {
             width: 92
             id: protocol
@@ -121,18 +170,79 @@ ColumnLayout {
     }
 
     //
-    // Draw the console
+    // Draw the console, the list only creates the visible messages
     //
-    TextEditor {
-        id: messages
-        editor.readOnly: true
+    Rectangle {
         Layout.fillWidth: true
         Layout.fillHeight: true
-        editor.textFormat: Text.RichText
-        editor.font.family: Globals.monoFont
-        editor.font.pixelSize: Globals.scale (13)
-        foregroundColor: Globals.Colors.WidgetForeground
-        backgroundColor: Globals.Colors.WindowBackground
-        editor.wrapMode: TextEdit.WrapAtWordBoundaryOrAnywhere
+        border.width: Globals.scale (1)
+        color: Globals.Colors.WindowBackground
+        border.color: Globals.Colors.WidgetBorder
+
+        //
+        // Used to show the scrollbar when mouse is over control
+        //
+        MouseArea {
+            id: mouse
+            hoverEnabled: true
+            anchors.fill: parent
+            onContainsMouseChanged: scroll.showControl()
+        }
+
+        //
+        // The messages, the view keeps following the newest message
+        // until the user scrolls up
+        //
+        ListView {
+            id: messages
+            clip: true
+            model: CppMessages
+            boundsBehavior: Flickable.StopAtBounds
+
+            property bool follow: true
+
+            onMovementEnded: follow = atYEnd
+            onCountChanged: {
+                if (follow)
+                    positionViewAtEnd()
+            }
+
+            anchors {
+                fill: parent
+                margins: Globals.spacing
+                rightMargin: Globals.scale (16)
+            }
+
+            delegate: Text {
+                text: model.count > 1 ? model.text + " <font color=#888>(x" + model.count + ", "
+                                        + Qt.formatTime (model.first, "hh:mm:ss") + " - "
+                                        + Qt.formatTime (model.last, "hh:mm:ss") + ")</font>"
+                                      : model.text
+                width: messages.width
+                textFormat: Text.StyledText
+                font.family: Globals.monoFont
+                font.pixelSize: Globals.scale (13)
+                color: Globals.Colors.WidgetForeground
+                wrapMode: Text.WrapAtWordBoundaryOrAnywhere
+            }
+        }
+
+        //
+        // The scrollbar
+        //
+        Scrollbar {
+            id: scroll
+            mouseArea: mouse
+            scrollArea: messages
+            height: parent.height
+            width: Globals.scale (8)
+
+            anchors {
+                top: parent.top
+                right: parent.right
+                bottom: parent.bottom
+                margins: Globals.scale (6)
+            }
+        }
     }
 }
@@ -229,6 +229,27 @@ RowLayout {
             barColor: Globals.Colors.CPUProgress
         }
 
+        //
+        // Dashboard CPU label
+        //
+        Label {
+            Layout.fillWidth: true
+            text: qsTr ("Dashboard") + " %"
+            horizontalAlignment: Text.AlignRight
+            visible: CppUtilities.dashboardMemoryUsage > 0
+        }
+
+        //
+        // Dashboard CPU progressbar (with its resident memory)
+        //
+        Progressbar {
+            Layout.fillWidth: true
+            value: CppUtilities.dashboardCpuUsage
+            barColor: Globals.Colors.CPUProgress
+            visible: CppUtilities.dashboardMemoryUsage > 0
+            text: qsTr ("%1% / %2 MB").arg (value).arg (CppUtilities.dashboardMemoryUsage)
+        }
+
         //
         // Spacer (for both columns)
         //
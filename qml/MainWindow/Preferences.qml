@@ -41,13 +41,6 @@ RowLayout {
         property alias dashbaord: dashboard.currentIndex
     }
 
-    //
-    // Open the dashboard on application launch
-    //
-    Component.onCompleted: {
-        CppDashboard.openDashboard (dashboard.currentIndex)
-    }
-
     //
     // Team number, dashboard & game data
     //
@@ -93,6 +86,16 @@ RowLayout {
             onCurrentIndexChanged: CppDashboard.openDashboard (dashboard.currentIndex)
         }
 
+        //
+        // Dashboard launch status
+        //
+        Label {
+            size: small
+            visible: text !== ""
+            text: CppDashboard.status
+            color: Globals.Colors.IconColor
+        }
+
         //
         // Game data label
         //
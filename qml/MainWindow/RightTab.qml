@@ -50,11 +50,13 @@ RowLayout {
 
         function showCharts() {
             hideWidgets()
+            charts.active = true
             charts.opacity = 1
         }
 
         function showAbout() {
             hideWidgets()
+            about.active = true
             about.opacity = 1
         }
 
@@ -68,20 +70,27 @@ RowLayout {
             anchors.margins: Globals.spacing
         }
 
-        Charts {
+        //
+        // The charts and about pages are created when they are first shown
+        //
+        Loader {
             opacity: 0
+            active: false
             id: charts
             visible: opacity > 0
             anchors.fill: parent
             anchors.margins: Globals.spacing
+            sourceComponent: Charts {}
         }
 
-        About {
+        Loader {
             id: about
             opacity: 0
+            active: false
             visible: opacity > 0
             anchors.fill: parent
             anchors.margins: Globals.spacing
+            sourceComponent: About {}
         }
     }
 
@@ -37,6 +37,10 @@ Plot {
     function update() {
         value = CppDS.voltage
 
+        /* The history colors each bar with the warning & error levels */
+        if (history !== null)
+            return
+
         if (!CppDS.connectedToRobot) {
             barColor = noCommsColor
             value = to * 0.95
@@ -60,6 +64,8 @@ Plot {
     // Start graphing from origin, not from the middle or some other place
     //
     from: 0
+    errorLevel: 0.70
+    warningLevel: 0.80
     Component.onCompleted: update()
     to: CppDS.maximumBatteryVoltage
 }
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+import QtQuick 2.0
+import Qt.labs.settings 1.0
+
+import "Globals.js" as Globals
+
+//
+// Applies the saved settings when the application starts. The pages and
+// dialogs that own these settings are only created when they are first
+// shown, so their saved values are read here (without declaring any
+// property, so nothing is written back).
+//
+Item {
+    //
+    // Set to true once the settings window exists and applies its own values
+    //
+    property bool settingsWindowLoaded: false
+
+    //
+    // Returns the saved index of a combobox, or its default index if the
+    // saved one is not valid for the given number of items
+    //
+    function index (key, count) {
+        var value = CppSettings.value (key)
+        return value >= 0 && value < count ? value : CppSettings.defaultValue (key)
+    }
+
+    //
+    // Settings of the preferences page (which has no default value for the
+    // team number and the game data)
+    //
+    Settings {
+        id: preferences
+    }
+
+    //
+    // The robot address must be applied again when the protocol changes
+    //
+    Connections {
+        target: CppDS
+        enabled: !settingsWindowLoaded
+        function onProtocolChanged() {
+            CppDS.customRobotAddress = CppSettings.value ("SettingsWindow/address")
+        }
+    }
+
+    //
+    // Apply the settings on launch, the saved values (or their defaults) are
+    // read through CppSettings, so the defaults are only written there
+    //
+    Component.onCompleted: {
+        /* Preferences page */
+        var team = preferences.value ("team")
+        if (team !== undefined)
+            CppDS.teamNumber = parseInt (team)
+
+        var gameData = preferences.value ("gameDataStr")
+        if (gameData !== undefined)
+            CppDS.setGameData (gameData)
+
+        CppDashboard.openDashboard (index ("dashbaord", CppDashboard.dashboardList().length))
+
+        /* Settings window */
+        var buffer = index ("SettingsWindow/audioBuffer", Globals.audioBufferSizes.length)
+        var lines = index ("SettingsWindow/consoleLines", Globals.consoleLineCounts.length)
+        var idle = index ("SettingsWindow/audioIdle", Globals.audioIdleTimeouts.length)
+        CppBeeper.setIdleTimeout (Globals.audioIdleTimeouts [idle])
+        CppBeeper.setEnabled (CppSettings.value ("SettingsWindow/enableSoundEffects"))
+        CppBeeper.setBufferSize (parseInt (Globals.audioBufferSizes [buffer]))
+        CppUtilities.setAutoScaleEnabled (CppSettings.value ("SettingsWindow/autoScale"))
+        CppRecorder.setEnabled (CppSettings.value ("SettingsWindow/recordTelemetry"))
+        CppMessages.setCapacity (parseInt (Globals.consoleLineCounts [lines]))
+        CppDS.customRobotAddress = CppSettings.value ("SettingsWindow/address")
+
+        /* Virtual joystick window */
+        QJoysticks.setVirtualJoystickRange (CppSettings.value ("VirtualJoystick/range") / 100)
+        QJoysticks.setVirtualJoystickEnabled (CppSettings.value ("VirtualJoystick/enabled"))
+    }
+}
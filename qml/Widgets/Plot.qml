@@ -21,6 +21,7 @@
  */
 
 import QtQuick 2.0
+import QDriverStation 1.0
 import "../Globals.js" as Globals
 
 Rectangle {
@@ -37,9 +38,9 @@ Rectangle {
     property double rectWidth: Globals.scale (2)
 
     //
-    // Gives direct access to the canvas object
+    // Gives direct access to the C++ plot item
     //
-    property alias canvasObject: canvas
+    property alias plotItem: graph
 
     //
     // Defines the color to use to draw the lines
@@ -54,7 +55,19 @@ Rectangle {
     property double to: 100
 
     //
-    // Emitted when the timer expires and a canvas repaint is done
+    // History options, when a history is set the graph draws the last
+    // timeSpan seconds of the given channel instead of sweeping
+    //
+    property QtObject history: null
+    property int channel: 0
+    property double timeSpan: 60
+    property double warningLevel: -1
+    property double errorLevel: -1
+    property string warningColor: Globals.Colors.IndicatorWarning
+    property string errorColor: Globals.Colors.IndicatorError
+
+    //
+    // Emitted when the timer expires and a new bar is added
     //
     signal refreshed
 
@@ -78,14 +91,13 @@ Rectangle {
 
         /* Apply obtained interval */
         refreshInterval = newInterval
-        timer.interval = refreshInterval
     }
 
     //
-    // Forces the canvas to clear its plot
+    // Forces the graph to clear its plot
     //
     function clear() {
-        timer.currentPos = canvas.width / rectWidth
+        graph.clear()
     }
 
     //
@@ -96,59 +108,26 @@ Rectangle {
     border.color: Globals.Colors.WidgetBorder
 
     //
-    // Refreshes the graph on real-time
+    // The actual item used to draw the graph, it only draws new bars and
+    // stops refreshing while it is hidden
     //
-    Timer {
-        id: timer
-        interval: refreshInterval
-        Component.onCompleted: start()
-
-        property int currentPos: 0
-
-        onTriggered: {
-            if (plot.visible)
-                ++currentPos
-
-            canvas.requestPaint()
-            parent.refreshed()
-        }
-    }
-
-    //
-    // The actual canvas used to draw the graph
-    //
-    Canvas {
-        id: canvas
+    PlotItem {
+        id: graph
+        to: plot.to
+        from: plot.from
+        value: plot.value
         anchors.fill: parent
-        renderStrategy: Canvas.Threaded
+        barColor: plot.barColor
+        rectWidth: plot.rectWidth
+        onRefreshed: plot.refreshed()
+        refreshInterval: plot.refreshInterval
+        history: plot.history
+        channel: plot.channel
+        timeSpan: plot.timeSpan
+        errorLevel: plot.errorLevel
+        errorColor: plot.errorColor
+        warningLevel: plot.warningLevel
+        warningColor: plot.warningColor
         anchors.margins: parent.border.width
-
-        onPaint: {
-            /* Lazy is good sometimes */
-            if (plot.visible) {
-                /* Get drawing context */
-                var context = getContext('2d')
-
-                /* Set the bar color */
-                context.fillStyle = barColor
-
-                /* Calculate X and Y coordinates */
-                var yOffset = (1 - getLevel()) * height
-                var xOffset = timer.currentPos * rectWidth
-
-                /* Reset the graph if it is greater than the width */
-                if (xOffset > canvas.width) {
-                    xOffset = 0
-                    timer.currentPos = 0
-                    context.clearRect (0, 0, canvas.width, canvas.height)
-                }
-
-                /* Draw a single bar */
-                context.fillRect (xOffset, yOffset, rectWidth, height)
-            }
-
-            /* Restart the timer */
-            timer.restart()
-        }
     }
 }
@@ -34,14 +34,16 @@ Item {
     // Display the virtual joystick window (from anywhere in the app)
     //
     function showVirtualJoystickWindow() {
-        virtualJoystickWindow.show()
+        virtualJoystickWindow.active = true
+        virtualJoystickWindow.item.show()
     }
 
     //
     // Display the settings window (from anywhere in the app)
     //
     function showSettingsWindow() {
-        settingsWindow.show()
+        settingsWindow.active = true
+        settingsWindow.item.show()
     }
 
     //
@@ -78,16 +80,27 @@ Item {
     }
 
     //
-    // The settings window
+    // Apply the saved settings of the windows & pages that are not loaded yet
     //
-    SettingsWindow {
+    StartupSettings {
+        settingsWindowLoaded: settingsWindow.active
+    }
+
+    //
+    // The settings window, created when it is first shown
+    //
+    Loader {
         id: settingsWindow
+        active: false
+        sourceComponent: SettingsWindow {}
     }
 
     //
-    // The virtual joystick window
+    // The virtual joystick window, created when it is first shown
     //
-    VirtualJoystickWindow {
+    Loader {
+        active: false
         id: virtualJoystickWindow
+        sourceComponent: VirtualJoystickWindow {}
     }
 }
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "appsettings.h"
+
+#include <QDebug>
+#include <QSettings>
+#include <QCoreApplication>
+
+/**
+ * Returns the default value of each setting
+ */
+static const QVariantHash &Defaults()
+{
+   static const QVariantHash defaults = {
+      /* Preferences page */
+      { "dashbaord", 0 },
+
+      /* Settings window */
+      { "SettingsWindow/address", QString() },
+      { "SettingsWindow/autoScale", true },
+      { "SettingsWindow/recordTelemetry", true },
+      { "SettingsWindow/enableSoundEffects", true },
+      { "SettingsWindow/audioBuffer", 2 },
+      { "SettingsWindow/audioIdle", 1 },
+      { "SettingsWindow/consoleLines", 2 },
+      { "SettingsWindow/prelaunchDashboard", true },
+      { "SettingsWindow/dashboardPriority", 1 },
+      { "SettingsWindow/dashboardReserveCore", true },
+      { "SettingsWindow/dashboardLimits", false },
+      { "SettingsWindow/dashboardStandby", false },
+      { "SettingsWindow/emergencyStopKey", 0 },
+      { "SettingsWindow/emergencyStopButton", 0 },
+
+      /* Virtual joystick window */
+      { "VirtualJoystick/range", 100 },
+      { "VirtualJoystick/enabled", false },
+   };
+
+   return defaults;
+}
+
+/**
+ * Returns the default value of the setting with the given \a key
+ */
+QVariant AppSettings::defaultOf(const QString &key)
+{
+   const QVariantHash &defaults = Defaults();
+   if (!defaults.contains(key))
+      qWarning() << "No default value for setting" << key;
+
+   return defaults.value(key);
+}
+
+/**
+ * Returns the saved value of the setting with the given \a key, or its
+ * default value if it was never saved. The saved value is converted to the
+ * type of the default value, since some formats store everything as text.
+ */
+QVariant AppSettings::read(const QString &key)
+{
+   const QVariant fallback = defaultOf(key);
+   QSettings settings(qApp->organizationName(), qApp->applicationName());
+
+   QVariant value = settings.value(key, fallback);
+   if (fallback.isValid() && !value.convert(fallback.metaType()))
+      return fallback;
+
+   return value;
+}
+
+/**
+ * Returns the default value of the setting with the given \a key
+ */
+QVariant AppSettings::defaultValue(const QString &key) const
+{
+   return defaultOf(key);
+}
+
+/**
+ * Returns the saved (or default) value of the setting with the given \a key
+ */
+QVariant AppSettings::value(const QString &key) const
+{
+   return read(key);
+}
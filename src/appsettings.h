@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_APP_SETTINGS_H
+#define _QDS_APP_SETTINGS_H
+
+#include <QObject>
+#include <QVariant>
+
+/**
+ * \brief Default values of the saved settings
+ *
+ * The settings of the UI are saved by the QML windows that own them, but
+ * some of them are applied before those windows are loaded (by the
+ * \c StartupSettings item, or by C++ objects such as the dashboards & the
+ * shortcuts). All of them take their defaults from this class, so that the
+ * defaults are only written once.
+ *
+ * Keys are given as "Category/name", as in \c QSettings. The value of a
+ * combobox is its index.
+ */
+class AppSettings : public QObject
+{
+   Q_OBJECT
+
+public:
+   static QVariant defaultOf(const QString &key);
+   static QVariant read(const QString &key);
+
+   Q_INVOKABLE QVariant defaultValue(const QString &key) const;
+   Q_INVOKABLE QVariant value(const QString &key) const;
+};
+
+#endif
@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "asynclogger.h"
+
+#include <QDir>
+#include <QUrl>
+#include <QDebug>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <QDesktopServices>
+#include <QCoreApplication>
+
+#include <stdio.h>
+#include <errno.h>
+#include <limits>
+#include <csignal>
+
+#if defined Q_OS_UNIX
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+int AsyncLogger::s_quitPipe[2] = { -1, -1 };
+std::atomic<AsyncLogger *> AsyncLogger::s_instance(Q_NULLPTR);
+
+/* Signals of a crash, the queue cannot be written out safely from them */
+static const int CRASH_SIGNALS[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+
+/* Signals that quit the application, the queue is written out on exit */
+static const int QUIT_SIGNALS[] = { SIGINT, SIGTERM };
+
+/* Printed by the crash handler, which can only use async-signal-safe calls */
+#if defined Q_OS_UNIX
+static const char CRASH_NOTICE[] = "Crash signal received, the last log messages may be lost\n";
+#endif
+
+/**
+ * Returns the name used for the given message \a type in the log
+ */
+static const char *TypeName(const QtMsgType type)
+{
+   switch (type)
+   {
+      case QtDebugMsg:
+         return "DEBUG";
+      case QtInfoMsg:
+         return "INFO";
+      case QtWarningMsg:
+         return "WARNING";
+      case QtCriticalMsg:
+         return "CRITICAL";
+      default:
+         return "FATAL";
+   }
+}
+
+AsyncLogger::AsyncLogger()
+   : m_tail(&m_stub)
+   , m_installed(false)
+   , m_stop(false)
+   , m_previous(Q_NULLPTR)
+   , m_quitNotifier(Q_NULLPTR)
+{
+   m_stub.next.store(Q_NULLPTR);
+   m_head.store(&m_stub);
+   setObjectName("Async Logger");
+}
+
+/**
+ * Restores the previous message handler and writes out the queued messages
+ */
+AsyncLogger::~AsyncLogger()
+{
+   if (m_installed)
+   {
+      qInstallMessageHandler(m_previous);
+      s_instance.store(Q_NULLPTR);
+      for (const int sig : CRASH_SIGNALS)
+         std::signal(sig, SIG_DFL);
+
+#if defined Q_OS_UNIX
+      if (m_quitNotifier)
+      {
+         for (const int sig : QUIT_SIGNALS)
+            std::signal(sig, SIG_DFL);
+
+         delete m_quitNotifier;
+         ::close(s_quitPipe[0]);
+         ::close(s_quitPipe[1]);
+         s_quitPipe[0] = -1;
+         s_quitPipe[1] = -1;
+      }
+#endif
+   }
+
+   m_stop.store(true);
+   m_wakeLock.lock();
+   m_wake.wakeAll();
+   m_wakeLock.unlock();
+   wait();
+
+   flush();
+   if (m_tail != &m_stub)
+      delete m_tail;
+}
+
+/**
+ * Returns \c true if the logger is installed and writes the compressed logs
+ */
+bool AsyncLogger::isEnabled() const
+{
+   return m_installed;
+}
+
+/**
+ * Installs the logger as the application message handler, starts the logger
+ * thread and registers the crash & termination signal handlers
+ */
+void AsyncLogger::install()
+{
+   if (m_installed)
+      return;
+
+   m_installed = true;
+   s_instance.store(this);
+   start(QThread::LowPriority);
+
+   for (const int sig : CRASH_SIGNALS)
+      std::signal(sig, crashHandler);
+
+   /* Quit through the event loop, so that the destructor writes out the queue */
+#if defined Q_OS_UNIX
+   if (pipe(s_quitPipe) == 0)
+   {
+      for (const int fd : s_quitPipe)
+      {
+         fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+         fcntl(fd, F_SETFD, FD_CLOEXEC);
+      }
+
+      m_quitNotifier = new QSocketNotifier(s_quitPipe[0], QSocketNotifier::Read, this);
+      connect(m_quitNotifier, SIGNAL(activated(QSocketDescriptor, QSocketNotifier::Type)), this,
+              SLOT(onQuitSignal()));
+
+      for (const int sig : QUIT_SIGNALS)
+         std::signal(sig, quitHandler);
+   }
+#endif
+
+   m_previous = qInstallMessageHandler(messageHandler);
+}
+
+/**
+ * Writes out all the messages queued before this call, from the calling
+ * thread, and compresses the pending block of the log file
+ */
+void AsyncLogger::flush()
+{
+   QMutexLocker locker(&m_drainLock);
+   while (m_head.load(std::memory_order_acquire) != m_tail)
+   {
+      drain();
+
+      /* A producer swapped the head but did not link its record yet */
+      if (m_head.load(std::memory_order_acquire) != m_tail)
+         QThread::yieldCurrentThread();
+   }
+
+   m_log.writeBlock();
+}
+
+/**
+ * Opens the folder that contains the compressed logs
+ */
+void AsyncLogger::openLogsPath()
+{
+   QDir dir(LogFile::logsPath());
+   if (!dir.exists())
+      dir.mkpath(".");
+
+   QDesktopServices::openUrl(QUrl::fromLocalFile(dir.absolutePath()));
+}
+
+/**
+ * Decompresses the log of the current session to a temporary text file and
+ * opens it with the default text editor
+ */
+void AsyncLogger::openCurrentLog()
+{
+   flush();
+
+   m_drainLock.lock();
+   const QString path = m_log.path();
+   m_drainLock.unlock();
+
+   QByteArray text;
+   const qint64 min = std::numeric_limits<qint64>::min();
+   const qint64 max = std::numeric_limits<qint64>::max();
+   if (path.isEmpty() || !LogFile::read(path, min, max, text))
+      return;
+
+   QFile file(QDir::temp().filePath(QFileInfo(path).completeBaseName() + ".log"));
+   if (file.open(QIODevice::WriteOnly))
+   {
+      file.write(text);
+      file.close();
+      QDesktopServices::openUrl(QUrl::fromLocalFile(file.fileName()));
+   }
+}
+
+/**
+ * Writes the queued messages every few milliseconds, and compresses the
+ * pending block of the log once it gets old enough
+ */
+void AsyncLogger::run()
+{
+   while (!m_stop.load())
+   {
+      m_drainLock.lock();
+      drain();
+      m_log.tick(QDateTime::currentMSecsSinceEpoch());
+      m_drainLock.unlock();
+
+      m_wakeLock.lock();
+      if (!m_stop.load())
+         m_wake.wait(&m_wakeLock, WakeInterval);
+      m_wakeLock.unlock();
+   }
+}
+
+/**
+ * Formats every linked record, appends it to the log and prints all of them
+ * to the console with a single write. The last consumed record stays in the
+ * queue as its new tail, so producers never touch a record being freed. Must
+ * be called with the drain lock held.
+ */
+void AsyncLogger::drain()
+{
+   m_console.clear();
+
+   Record *next = m_tail->next.load(std::memory_order_acquire);
+   while (next)
+   {
+      QByteArray line = QDateTime::fromMSecsSinceEpoch(next->time).toString("yyyy-MM-dd hh:mm:ss.zzz").toLatin1();
+      line.append(' ');
+      line.append(TypeName(next->type));
+      if (next->category && qstrcmp(next->category, "default") != 0)
+         line.append(" [").append(next->category).append(']');
+      line.append(' ');
+      line.append(next->message.toUtf8());
+      line.append('\n');
+
+      m_log.append(next->time, line);
+      m_console.append(line);
+      next->message = QString();
+
+      if (m_tail != &m_stub)
+         delete m_tail;
+
+      m_tail = next;
+      next = m_tail->next.load(std::memory_order_acquire);
+   }
+
+   if (!m_console.isEmpty())
+   {
+      fwrite(m_console.constData(), 1, m_console.size(), stderr);
+      fflush(stderr);
+   }
+}
+
+/**
+ * Links the given \a record at the head of the queue, this only takes an
+ * atomic exchange and a store
+ */
+void AsyncLogger::push(Record *record)
+{
+   record->next.store(Q_NULLPTR, std::memory_order_relaxed);
+   Record *previous = m_head.exchange(record, std::memory_order_acq_rel);
+   previous->next.store(record, std::memory_order_release);
+}
+
+/**
+ * Quits the application after a termination signal, the queue is written out
+ * when the logger is destroyed
+ */
+void AsyncLogger::onQuitSignal()
+{
+#if defined Q_OS_UNIX
+   char signal;
+   while (read(s_quitPipe[0], &signal, 1) > 0)
+      continue;
+#endif
+
+   qDebug() << "Termination signal received, quitting";
+   QCoreApplication::quit();
+}
+
+/**
+ * Prints a notice before the default action of the crash \a signal is taken.
+ * Formatting, allocating or locking is not safe here (the crash may have
+ * happened inside malloc or the logger), so the queue is not written out.
+ */
+void AsyncLogger::crashHandler(int signal)
+{
+   std::signal(signal, SIG_DFL);
+
+#if defined Q_OS_UNIX
+   const ssize_t written = write(STDERR_FILENO, CRASH_NOTICE, sizeof(CRASH_NOTICE) - 1);
+   Q_UNUSED(written);
+#endif
+
+   std::raise(signal);
+}
+
+/**
+ * Wakes up the event loop through the quit pipe, which only takes a write.
+ * The default action is restored, so a second signal ends the application
+ * even if the event loop is stuck.
+ */
+void AsyncLogger::quitHandler(int signal)
+{
+   std::signal(signal, SIG_DFL);
+
+#if defined Q_OS_UNIX
+   const int error = errno;
+   const char byte = static_cast<char>(signal);
+   const ssize_t written = write(s_quitPipe[1], &byte, 1);
+   Q_UNUSED(written);
+   errno = error;
+#endif
+}
+
+/**
+ * Queues the given message, fatal messages are written out immediately
+ * together with everything queued before them
+ */
+void AsyncLogger::messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+   AsyncLogger *logger = s_instance.load(std::memory_order_acquire);
+   if (!logger)
+      return;
+
+   Record *record = new Record;
+   record->type = type;
+   record->time = QDateTime::currentMSecsSinceEpoch();
+   record->line = context.line;
+   record->file = context.file;
+   record->function = context.function;
+   record->category = context.category;
+   record->message = message;
+   logger->push(record);
+
+   if (type == QtFatalMsg)
+      logger->flush();
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_ASYNC_LOGGER_H
+#define _QDS_ASYNC_LOGGER_H
+
+#include <atomic>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+class QSocketNotifier;
+
+#include "logfile.h"
+
+/**
+ * \brief Writes the application log from a background thread
+ *
+ * Once installed, every \c qDebug() & friends only copies the message into a
+ * record and links it into a lock-free multi-producer queue. The logger
+ * thread wakes up periodically, formats all the queued records in order,
+ * prints them to the console and appends them to the compressed log file, so
+ * formatting and disk writes never happen on the thread that logged the
+ * message.
+ *
+ * The queue is written out synchronously for fatal messages and when the
+ * logger is destroyed. A termination signal (SIGINT or SIGTERM) is forwarded
+ * to the event loop through a pipe and quits the application, so that the
+ * queue is written out by the destructor. The queue cannot be written out
+ * safely from a crash signal, so only a short notice is printed then.
+ */
+class AsyncLogger : public QThread
+{
+   Q_OBJECT
+   Q_PROPERTY(bool enabled READ isEnabled CONSTANT)
+
+public:
+   AsyncLogger();
+   ~AsyncLogger();
+
+   enum
+   {
+      WakeInterval = 20,
+   };
+
+   bool isEnabled() const;
+
+   void install();
+   void flush();
+
+   Q_INVOKABLE void openLogsPath();
+   Q_INVOKABLE void openCurrentLog();
+
+protected:
+   void run() override;
+
+private slots:
+   void onQuitSignal();
+
+private:
+   /**
+    * \brief A queued message, the context strings are the literals passed by
+    *        the logging macros, so only their addresses are stored
+    */
+   struct Record
+   {
+      std::atomic<Record *> next;
+      QtMsgType type;
+      qint64 time;
+      int line;
+      const char *file;
+      const char *function;
+      const char *category;
+      QString message;
+   };
+
+   void drain();
+   void push(Record *record);
+
+   static void crashHandler(int signal);
+   static void quitHandler(int signal);
+   static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message);
+
+private:
+   std::atomic<Record *> m_head;
+   Record *m_tail;
+   Record m_stub;
+
+   bool m_installed;
+   std::atomic<bool> m_stop;
+   QtMessageHandler m_previous;
+
+   LogFile m_log;
+   QByteArray m_console;
+
+   QMutex m_drainLock;
+   QMutex m_wakeLock;
+   QWaitCondition m_wake;
+   QSocketNotifier *m_quitNotifier;
+
+   static int s_quitPipe[2];
+   static std::atomic<AsyncLogger *> s_instance;
+};
+
+#endif
@@ -1,151 +1,440 @@
-/*
- * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#include "beeper.h"
-
-/* Used for generating the sine wave and various operations */
-#include <QtMath>
-#include <QQueue>
-
-/* Used for generating the sounds */
-#include <SDL.h>
-#include <SDL_audio.h>
-
-/**
- * \brief Holds information regarding a beep/wave sound
- */
-struct BeepObject
-{
-   qreal frequency;
-   int samplesLeft;
-};
-
-/* Think of this as the 'volume' of the sound wave */
-const int AMPLITUDE = 16000;
-
-/* Corresponds to the freq. used in phones, we do not need more than that */
-const int SAMPLING_FREQ = 8000;
-
-/* Holds the beep objects to be processed */
-QQueue<BeepObject> BEEPS;
-
-/**
- * Calls the beeper when and generates the audio
- */
-void AUDIO_CALLBACK(void *beeper, quint8 *stream, int length)
-{
-   Beeper *object = static_cast<Beeper *>(beeper);
-   object->generateSamples((qint16 *)stream, length / 2);
-}
-
-/**
- * Configures the audio spec
- */
-Beeper::Beeper()
-{
-   m_angle = 0;
-   m_enabled = false;
-
-   SDL_LockAudio();
-
-   /* Generate the audio configuration */
-   SDL_AudioSpec desiredSpec;
-   desiredSpec.channels = 1;
-   desiredSpec.samples = 1024;
-   desiredSpec.userdata = this;
-   desiredSpec.freq = SAMPLING_FREQ;
-   desiredSpec.format = AUDIO_S16SYS;
-   desiredSpec.callback = AUDIO_CALLBACK;
-
-   /* Open the audio device */
-   SDL_AudioSpec obtainedSpec;
-   SDL_OpenAudio(&desiredSpec, &obtainedSpec);
-
-   /* Forces to initialize the data for the callback function */
-   SDL_PauseAudio(0);
-}
-
-/**
- * Stop using the SDL audio when destroying this class
- */
-Beeper::~Beeper()
-{
-   SDL_CloseAudio();
-   SDL_UnlockAudio();
-}
-
-void Beeper::generateSamples(qint16 *stream, int length)
-{
-   int i = 0;
-   while (i < length)
-   {
-
-      /* Beeps object is empty, ensure that stream has neutral values */
-      if (BEEPS.empty())
-      {
-         for (; i < length; ++i)
-            stream[i] = 0;
-
-         return;
-      }
-
-      /* Get the beep object */
-      BeepObject &beep = BEEPS.front();
-      int samplesToDo = qMin(i + beep.samplesLeft, length);
-      beep.samplesLeft -= samplesToDo - i;
-
-      /* Generate the sound */
-      for (; i < samplesToDo; ++i)
-      {
-         m_angle += beep.frequency;
-         stream[i] = AMPLITUDE * qSin((m_angle * 2 * M_PI) / SAMPLING_FREQ);
-      }
-
-      /* Go to next beep object */
-      if (beep.samplesLeft == 0)
-         BEEPS.pop_front();
-   }
-}
-
-/**
- * Enables or disables the sound output
- */
-void Beeper::setEnabled(bool enabled)
-{
-   m_enabled = enabled;
-}
-
-/**
- * Generates a beep of the given \a frequency & \a duration (in milliseconds).
- * \note The request will be ignored if the beeper is disabled
- */
-void Beeper::beep(qreal frequency, int duration)
-{
-   if (m_enabled)
-   {
-      BeepObject beep_object;
-      beep_object.frequency = frequency;
-      beep_object.samplesLeft = duration * SAMPLING_FREQ / 1000;
-
-      BEEPS.append(beep_object);
-   }
-}
+/*
+ * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "beeper.h"
+
+/* Used for generating the sine table */
+#include <QtMath>
+#include <QDebug>
+#include <string.h>
+
+/* Used for generating the sounds */
+#include <SDL.h>
+#include <SDL_audio.h>
+
+/* Think of this as the 'volume' of the sound wave */
+const int AMPLITUDE = 16000;
+
+/* Used when we cannot know the native sample rate of the audio device */
+const int DEFAULT_SAMPLING_FREQ = 48000;
+
+/* Time without beeps after which the audio device is closed (in ms) */
+const int DEFAULT_IDLE_TIMEOUT = 30000;
+
+/* Default size of the audio buffer (in samples), about 5 ms at 48 kHz */
+const int DEFAULT_BUFFER_SIZE = 256;
+
+/* Number of entries of the sine table, the top bits of the phase are the index */
+const int TABLE_BITS = 10;
+const int TABLE_SIZE = 1 << TABLE_BITS;
+const int PHASE_SHIFT = 32 - TABLE_BITS;
+
+/* Bits of the phase used to interpolate between two entries of the table */
+const int FRACTION_BITS = 15;
+
+/* One period of the sine wave, with an extra entry to interpolate the last one */
+static qint16 WAVETABLE[TABLE_SIZE + 1];
+
+/**
+ * Fills the sine table, this is only done once
+ */
+static void generateWavetable()
+{
+   static bool generated = false;
+   if (generated)
+      return;
+
+   for (int i = 0; i <= TABLE_SIZE; ++i)
+      WAVETABLE[i] = static_cast<qint16>(qRound(AMPLITUDE * qSin(2 * M_PI * i / TABLE_SIZE)));
+
+   generated = true;
+}
+
+/**
+ * Returns the sample rate used by the default audio output device
+ */
+static int nativeSampleRate()
+{
+#if SDL_VERSION_ATLEAST(2, 24, 0)
+   SDL_AudioSpec spec;
+   if (SDL_GetDefaultAudioInfo(Q_NULLPTR, &spec, 0) == 0 && spec.freq > 0)
+      return spec.freq;
+#endif
+
+   return DEFAULT_SAMPLING_FREQ;
+}
+
+/**
+ * Calls the beeper when and generates the audio
+ */
+void AUDIO_CALLBACK(void *beeper, quint8 *stream, int length)
+{
+   Beeper *object = static_cast<Beeper *>(beeper);
+   object->generateSamples((qint16 *)stream, length / 2);
+}
+
+/**
+ * Prepares the beeper, the audio device may only be opened after \c start()
+ * is called. The device is never opened if \a useDevice is \c false (which
+ * is used by the benchmarks to call \c generateSamples() directly).
+ */
+Beeper::Beeper(const bool useDevice)
+{
+   m_device = 0;
+   m_phase = 0;
+   m_latency = 0;
+   m_increment = 0;
+   m_samplesLeft = 0;
+   m_enabled = false;
+   m_started = false;
+   m_useDevice = useDevice;
+   m_idleTimeout = DEFAULT_IDLE_TIMEOUT;
+   m_initializedAudio = false;
+   m_sampleRate = DEFAULT_SAMPLING_FREQ;
+   m_bufferSize = DEFAULT_BUFFER_SIZE;
+   m_deviceBufferSize = DEFAULT_BUFFER_SIZE;
+
+   generateWavetable();
+
+   if (!useDevice)
+      return;
+
+   /* Update the measured latency every second while the device is open */
+   m_latencyTimer.setInterval(1000);
+   connect(&m_latencyTimer, SIGNAL(timeout()), this, SLOT(updateLatency()));
+
+   /* Close the device when no beeps are played for a while */
+   m_idleTimer.setSingleShot(true);
+   m_idleTimer.setTimerType(Qt::CoarseTimer);
+   connect(&m_idleTimer, SIGNAL(timeout()), this, SLOT(closeIdleDevice()));
+}
+
+/**
+ * Stop using the SDL audio when destroying this class
+ */
+Beeper::~Beeper()
+{
+   closeDevice();
+
+   if (m_initializedAudio)
+      SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+/**
+ * Returns the size of the audio buffer (in samples) used by the device, or
+ * the size that will be requested while the device is closed
+ */
+int Beeper::bufferSize() const
+{
+   return m_device ? m_deviceBufferSize : m_bufferSize;
+}
+
+/**
+ * Returns the sample rate (in Hz) used to generate the tones
+ */
+int Beeper::sampleRate() const
+{
+   return m_sampleRate;
+}
+
+/**
+ * Returns the output latency (in milliseconds), which is the median time
+ * between a beep request and the moment in which the audio thread starts to
+ * generate it, plus the duration of the device buffer.
+ */
+qreal Beeper::latency() const
+{
+   return m_latency;
+}
+
+/**
+ * Fills the given \a stream with \a length samples of the queued beeps, or
+ * with silence when there are no beeps left.
+ *
+ * \note This function is called from the SDL audio thread, it must not lock,
+ *       allocate memory or call slow functions.
+ */
+void Beeper::generateSamples(qint16 *stream, int length)
+{
+   int i = 0;
+   while (i < length)
+   {
+      /* Get the next beep object */
+      if (m_samplesLeft <= 0)
+      {
+         BeepObject beep;
+
+         /* Beeps object is empty, ensure that stream has neutral values */
+         if (!m_beeps.pop(beep))
+         {
+            memset(stream + i, 0, (length - i) * sizeof(qint16));
+            return;
+         }
+
+         /* Convert the beep to the sample rate of the device */
+         m_increment = static_cast<quint32>(beep.frequency * 4294967296.0 / m_sampleRate);
+         m_samplesLeft = static_cast<int>(static_cast<qint64>(beep.duration) * m_sampleRate / 1000);
+         m_queueDelay.record(LatencyHistogram::timestamp() - beep.queued);
+         continue;
+      }
+
+      /* Get the samples to generate for this beep */
+      const int samplesToDo = qMin(i + m_samplesLeft, length);
+      m_samplesLeft -= samplesToDo - i;
+
+      /* Generate the sound, interpolating between two entries of the table */
+      quint32 phase = m_phase;
+      const quint32 increment = m_increment;
+      for (; i < samplesToDo; ++i)
+      {
+         const quint32 index = phase >> PHASE_SHIFT;
+         const qint32 fraction = (phase >> (PHASE_SHIFT - FRACTION_BITS)) & ((1 << FRACTION_BITS) - 1);
+         const qint32 a = WAVETABLE[index];
+         const qint32 b = WAVETABLE[index + 1];
+
+         stream[i] = static_cast<qint16>(a + (((b - a) * fraction) >> FRACTION_BITS));
+         phase += increment;
+      }
+
+      m_phase = phase;
+   }
+}
+
+/**
+ * Called once SDL audio can be used by this thread. The device is opened if
+ * the sounds are enabled, the beeps requested before this call are played
+ * once the device is open.
+ */
+void Beeper::start()
+{
+   m_started = true;
+   if (m_enabled)
+      useDevice(0);
+}
+
+/**
+ * Enables or disables the sound output, the audio device is opened ahead of
+ * the first beep when enabled and closed right away when disabled (the beeps
+ * waiting to be played are discarded)
+ */
+void Beeper::setEnabled(bool enabled)
+{
+   m_enabled = enabled;
+
+   if (m_enabled)
+      useDevice(0);
+   else
+   {
+      m_idleTimer.stop();
+      closeDevice();
+
+      /* The audio callback is stopped, drop the beeps that were not played */
+      BeepObject beep;
+      while (m_beeps.pop(beep))
+         continue;
+   }
+}
+
+/**
+ * Returns the time without beeps after which the audio device is closed (in
+ * milliseconds), 0 if the device is never closed
+ */
+int Beeper::idleTimeout() const
+{
+   return m_idleTimeout;
+}
+
+/**
+ * Changes the time without beeps after which the audio device is closed,
+ * a value of 0 keeps the device open while the sounds are enabled
+ */
+void Beeper::setIdleTimeout(const int milliseconds)
+{
+   const int timeout = qMax(0, milliseconds);
+   if (timeout == m_idleTimeout)
+      return;
+
+   m_idleTimeout = timeout;
+   if (m_idleTimeout == 0)
+      m_idleTimer.stop();
+   else if (m_device)
+      m_idleTimer.start(m_idleTimeout);
+
+   emit idleTimeoutChanged();
+}
+
+/**
+ * Re-opens the audio device with a buffer of the given number of \a samples.
+ * Smaller buffers reduce the latency, but may cause audio glitches on slow
+ * or busy computers.
+ */
+void Beeper::setBufferSize(const int samples)
+{
+   if (samples <= 0 || samples == m_bufferSize)
+      return;
+
+   m_bufferSize = samples;
+   if (m_device)
+   {
+      closeDevice();
+      openDevice();
+   }
+
+   else
+      emit deviceChanged();
+}
+
+/**
+ * Generates a beep of the given \a frequency & \a duration (in milliseconds).
+ * \note The request will be ignored if the beeper is disabled or if there are
+ *       too many beeps waiting to be played
+ */
+void Beeper::beep(qreal frequency, int duration)
+{
+   if (m_enabled)
+   {
+      BeepObject beep_object;
+      beep_object.duration = duration;
+      beep_object.frequency = frequency;
+      beep_object.queued = LatencyHistogram::timestamp();
+
+      m_beeps.push(beep_object);
+      useDevice(duration);
+   }
+}
+
+/**
+ * Updates the output latency with the queue delays measured by the audio
+ * thread, the signal is only emitted if the value changed.
+ */
+void Beeper::updateLatency()
+{
+   if (m_queueDelay.count() == 0 || m_sampleRate <= 0)
+      return;
+
+   const qreal queue = m_queueDelay.percentile(50) / 1e6;
+   const qreal buffer = m_deviceBufferSize * 1000.0 / m_sampleRate;
+   const qreal latency = qRound((queue + buffer) * 10) / 10.0;
+
+   if (!qFuzzyCompare(latency, m_latency))
+   {
+      m_latency = latency;
+      emit latencyChanged();
+   }
+}
+
+/**
+ * Closes the audio device after the idle timeout, unless a beep is still
+ * waiting to be played
+ */
+void Beeper::closeIdleDevice()
+{
+   if (!m_beeps.isEmpty())
+   {
+      m_idleTimer.start(m_idleTimeout);
+      return;
+   }
+
+   closeDevice();
+}
+
+/**
+ * Opens the audio device if needed and keeps it open for the idle timeout
+ * after a beep of the given \a duration (in milliseconds)
+ */
+void Beeper::useDevice(const int duration)
+{
+   if (!m_useDevice || !m_started)
+      return;
+
+   if (!m_device && !openDevice())
+      return;
+
+   if (m_idleTimeout > 0)
+      m_idleTimer.start(m_idleTimeout + qMax(0, duration));
+}
+
+/**
+ * Opens the default audio output device at its native sample rate, so that
+ * SDL does not need to resample our tones, with the selected buffer size.
+ */
+bool Beeper::openDevice()
+{
+   /* Initialize the audio subsystem if needed */
+   if (!SDL_WasInit(SDL_INIT_AUDIO))
+   {
+      if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0)
+      {
+         qWarning() << "Cannot initialize SDL audio:" << SDL_GetError();
+         return false;
+      }
+
+      m_initializedAudio = true;
+   }
+
+   /* Generate the audio configuration */
+   SDL_AudioSpec desiredSpec;
+   SDL_zero(desiredSpec);
+   desiredSpec.channels = 1;
+   desiredSpec.userdata = this;
+   desiredSpec.format = AUDIO_S16SYS;
+   desiredSpec.freq = nativeSampleRate();
+   desiredSpec.callback = AUDIO_CALLBACK;
+   desiredSpec.samples = static_cast<Uint16>(m_bufferSize);
+
+   /* Open the audio device, let the device choose its rate & buffer size */
+   SDL_AudioSpec obtainedSpec;
+   const int changes = SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_SAMPLES_CHANGE;
+   m_device = SDL_OpenAudioDevice(Q_NULLPTR, 0, &desiredSpec, &obtainedSpec, changes);
+   if (m_device == 0)
+   {
+      qWarning() << "Cannot open audio device:" << SDL_GetError();
+      return false;
+   }
+
+   /* Generate the samples at the rate used by the device */
+   m_sampleRate = obtainedSpec.freq;
+   m_deviceBufferSize = obtainedSpec.samples;
+   m_queueDelay.reset();
+   emit deviceChanged();
+
+   /* Start calling the audio callback */
+   SDL_PauseAudioDevice(m_device, 0);
+   m_latencyTimer.start();
+   return true;
+}
+
+/**
+ * Closes the audio device, SDL waits for the audio thread to finish
+ */
+void Beeper::closeDevice()
+{
+   if (m_device)
+   {
+      SDL_CloseAudioDevice(m_device);
+      m_latencyTimer.stop();
+      m_samplesLeft = 0;
+      m_device = 0;
+
+      emit deviceChanged();
+   }
+}
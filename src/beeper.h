@@ -1,33 +1,105 @@
-/*
- * This code is based on the answer provided at:
- * http://stackoverflow.com/questions/10110905/simple-wave-generator-with-sdl-in-c
- */
-
-#ifndef _QDS_BEEPER_H
-#define _QDS_BEEPER_H
-
-#include <QObject>
-
-/**
- * \brief Uses SDL to generate telephone-like sound tones on the fly
- */
-class Beeper : public QObject
-{
-   Q_OBJECT
-
-public:
-   explicit Beeper();
-   ~Beeper();
-
-   void generateSamples(qint16 *stream, int length);
-
-public slots:
-   void setEnabled(bool enabled);
-   void beep(qreal frequency, int duration);
-
-private:
-   bool m_enabled;
-   double m_angle;
-};
-
-#endif
+/*
+ * This code is based on the answer provided at:
+ * http://stackoverflow.com/questions/10110905/simple-wave-generator-with-sdl-in-c
+ */
+
+#ifndef _QDS_BEEPER_H
+#define _QDS_BEEPER_H
+
+#include <QTimer>
+#include <QObject>
+
+#include "latency.h"
+#include "ringbuffer.h"
+
+/**
+ * \brief Holds information regarding a beep/wave sound
+ */
+struct BeepObject
+{
+   qreal frequency;
+   int duration;
+   qint64 queued;
+};
+
+/**
+ * \brief Uses SDL to generate telephone-like sound tones on the fly
+ *
+ * Beeps are requested from the GUI thread and generated from the SDL audio
+ * thread, they are passed between both threads with a lock-free ring. The
+ * tones are generated with a phase accumulator that reads a pre-computed
+ * sine table, so the audio callback does not call any math function.
+ *
+ * The audio device is opened at its native sample rate with a small buffer,
+ * so that SDL does not need to resample the tones and alerts are played as
+ * soon as possible. The device is only opened when the sounds are enabled or
+ * a beep is requested, and it is closed again after \c idleTimeout
+ * milliseconds without beeps, so no audio callback runs while the DS is
+ * silent. The time between a beep request and the moment in which
+ * the audio thread starts generating it is measured, and added to the
+ * duration of the device buffer to report the output latency.
+ */
+class Beeper : public QObject
+{
+   Q_OBJECT
+   Q_PROPERTY(int bufferSize READ bufferSize WRITE setBufferSize NOTIFY deviceChanged)
+   Q_PROPERTY(int sampleRate READ sampleRate NOTIFY deviceChanged)
+   Q_PROPERTY(qreal latency READ latency NOTIFY latencyChanged)
+   Q_PROPERTY(int idleTimeout READ idleTimeout WRITE setIdleTimeout NOTIFY idleTimeoutChanged)
+
+signals:
+   void deviceChanged();
+   void latencyChanged();
+   void idleTimeoutChanged();
+
+public:
+   explicit Beeper(const bool useDevice = true);
+   ~Beeper();
+
+   int bufferSize() const;
+   int sampleRate() const;
+   qreal latency() const;
+   int idleTimeout() const;
+
+   void generateSamples(qint16 *stream, int length);
+
+public slots:
+   void start();
+   void setEnabled(bool enabled);
+   void setBufferSize(const int samples);
+   void setIdleTimeout(const int milliseconds);
+   void beep(qreal frequency, int duration);
+
+private slots:
+   void updateLatency();
+   void closeIdleDevice();
+
+private:
+   bool openDevice();
+   void closeDevice();
+   void useDevice(const int duration);
+
+private:
+   bool m_enabled;
+   bool m_started;
+   bool m_useDevice;
+   bool m_initializedAudio;
+
+   quint32 m_device;
+   int m_sampleRate;
+   int m_bufferSize;
+   int m_deviceBufferSize;
+
+   quint32 m_phase;
+   quint32 m_increment;
+   int m_samplesLeft;
+
+   qreal m_latency;
+   int m_idleTimeout;
+   QTimer m_idleTimer;
+   QTimer m_latencyTimer;
+   LatencyHistogram m_queueDelay;
+   RingBuffer<BeepObject, 64> m_beeps;
+};
+
+#endif
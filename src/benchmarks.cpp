@@ -0,0 +1,651 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "beeper.h"
+#include "asynclogger.h"
+#include "benchmarks.h"
+#include "joysticks.h"
+#include "statepublisher.h"
+
+#include <QtQml>
+#include <QtMath>
+#include <QHash>
+#include <QVector>
+#include <QTimer>
+#include <QThread>
+#include <QEventLoop>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+
+#include <stdio.h>
+#include <algorithm>
+
+#include <QJoysticks.h>
+#include <EventLogger.h>
+#include <DriverStation.h>
+
+//------------------------------------------------------------------------------
+// Common helpers
+//------------------------------------------------------------------------------
+
+/* Number of events generated by each input benchmark */
+static const int INPUT_EVENTS = 20000;
+
+/* Number of events sent before we start measuring */
+static const int INPUT_WARMUP = 1000;
+
+/* Number of events generated between two control packets */
+static const int INPUT_EVENTS_PER_PACKET = 16;
+
+/* Latency run: bursts of events (like an SDL poll) & the time between them */
+static const int INPUT_BURSTS = 500;
+static const int INPUT_BURST_SIZE = 4;
+static const int INPUT_BURST_INTERVAL = 5;
+
+/* Every few bursts, pause long enough for the latch timer to stop */
+static const int INPUT_IDLE_EVERY = 20;
+static const int INPUT_IDLE_PAUSE = 100;
+
+/* The QML code that forwarded joystick input to the DS before the C++ bridge */
+static const char *QML_INPUT_PATH = "import QtQuick 2.0                                        \n"
+                                    "Item {                                                    \n"
+                                    "    Connections {                                         \n"
+                                    "        target: QJoysticks                                \n"
+                                    "        function onPovChanged(js, pov, angle) {           \n"
+                                    "            var val = QJoysticks.isBlacklisted (js) ? 0 : angle\n"
+                                    "            CppDS.setJoystickHat (js, pov, val)           \n"
+                                    "        }                                                 \n"
+                                    "        function onAxisChanged(js, axis, value) {         \n"
+                                    "            var val = QJoysticks.isBlacklisted (js) ? 0 : value\n"
+                                    "            CppDS.setJoystickAxis (js, axis, val)         \n"
+                                    "        }                                                 \n"
+                                    "        function onButtonChanged(js, button, pressed) {   \n"
+                                    "            var val = QJoysticks.isBlacklisted (js) ? false : pressed\n"
+                                    "            CppDS.setJoystickButton (js, button, val)     \n"
+                                    "        }                                                 \n"
+                                    "    }                                                     \n"
+                                    "}                                                         \n";
+
+/**
+ * \brief Summary of a set of timing samples (in nanoseconds)
+ */
+struct Statistics
+{
+   qint64 p50;
+   qint64 p99;
+   qint64 max;
+   double mean;
+};
+
+/**
+ * Sorts the given \a samples and obtains their mean, median, p99 & maximum
+ */
+static Statistics getStatistics(QVector<qint64> samples)
+{
+   Statistics stats = { 0, 0, 0, 0 };
+   if (samples.isEmpty())
+      return stats;
+
+   double sum = 0;
+   std::sort(samples.begin(), samples.end());
+   for (int i = 0; i < samples.count(); ++i)
+      sum += samples.at(i);
+
+   stats.mean = sum / samples.count();
+   stats.max = samples.last();
+   stats.p50 = samples.at(samples.count() / 2);
+   stats.p99 = samples.at(qMin(samples.count() - 1, samples.count() * 99 / 100));
+   return stats;
+}
+
+/**
+ * Prints a row of the results table, values are converted to microseconds
+ */
+static void printStatistics(const char *name, const Statistics &cost, const Statistics &latency)
+{
+   printf("%-14s %10.2f %10.2f %10.2f %10.2f %10.2f\n", name, cost.mean / 1000, latency.mean / 1000,
+          latency.p50 / 1000.0, latency.p99 / 1000.0, latency.max / 1000.0);
+}
+
+//------------------------------------------------------------------------------
+// Joystick input benchmark
+//------------------------------------------------------------------------------
+
+/**
+ * Generates the i-th synthetic input event: mostly axis changes (as generated
+ * by a stick sweep), with a button and a POV change every few events.
+ */
+static void emitInputEvent(QJoysticks *joysticks, const int i, const int axes)
+{
+   if (i % 8 == 6)
+      emit joysticks->buttonChanged(0, 0, (i / 8) % 2);
+   else if (i % 8 == 7)
+      emit joysticks->povChanged(0, 0, ((i / 8) % 8) * 45);
+   else
+      emit joysticks->axisChanged(0, i % axes, (i % 200) / 100.0 - 1);
+}
+
+/**
+ * Sends synthetic events through the currently connected input path as fast
+ * as possible, the \a cost vector is filled with the time needed to dispatch
+ * each event to all of its receivers.
+ */
+static void measureInputCost(QJoysticks *joysticks, QVector<qint64> &cost)
+{
+   QElapsedTimer clock;
+   const int axes = qMax(1, joysticks->getNumAxes(0));
+
+   for (int i = 0; i < INPUT_WARMUP; ++i)
+      emitInputEvent(joysticks, i, axes);
+
+   cost.clear();
+   cost.reserve(INPUT_EVENTS);
+
+   clock.start();
+   for (int i = 0; i < INPUT_EVENTS; ++i)
+   {
+      const qint64 start = clock.nsecsElapsed();
+      emitInputEvent(joysticks, i, axes);
+      cost.append(clock.nsecsElapsed() - start);
+   }
+}
+
+/**
+ * Sends synthetic events through the currently connected input path in short
+ * bursts, with pauses that let the latch timer stop, while the event loop
+ * runs between the bursts.
+ *
+ * The \a latency vector is filled with the time elapsed between the emission
+ * of each event and the moment in which its value was handed to the DS: right
+ * after the QML handlers when \a bridge is \c nullptr, or when the \a bridge
+ * latches the joystick state blocks (including the wait for the latch timer).
+ */
+static void measureInputLatency(QJoysticks *joysticks, Joysticks *bridge, QVector<qint64> &latency)
+{
+   QElapsedTimer clock;
+   QVector<qint64> pending;
+   const int axes = qMax(1, joysticks->getNumAxes(0));
+
+   /* Connected after the input path, so it runs once the DS has the values */
+   QObject probe;
+   auto delivered = [&]() {
+      const qint64 now = clock.nsecsElapsed();
+      foreach (const qint64 start, pending)
+         latency.append(now - start);
+
+      pending.clear();
+   };
+
+   if (bridge)
+      QObject::connect(bridge, &Joysticks::inputLatched, &probe, delivered);
+   else
+   {
+      QObject::connect(joysticks, &QJoysticks::povChanged, &probe, delivered);
+      QObject::connect(joysticks, &QJoysticks::axisChanged, &probe, delivered);
+      QObject::connect(joysticks, &QJoysticks::buttonChanged, &probe, delivered);
+   }
+
+   latency.clear();
+   latency.reserve(INPUT_BURSTS * INPUT_BURST_SIZE);
+
+   int event = 0;
+   QEventLoop loop;
+   clock.start();
+   for (int burst = 0; burst < INPUT_BURSTS; ++burst)
+   {
+      for (int i = 0; i < INPUT_BURST_SIZE; ++i)
+      {
+         pending.append(clock.nsecsElapsed());
+         emitInputEvent(joysticks, event++, axes);
+      }
+
+      const bool idle = (burst % INPUT_IDLE_EVERY) == INPUT_IDLE_EVERY - 1;
+      QTimer::singleShot(idle ? INPUT_IDLE_PAUSE : INPUT_BURST_INTERVAL, Qt::PreciseTimer, &loop, SLOT(quit()));
+      loop.exec();
+   }
+}
+
+/**
+ * Compares the per-event cost and the input-to-DS latency of the old QML
+ * joystick forwarding code against the C++ joystick bridge. Both latencies
+ * are measured until the value is handed to the DS.
+ */
+int benchmarkInput()
+{
+   QJoysticks *qjoysticks = QJoysticks::getInstance();
+   DriverStation *driverstation = DriverStation::getInstance();
+   driverstation->start();
+
+   /* Use the virtual joystick, so that we do not depend on the hardware */
+   Joysticks joysticks;
+   qjoysticks->setVirtualJoystickEnabled(true);
+   QCoreApplication::processEvents();
+   joysticks.registerJoysticks();
+
+   if (qjoysticks->count() < 1)
+   {
+      printf("No joysticks available, cannot run input benchmark\n");
+      return EXIT_FAILURE;
+   }
+
+   QVector<qint64> cost;
+   QVector<qint64> latency;
+
+   printf("Input path benchmark (cost of %d events, input-to-DS latency of %d events in bursts, "
+          "times in microseconds)\n\n",
+          INPUT_EVENTS, INPUT_BURSTS * INPUT_BURST_SIZE);
+   printf("%-14s %10s %10s %10s %10s %10s\n", "Path", "Cost", "Latency", "p50", "p99", "Max");
+
+   /* Measure the QML path */
+   {
+      joysticks.setConnected(false);
+
+      QQmlEngine engine;
+      engine.rootContext()->setContextProperty("CppDS", driverstation);
+      engine.rootContext()->setContextProperty("QJoysticks", qjoysticks);
+
+      QQmlComponent component(&engine);
+      component.setData(QML_INPUT_PATH, QUrl());
+      QScopedPointer<QObject> item(component.create());
+      if (item.isNull())
+      {
+         printf("Cannot create QML input path: %s\n", qPrintable(component.errorString()));
+         return EXIT_FAILURE;
+      }
+
+      measureInputCost(qjoysticks, cost);
+      measureInputLatency(qjoysticks, Q_NULLPTR, latency);
+      printStatistics("QML", getStatistics(cost), getStatistics(latency));
+   }
+
+   /* Measure the C++ path */
+   {
+      joysticks.setConnected(true);
+      measureInputCost(qjoysticks, cost);
+      measureInputLatency(qjoysticks, &joysticks, latency);
+      printStatistics("C++", getStatistics(cost), getStatistics(latency));
+   }
+
+   /* Measure the cost of sending the joystick state blocks to the DS */
+   {
+      QElapsedTimer clock;
+      QVector<qint64> latches;
+      const int axes = qMax(1, qjoysticks->getNumAxes(0));
+      const int packets = INPUT_EVENTS / INPUT_EVENTS_PER_PACKET;
+
+      clock.start();
+      latches.reserve(packets);
+      for (int i = 0; i < packets; ++i)
+      {
+         for (int j = 0; j < INPUT_EVENTS_PER_PACKET; ++j)
+            emitInputEvent(qjoysticks, i * INPUT_EVENTS_PER_PACKET + j, axes);
+
+         const qint64 start = clock.nsecsElapsed();
+         joysticks.latch();
+         latches.append(clock.nsecsElapsed() - start);
+      }
+
+      const Statistics stats = getStatistics(latches);
+      printf("\nC++ state block sent to the DS once per packet (%d events per packet)\n", INPUT_EVENTS_PER_PACKET);
+      printf("%-14s %10.2f %10s %10.2f %10.2f %10.2f\n", "C++ latch", stats.mean / 1000, "-", stats.p50 / 1000.0,
+             stats.p99 / 1000.0, stats.max / 1000.0);
+   }
+
+   return EXIT_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+// Audio synthesis benchmark
+//------------------------------------------------------------------------------
+
+/* Number of audio buffers generated for each buffer size */
+static const int AUDIO_BUFFERS = 2000;
+
+/* Buffer sizes (in samples) requested by the audio device */
+static const int AUDIO_BUFFER_SIZES[] = { 64, 128, 256, 512, 1024, 2048 };
+
+/**
+ * Generates a 440 Hz tone with a call to \c qSin() for every sample, like the
+ * beeper did before using the sine table. Used as a reference.
+ */
+static void generateReferenceSamples(qint16 *stream, int length, double &angle)
+{
+   for (int i = 0; i < length; ++i)
+   {
+      angle += 440;
+      stream[i] = 16000 * qSin((angle * 2 * M_PI) / 8000);
+   }
+}
+
+/**
+ * Measures the time needed by the beeper to fill audio buffers of different
+ * sizes, compared with the old per-sample \c qSin() oscillator.
+ */
+int benchmarkAudio()
+{
+   Beeper beeper(false);
+   beeper.setEnabled(true);
+
+   QElapsedTimer clock;
+   QVector<qint64> table;
+   QVector<qint64> reference;
+   QVector<qint16> stream(2048);
+
+   printf("Audio synthesis benchmark (%d buffers per size, times in microseconds)\n\n", AUDIO_BUFFERS);
+   printf("%-8s %10s %10s %10s %10s %12s %12s\n", "Samples", "Mean", "p50", "p99", "Max", "ns/sample", "qSin ns/s.");
+
+   clock.start();
+   for (const int size : AUDIO_BUFFER_SIZES)
+   {
+      double angle = 0;
+      table.clear();
+      reference.clear();
+
+      for (int i = 0; i < AUDIO_BUFFERS; ++i)
+      {
+         /* Keep a beep queued, so that we never measure silence */
+         beeper.beep(440, 1000);
+
+         qint64 start = clock.nsecsElapsed();
+         beeper.generateSamples(stream.data(), size);
+         table.append(clock.nsecsElapsed() - start);
+
+         start = clock.nsecsElapsed();
+         generateReferenceSamples(stream.data(), size, angle);
+         reference.append(clock.nsecsElapsed() - start);
+      }
+
+      const Statistics stats = getStatistics(table);
+      const Statistics ref = getStatistics(reference);
+      printf("%-8d %10.2f %10.2f %10.2f %10.2f %12.2f %12.2f\n", size, stats.mean / 1000, stats.p50 / 1000.0,
+             stats.p99 / 1000.0, stats.max / 1000.0, stats.mean / size, ref.mean / size);
+   }
+
+   return EXIT_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+// Logging benchmark
+//------------------------------------------------------------------------------
+
+/* Number of messages logged with each handler */
+static const int LOG_MESSAGES = 20000;
+
+/**
+ * Logs a series of messages similar to the ones of the application and
+ * fills \a cost with the time spent by the caller in each \c qDebug()
+ */
+static void measureLogging(QVector<qint64> &cost)
+{
+   QElapsedTimer clock;
+   cost.clear();
+   cost.reserve(LOG_MESSAGES);
+
+   clock.start();
+   for (int i = 0; i < LOG_MESSAGES; ++i)
+   {
+      const qint64 start = clock.nsecsElapsed();
+      qDebug() << "Logging benchmark message" << i << "of" << LOG_MESSAGES;
+      cost.append(clock.nsecsElapsed() - start);
+   }
+}
+
+/**
+ * Compares the time spent by the thread that logs a message with the LibDS
+ * event logger installed directly and with the asynchronous logger. The LibDS
+ * handler writes the messages to its text log, and the asynchronous logger
+ * writes them to the compressed log.
+ */
+int benchmarkLogging()
+{
+   QVector<qint64> cost;
+   QtMessageHandler handler = DSEventLogger::getInstance()->messageHandler;
+
+   /* Measure the LibDS handler, called by the thread that logs */
+   qInstallMessageHandler(handler);
+   measureLogging(cost);
+   const Statistics sync = getStatistics(cost);
+
+   /* Measure the async logger, and how long it takes to write everything */
+   qint64 drain = 0;
+   Statistics async;
+   {
+      AsyncLogger logger;
+      logger.install();
+      measureLogging(cost);
+
+      QElapsedTimer clock;
+      clock.start();
+      logger.flush();
+      drain = clock.nsecsElapsed();
+      async = getStatistics(cost);
+   }
+
+   printf("\nLogging benchmark (%d messages, caller time in microseconds)\n\n", LOG_MESSAGES);
+   printf("%-14s %10s %10s %10s %10s\n", "Handler", "Mean", "p50", "p99", "Max");
+   printf("%-14s %10.2f %10.2f %10.2f %10.2f\n", "LibDS", sync.mean / 1000, sync.p50 / 1000.0, sync.p99 / 1000.0,
+          sync.max / 1000.0);
+   printf("%-14s %10.2f %10.2f %10.2f %10.2f\n", "Async", async.mean / 1000, async.p50 / 1000.0,
+          async.p99 / 1000.0, async.max / 1000.0);
+   printf("\nAsync queue written out %.2f ms after the last message\n", drain / 1000000.0);
+
+   return EXIT_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+// Startup benchmark
+//------------------------------------------------------------------------------
+
+/* Default number of cold starts */
+static const int STARTUP_RUNS = 10;
+
+/* Maximum time that a started application may need to show its first frame */
+static const int STARTUP_TIMEOUT = 60000;
+
+/**
+ * Starts the application \a runs times in new processes. Each process reports
+ * the duration of its startup phases once the main window shows its first
+ * frame, and quits. The distribution of each phase is printed in
+ * milliseconds.
+ */
+int benchmarkStartup(int runs)
+{
+   if (runs <= 0)
+      runs = STARTUP_RUNS;
+
+   QStringList order;
+   QVector<qint64> wall;
+   QHash<QString, QVector<qint64>> phases;
+
+   for (int i = 0; i < runs; ++i)
+   {
+      QElapsedTimer clock;
+      QProcess process;
+
+      clock.start();
+      process.start(QCoreApplication::applicationFilePath(), QStringList("--startup-report"));
+      if (!process.waitForFinished(STARTUP_TIMEOUT) || process.exitCode() != EXIT_SUCCESS)
+      {
+         printf("Run %d did not finish, aborting\n", i + 1);
+         process.kill();
+         return EXIT_FAILURE;
+      }
+
+      wall.append(clock.nsecsElapsed());
+
+      const QList<QByteArray> lines = process.readAllStandardOutput().split('\n');
+      foreach (const QByteArray &line, lines)
+      {
+         const QList<QByteArray> fields = line.trimmed().split('\t');
+         if (fields.count() != 3 || fields.at(0) != "STARTUP")
+            continue;
+
+         const QString name = QString::fromUtf8(fields.at(1));
+         if (!order.contains(name))
+            order.append(name);
+
+         phases[name].append(fields.at(2).toLongLong());
+      }
+
+      printf("Run %d of %d done\n", i + 1, runs);
+   }
+
+   printf("\nStartup benchmark (%d cold starts, times in milliseconds)\n\n", runs);
+   printf("%-34s %10s %10s %10s %10s\n", "Phase", "Mean", "p50", "p99", "Max");
+   foreach (const QString &name, order)
+   {
+      const Statistics stats = getStatistics(phases.value(name));
+      printf("%-34s %10.2f %10.2f %10.2f %10.2f\n", qPrintable(name), stats.mean / 1000000, stats.p50 / 1000000.0,
+             stats.p99 / 1000000.0, stats.max / 1000000.0);
+   }
+
+   const Statistics stats = getStatistics(wall);
+   printf("%-34s %10.2f %10.2f %10.2f %10.2f\n", "Process (until exit)", stats.mean / 1000000,
+          stats.p50 / 1000000.0, stats.p99 / 1000000.0, stats.max / 1000000.0);
+
+   return EXIT_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+// Shared memory benchmark
+//------------------------------------------------------------------------------
+
+/* Number of updates written by each shared memory measurement */
+static const int SHM_UPDATES = 100000;
+
+/* Segment used by the benchmark, so that a running DS is not affected */
+#ifdef Q_OS_WIN
+static const char *SHM_BENCHMARK_NAME = "Local\\qdriverstation-benchmark";
+#else
+static const char *SHM_BENCHMARK_NAME = "/qdriverstation-benchmark";
+#endif
+
+/**
+ * Prints a row of the shared memory results, values are in nanoseconds
+ */
+static void printSharedMemoryStatistics(const char *name, const Statistics &stats)
+{
+   printf("%-18s %10.1f %10lld %10lld %10lld\n", name, stats.mean, stats.p50, stats.p99, stats.max);
+}
+
+/**
+ * Measures the time spent by the DS thread to publish its state in the
+ * shared memory segment, after each joystick latch and after each status
+ * change. Then, a reader thread takes snapshots while the DS thread writes
+ * as fast as it can, to measure both sides under contention and to verify
+ * that every snapshot is consistent.
+ */
+int benchmarkSharedMemory()
+{
+   DriverStation *driverstation = DriverStation::getInstance();
+   Joysticks joysticks;
+
+   StatePublisher publisher(driverstation, &joysticks);
+   if (!publisher.open(SHM_BENCHMARK_NAME))
+   {
+      printf("Cannot create the shared memory segment\n");
+      return EXIT_FAILURE;
+   }
+
+   QElapsedTimer clock;
+   QVector<qint64> cost;
+   cost.reserve(SHM_UPDATES);
+   clock.start();
+
+   /* Cost of each update on the DS thread, without readers */
+   for (int i = 0; i < SHM_UPDATES; ++i)
+   {
+      const qint64 start = clock.nsecsElapsed();
+      publisher.updateJoysticks();
+      cost.append(clock.nsecsElapsed() - start);
+   }
+   const Statistics latch = getStatistics(cost);
+
+   cost.clear();
+   for (int i = 0; i < SHM_UPDATES; ++i)
+   {
+      const qint64 start = clock.nsecsElapsed();
+      publisher.updateStatus();
+      cost.append(clock.nsecsElapsed() - start);
+   }
+   const Statistics status = getStatistics(cost);
+
+   /* Every field of the written states is derived from the update number */
+   QScopedPointer<QDSSharedSegment> segment(new QDSSharedSegment());
+   QDSSharedStatus written;
+   memset(&written, 0, sizeof(written));
+
+   QAtomicInt stop(0);
+   quint64 torn = 0;
+   quint64 failed = 0;
+   QVector<qint64> reads;
+   reads.reserve(SHM_UPDATES);
+   QThread *reader = QThread::create([&]() {
+      QElapsedTimer timer;
+      QDSSharedStatus snapshot;
+      timer.start();
+      while (!stop.loadAcquire() && reads.count() < SHM_UPDATES)
+      {
+         const qint64 start = timer.nsecsElapsed();
+         const bool ok = segment->read(snapshot, 4);
+         reads.append(timer.nsecsElapsed() - start);
+
+         if (!ok)
+            ++failed;
+         else if (snapshot.joysticks[QDS_SHARED_JOYSTICKS - 1].buttons != static_cast<quint32>(snapshot.updates)
+                  || snapshot.timestamp != static_cast<qint64>(snapshot.updates))
+            ++torn;
+      }
+   });
+
+   cost.clear();
+   reader->start();
+   for (int i = 0; i < SHM_UPDATES; ++i)
+   {
+      ++written.updates;
+      written.timestamp = static_cast<qint64>(written.updates);
+      for (int js = 0; js < QDS_SHARED_JOYSTICKS; ++js)
+         written.joysticks[js].buttons = static_cast<quint32>(written.updates);
+
+      const qint64 start = clock.nsecsElapsed();
+      segment->write(written);
+      cost.append(clock.nsecsElapsed() - start);
+   }
+
+   stop.storeRelease(1);
+   reader->wait();
+   delete reader;
+
+   const Statistics write = getStatistics(cost);
+   const Statistics read = getStatistics(reads);
+
+   printf("\nShared memory benchmark (%d updates, times in nanoseconds)\n\n", SHM_UPDATES);
+   printf("%-18s %10s %10s %10s %10s\n", "Operation", "Mean", "p50", "p99", "Max");
+   printSharedMemoryStatistics("Joystick latch", latch);
+   printSharedMemoryStatistics("Status change", status);
+   printSharedMemoryStatistics("Contended write", write);
+   printSharedMemoryStatistics("Contended read", read);
+   printf("\n%d snapshots, %llu failed after 4 attempts, %llu inconsistent\n", reads.count(), failed, torn);
+
+   return torn == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "controlserver.h"
+
+#include <QDebug>
+#include <QtEndian>
+#include <QDateTime>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+#include <DriverStation.h>
+
+/**
+ * Appends the little endian representation of \a value to \a data
+ */
+template <typename T>
+static void Append(QByteArray &data, const T value)
+{
+   uchar bytes[sizeof(T)];
+   qToLittleEndian<T>(value, bytes);
+   data.append(reinterpret_cast<const char *>(bytes), sizeof(T));
+}
+
+ControlServer::ControlServer(DriverStation *driverstation, Joysticks *joysticks)
+{
+   m_state.clear();
+   m_joysticks = joysticks;
+   m_driverstation = driverstation;
+
+   m_server = new QLocalServer(this);
+   m_server->setSocketOptions(QLocalServer::UserAccessOption);
+   connect(m_server, SIGNAL(newConnection()), this, SLOT(acceptClients()));
+
+   /* Sample the DS at the control packet rate, only while there are subscribers */
+   m_timer.setInterval(SampleInterval);
+   m_timer.setTimerType(Qt::PreciseTimer);
+   connect(&m_timer, SIGNAL(timeout()), this, SLOT(sample()));
+}
+
+/**
+ * Disconnects the clients & closes the server
+ */
+ControlServer::~ControlServer()
+{
+   m_timer.stop();
+   foreach (QLocalSocket *socket, m_clients.keys())
+      socket->disconnect(this);
+
+   m_clients.clear();
+   m_server->close();
+}
+
+/**
+ * Returns the number of connected clients
+ */
+int ControlServer::clientCount() const
+{
+   return m_clients.count();
+}
+
+/**
+ * Starts accepting clients in the local socket with the given \a name.
+ * A socket left by a previous instance that crashed is removed first, but
+ * the socket of another running instance is never taken over.
+ */
+bool ControlServer::listen(const QString &name)
+{
+   /* Another DS is already answering in this socket, leave it alone */
+   QLocalSocket probe;
+   probe.connectToServer(name);
+   if (probe.waitForConnected(ProbeTimeout))
+   {
+      probe.disconnectFromServer();
+      qWarning() << "Cannot start the control server: another instance is using" << name;
+      return false;
+   }
+
+   /* Nothing answered, so the socket file (if any) is stale */
+   if (probe.error() == QLocalSocket::ConnectionRefusedError)
+      QLocalServer::removeServer(name);
+
+   if (!m_server->listen(name))
+   {
+      qWarning() << "Cannot start the control server:" << m_server->errorString();
+      return false;
+   }
+
+   qDebug() << "Control server listening on" << m_server->fullServerName();
+   return true;
+}
+
+/**
+ * Reads the current DS status & joystick input, and publishes the topics
+ * whose values changed since the last sample
+ */
+void ControlServer::sample()
+{
+   m_state.capture(m_driverstation, m_joysticks);
+
+   quint8 changed = 0;
+   const QByteArray status = statusPayload();
+   const QByteArray joysticks = joysticksPayload();
+
+   QByteArray time;
+   Append<qint64>(time, m_state.timestamp);
+
+   if (status != m_statusPayload)
+   {
+      changed |= kStatusTopic;
+      m_statusPayload = status;
+      m_statusFrame = frame(kStatus, time + status);
+   }
+
+   if (joysticks != m_joysticksPayload)
+   {
+      changed |= kJoysticksTopic;
+      m_joysticksPayload = joysticks;
+      m_joysticksFrame = frame(kJoysticks, time + joysticks);
+   }
+
+   if (changed)
+      publish(changed);
+}
+
+/**
+ * Registers the clients that connected to the server
+ */
+void ControlServer::acceptClients()
+{
+   while (m_server->hasPendingConnections())
+   {
+      QLocalSocket *socket = m_server->nextPendingConnection();
+
+      Client client;
+      client.topics = 0;
+      client.missed = 0;
+      m_clients.insert(socket, client);
+
+      connect(socket, SIGNAL(readyRead()), this, SLOT(readFrames()));
+      connect(socket, SIGNAL(bytesWritten(qint64)), this, SLOT(sendMissed()));
+      connect(socket, SIGNAL(disconnected()), this, SLOT(removeClient()));
+   }
+
+   emit clientCountChanged();
+}
+
+/**
+ * Splits the data received from a client in frames and handles them.
+ * Clients that send invalid frames are disconnected.
+ */
+void ControlServer::readFrames()
+{
+   QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+   if (!socket || !m_clients.contains(socket))
+      return;
+
+   QByteArray &buffer = m_clients[socket].buffer;
+   buffer.append(socket->readAll());
+
+   while (buffer.size() >= 4)
+   {
+      const quint32 length = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(buffer.constData()));
+      if (length == 0 || length > MaxClientFrame)
+      {
+         qWarning() << "Control server: invalid frame, disconnecting client";
+         socket->disconnectFromServer();
+         return;
+      }
+
+      if (buffer.size() < int(4 + length))
+         return;
+
+      const QByteArray data = buffer.mid(4, length);
+      buffer.remove(0, 4 + length);
+      handleFrame(socket, data);
+
+      /* The client may be removed while handling the frame */
+      if (!m_clients.contains(socket))
+         return;
+   }
+}
+
+/**
+ * Sends the latest value of the topics that a client missed while it was
+ * behind, once its socket buffer is drained
+ */
+void ControlServer::sendMissed()
+{
+   QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+   if (!socket || !m_clients.contains(socket))
+      return;
+
+   Client &client = m_clients[socket];
+   if (client.missed && socket->bytesToWrite() < MaxPendingBytes / 2)
+   {
+      const quint8 missed = client.missed;
+      client.missed = 0;
+      send(socket, missed);
+   }
+}
+
+/**
+ * Unregisters a disconnected client
+ */
+void ControlServer::removeClient()
+{
+   QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+   if (!socket || !m_clients.remove(socket))
+      return;
+
+   socket->deleteLater();
+   updateTimer();
+   emit clientCountChanged();
+}
+
+/**
+ * Handles a frame (type & payload) received from a client
+ */
+void ControlServer::handleFrame(QLocalSocket *socket, const QByteArray &frame)
+{
+   const quint8 type = static_cast<quint8>(frame.at(0));
+
+   /* Subscribe to the given topics, the current values are sent right away */
+   if (type == kSubscribe && frame.size() >= 2)
+   {
+      const quint8 topics = static_cast<quint8>(frame.at(1)) & (kStatusTopic | kJoysticksTopic);
+      const quint8 added = topics & ~m_clients[socket].topics;
+
+      /* Publish the current values to the other clients first */
+      if (added)
+         sample();
+
+      Client &client = m_clients[socket];
+      client.topics = topics;
+      client.missed &= topics;
+      if (added)
+         send(socket, added);
+
+      updateTimer();
+   }
+
+   /* Run a command & tell the client if it was accepted. The command always
+    * runs, but the result is dropped if the client does not read its frames,
+    * so that its buffer cannot grow without limit. */
+   else if (type == kCommand && frame.size() >= 2)
+   {
+      const quint8 command = static_cast<quint8>(frame.at(1));
+      const quint8 argument = frame.size() >= 3 ? static_cast<quint8>(frame.at(2)) : 0;
+
+      QByteArray result;
+      result.append(static_cast<char>(command));
+      result.append(static_cast<char>(runCommand(command, argument)));
+      if (socket->bytesToWrite() <= MaxPendingBytes)
+         socket->write(ControlServer::frame(kCommandResult, result));
+   }
+
+   else
+      qWarning() << "Control server: ignored frame of type" << type;
+}
+
+/**
+ * Runs the given \a command, returns \c false if it is unknown or the DS
+ * cannot run it right now (e.g. enabling a robot that cannot be enabled)
+ */
+bool ControlServer::runCommand(const quint8 command, const quint8 argument)
+{
+   switch (command)
+   {
+      case kEnable:
+         if (!m_driverstation->canBeEnabled())
+            return false;
+         m_driverstation->setEnabled(true);
+         return true;
+      case kDisable:
+         m_driverstation->setEnabled(false);
+         return true;
+      case kEmergencyStop:
+         m_driverstation->setEmergencyStopped(true);
+         return true;
+      case kSetControlMode:
+         /* Test, autonomous or teleoperated */
+         if (argument > 2)
+            return false;
+         m_driverstation->setControlMode(static_cast<DriverStation::Control>(argument));
+         return true;
+      case kRebootRobot:
+         m_driverstation->rebootRobot();
+         return true;
+      case kRestartRobotCode:
+         m_driverstation->restartRobotCode();
+         return true;
+      default:
+         return false;
+   }
+}
+
+/**
+ * Queues the latest frames of the given \a topics to a client, if the client
+ * is behind the topics are marked as missed and sent once it catches up
+ */
+void ControlServer::send(QLocalSocket *socket, const quint8 topics)
+{
+   Client &client = m_clients[socket];
+   if (socket->bytesToWrite() > MaxPendingBytes)
+   {
+      client.missed |= topics;
+      return;
+   }
+
+   if ((topics & kStatusTopic) && !m_statusFrame.isEmpty())
+      socket->write(m_statusFrame);
+   if ((topics & kJoysticksTopic) && !m_joysticksFrame.isEmpty())
+      socket->write(m_joysticksFrame);
+}
+
+/**
+ * Queues the latest frames of the changed \a topics to their subscribers
+ */
+void ControlServer::publish(const quint8 topics)
+{
+   QHash<QLocalSocket *, Client>::const_iterator i;
+   for (i = m_clients.constBegin(); i != m_clients.constEnd(); ++i)
+   {
+      const quint8 subscribed = topics & i.value().topics;
+      if (subscribed)
+         send(i.key(), subscribed);
+   }
+}
+
+/**
+ * Samples the DS only while at least one client is subscribed to a topic
+ */
+void ControlServer::updateTimer()
+{
+   bool subscribers = false;
+   foreach (const Client &client, m_clients)
+      subscribers |= client.topics != 0;
+
+   if (subscribers && !m_timer.isActive())
+      m_timer.start();
+   else if (!subscribers)
+      m_timer.stop();
+}
+
+/**
+ * Returns the status payload:
+ *
+ *    i16 voltage (hundredths of a volt)
+ *    u8  packet loss, control mode, enabled, e-stopped, connected,
+ *        robot CPU, RAM & CAN usage
+ */
+QByteArray ControlServer::statusPayload() const
+{
+   QByteArray data;
+   Append<qint16>(data, m_state.voltage);
+   Append<quint8>(data, m_state.packetLoss);
+   Append<quint8>(data, m_state.controlMode);
+   Append<quint8>(data, m_state.enabled);
+   Append<quint8>(data, m_state.emergencyStopped);
+   Append<quint8>(data, m_state.connected);
+   Append<quint8>(data, m_state.cpuUsage);
+   Append<quint8>(data, m_state.ramUsage);
+   Append<quint8>(data, m_state.canUsage);
+   return data;
+}
+
+/**
+ * Returns the joysticks payload:
+ *
+ *    u8 joystick count, then for each joystick:
+ *    u8  axis, hat & button count
+ *    i16 axes (thousandths), i16 hats (angles), u32 buttons (bit mask)
+ */
+QByteArray ControlServer::joysticksPayload() const
+{
+   QByteArray data;
+   Append<quint8>(data, m_state.joystickCount);
+   for (int js = 0; js < m_state.joystickCount; ++js)
+   {
+      Append<quint8>(data, m_state.numAxes[js]);
+      Append<quint8>(data, m_state.numHats[js]);
+      Append<quint8>(data, m_state.numButtons[js]);
+
+      for (int i = 0; i < m_state.numAxes[js]; ++i)
+         Append<qint16>(data, m_state.axes[js][i]);
+      for (int i = 0; i < m_state.numHats[js]; ++i)
+         Append<qint16>(data, m_state.hats[js][i]);
+
+      Append<quint32>(data, m_state.buttons[js]);
+   }
+
+   return data;
+}
+
+/**
+ * Returns a frame with the given \a type & \a payload, the frames sent by
+ * the DS start with the time (ms since epoch, i64) of the sample
+ */
+QByteArray ControlServer::frame(const quint8 type, const QByteArray &payload)
+{
+   QByteArray data;
+   data.reserve(5 + payload.size());
+   Append<quint32>(data, 1 + payload.size());
+   Append<quint8>(data, type);
+   data.append(payload);
+   return data;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_CONTROL_SERVER_H
+#define _QDS_CONTROL_SERVER_H
+
+#include <QHash>
+#include <QTimer>
+#include <QObject>
+#include <QByteArray>
+
+#include "dsstate.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+/**
+ * \brief Publishes the robot status & joystick input to local tools
+ *
+ * External tools (dashboards, scouting apps...) connect to the local socket
+ * named \c qdriverstation (a Unix socket or a named pipe, depending on the
+ * OS) and exchange length-prefixed binary frames with the DS:
+ *
+ *    u32 length (of the type & payload, little endian)
+ *    u8  type
+ *    ... payload (little endian)
+ *
+ * Clients send a \c kSubscribe frame with a bit mask of the topics that they
+ * want to receive. The current value of each new topic is sent right away,
+ * and then a frame is only sent when the value of the topic changes, so that
+ * clients never need to poll the DS. Clients can also send \c kCommand frames
+ * (command & argument bytes), each one is answered with a \c kCommandResult
+ * frame (command & result bytes). The result is not sent to a client that
+ * fell behind, but its command still runs.
+ *
+ * The DS is sampled at the control packet rate while there are subscribers.
+ * Each frame is encoded once and queued to every subscriber without waiting
+ * for it to be written. A client that does not read its frames falls behind
+ * and stops receiving frames until its socket buffer drains, then it receives
+ * the latest value of its topics. A slow client can never block the DS.
+ */
+class ControlServer : public QObject
+{
+   Q_OBJECT
+   Q_PROPERTY(int clientCount READ clientCount NOTIFY clientCountChanged)
+
+signals:
+   void clientCountChanged();
+
+public:
+   explicit ControlServer(DriverStation *driverstation, Joysticks *joysticks);
+   ~ControlServer();
+
+   enum FrameType
+   {
+      /* Sent by the DS */
+      kStatus = 0x01,
+      kJoysticks = 0x02,
+      kCommandResult = 0x21,
+
+      /* Sent by the clients */
+      kSubscribe = 0x10,
+      kCommand = 0x20,
+   };
+
+   enum Topic
+   {
+      kStatusTopic = 0x01,
+      kJoysticksTopic = 0x02,
+   };
+
+   enum Command
+   {
+      kEnable = 0x01,
+      kDisable = 0x02,
+      kEmergencyStop = 0x03,
+      kSetControlMode = 0x04,
+      kRebootRobot = 0x05,
+      kRestartRobotCode = 0x06,
+   };
+
+   enum
+   {
+      SampleInterval = 20,
+      ProbeTimeout = 250,
+      MaxClientFrame = 64,
+      MaxPendingBytes = 64 * 1024,
+   };
+
+   int clientCount() const;
+   bool listen(const QString &name = "qdriverstation");
+
+private slots:
+   void sample();
+   void acceptClients();
+   void readFrames();
+   void sendMissed();
+   void removeClient();
+
+private:
+   /**
+    * \brief Subscriptions & pending state of a connected client
+    */
+   struct Client
+   {
+      quint8 topics;
+      quint8 missed;
+      QByteArray buffer;
+   };
+
+   void handleFrame(QLocalSocket *socket, const QByteArray &frame);
+   bool runCommand(const quint8 command, const quint8 argument);
+   void send(QLocalSocket *socket, const quint8 topics);
+   void publish(const quint8 topics);
+   void updateTimer();
+
+   QByteArray statusPayload() const;
+   QByteArray joysticksPayload() const;
+   static QByteArray frame(const quint8 type, const QByteArray &payload);
+
+private:
+   QTimer m_timer;
+   DSState m_state;
+   QLocalServer *m_server;
+   Joysticks *m_joysticks;
+   DriverStation *m_driverstation;
+
+   QByteArray m_statusFrame;
+   QByteArray m_joysticksFrame;
+   QByteArray m_statusPayload;
+   QByteArray m_joysticksPayload;
+   QHash<QLocalSocket *, Client> m_clients;
+};
+
+#endif
@@ -0,0 +1,454 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "cpusampler.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Reads the given file from the beginning into \a buffer, which is always
+ * null-terminated. Returns the number of bytes read, or -1 on error.
+ */
+static int readFile(const int fd, char *buffer, const int size)
+{
+   if (fd < 0)
+      return -1;
+
+   const ssize_t bytes = pread(fd, buffer, size - 1, 0);
+   buffer[qMax<ssize_t>(0, bytes)] = '\0';
+   return static_cast<int>(bytes);
+}
+
+/**
+ * Parses the unsigned number at \a text and moves the pointer past it
+ */
+static quint64 readNumber(const char *&text)
+{
+   quint64 number = 0;
+   while (*text == ' ')
+      ++text;
+   while (*text >= '0' && *text <= '9')
+      number = number * 10 + static_cast<quint64>(*text++ - '0');
+
+   return number;
+}
+
+/**
+ * Skips the given number of space-separated fields
+ */
+static void skipFields(const char *&text, int fields)
+{
+   while (fields-- > 0 && *text)
+   {
+      while (*text == ' ')
+         ++text;
+      while (*text && *text != ' ')
+         ++text;
+   }
+}
+
+/**
+ * Reads the CPU time (user + system ticks) from the stat file of a process.
+ * The command name may contain spaces, the fields start after its ')'.
+ */
+static bool readProcessTicks(const char *stat, quint64 &ticks)
+{
+   const char *text = strrchr(stat, ')');
+   if (!text)
+      return false;
+
+   ++text;
+   skipFields(text, 11);
+   ticks = readNumber(text) + readNumber(text);
+   return true;
+}
+
+/**
+ * Returns the number of resident pages, the second field of a statm file
+ */
+static quint64 readResidentPages(const char *statm)
+{
+   const char *text = statm;
+   readNumber(text);
+   return readNumber(text);
+}
+
+/**
+ * Returns the CPU usage between two samples (from 0 to 100)
+ */
+static int getUsage(const quint64 busy, const quint64 total)
+{
+   if (total == 0)
+      return 0;
+
+   return static_cast<int>(qMin<quint64>(100, (busy * 100 + total / 2) / total));
+}
+
+/**
+ * Opens the files used to obtain the CPU usage & memory information
+ */
+CpuSampler::CpuSampler()
+{
+   m_coreCount = 0;
+   m_threadCount = 0;
+   m_totalUsage = 0;
+   m_processUsage = 0;
+   m_processMemory = 0;
+   m_processTicks = 0;
+   m_totalTicks = 0;
+   m_childUsage = 0;
+   m_childMemory = 0;
+   m_childTicks = 0;
+   m_childStatFile = -1;
+   m_childStatmFile = -1;
+   m_pageSize = sysconf(_SC_PAGESIZE);
+
+   memset(m_coreUsage, 0, sizeof(m_coreUsage));
+   memset(m_busyTicks, 0, sizeof(m_busyTicks));
+   memset(m_allTicks, 0, sizeof(m_allTicks));
+   memset(m_threads, 0, sizeof(m_threads));
+
+   m_statFile = open("/proc/stat", O_RDONLY | O_CLOEXEC);
+   m_selfStatFile = open("/proc/self/stat", O_RDONLY | O_CLOEXEC);
+   m_selfStatmFile = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+   m_taskDir = opendir("/proc/self/task");
+}
+
+/**
+ * Closes the opened files
+ */
+CpuSampler::~CpuSampler()
+{
+   setChildProcess(0);
+
+   for (int i = 0; i < m_threadCount; ++i)
+   {
+      if (m_threads[i].fd >= 0)
+         close(m_threads[i].fd);
+   }
+
+   if (m_statFile >= 0)
+      close(m_statFile);
+   if (m_selfStatFile >= 0)
+      close(m_selfStatFile);
+   if (m_selfStatmFile >= 0)
+      close(m_selfStatmFile);
+   if (m_taskDir)
+      closedir(m_taskDir);
+}
+
+/**
+ * Reads the CPU counters and calculates the usage since the last sample.
+ * Returns \c false if the CPU counters could not be read.
+ */
+bool CpuSampler::sample()
+{
+   quint64 totalTicks = 0;
+   if (!sampleCores(totalTicks))
+      return false;
+
+   sampleProcess(totalTicks);
+   sampleChild(totalTicks);
+   sampleThreads(totalTicks);
+   m_totalTicks = totalTicks;
+   return true;
+}
+
+/**
+ * Returns the CPU usage of the whole machine (from 0 to 100)
+ */
+int CpuSampler::totalUsage() const
+{
+   return m_totalUsage;
+}
+
+/**
+ * Returns the number of CPU cores reported by the kernel
+ */
+int CpuSampler::coreCount() const
+{
+   return m_coreCount;
+}
+
+/**
+ * Returns the usage of the given CPU \a core (from 0 to 100)
+ */
+int CpuSampler::coreUsage(const int core) const
+{
+   Q_ASSERT(core >= 0 && core < m_coreCount);
+   return m_coreUsage[core];
+}
+
+/**
+ * Returns the share of the machine CPU time used by this process (0 to 100)
+ */
+int CpuSampler::processUsage() const
+{
+   return m_processUsage;
+}
+
+/**
+ * Returns the resident memory of this process (in bytes)
+ */
+quint64 CpuSampler::processMemory() const
+{
+   return m_processMemory;
+}
+
+/**
+ * Starts sampling the child process with the given \a pid, or stops
+ * sampling the current child if \a pid is 0
+ */
+void CpuSampler::setChildProcess(const int pid)
+{
+   if (m_childStatFile >= 0)
+      close(m_childStatFile);
+   if (m_childStatmFile >= 0)
+      close(m_childStatmFile);
+
+   m_childUsage = 0;
+   m_childMemory = 0;
+   m_childTicks = 0;
+   m_childStatFile = -1;
+   m_childStatmFile = -1;
+
+   if (pid > 0)
+   {
+      char path[64];
+      snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+      m_childStatFile = open(path, O_RDONLY | O_CLOEXEC);
+      snprintf(path, sizeof(path), "/proc/%d/statm", pid);
+      m_childStatmFile = open(path, O_RDONLY | O_CLOEXEC);
+   }
+}
+
+/**
+ * Returns the share of the machine CPU time used by the child (0 to 100)
+ */
+int CpuSampler::childUsage() const
+{
+   return m_childUsage;
+}
+
+/**
+ * Returns the resident memory of the child process (in bytes)
+ */
+quint64 CpuSampler::childMemory() const
+{
+   return m_childMemory;
+}
+
+/**
+ * Returns the number of threads of this process
+ */
+int CpuSampler::threadCount() const
+{
+   return m_threadCount;
+}
+
+/**
+ * Returns the usage information of the thread at the given \a index
+ */
+const ThreadUsage &CpuSampler::thread(const int index) const
+{
+   Q_ASSERT(index >= 0 && index < m_threadCount);
+   return m_threads[index];
+}
+
+/**
+ * Parses the "cpu" lines of /proc/stat. All the states are taken into account
+ * (iowait, irq, softirq & steal included), idle time includes iowait.
+ */
+bool CpuSampler::sampleCores(quint64 &totalTicks)
+{
+   if (readFile(m_statFile, m_buffer, sizeof(m_buffer)) <= 0)
+      return false;
+
+   int core = -1;
+   const char *line = m_buffer;
+   while (strncmp(line, "cpu", 3) == 0 && core < MAX_CPU_CORES)
+   {
+      /* Skip the "cpu" or "cpuN" label */
+      const char *text = line + 3;
+      while (*text && *text != ' ')
+         ++text;
+
+      const quint64 user = readNumber(text);
+      const quint64 nice = readNumber(text);
+      const quint64 system = readNumber(text);
+      const quint64 idle = readNumber(text);
+      const quint64 iowait = readNumber(text);
+      const quint64 irq = readNumber(text);
+      const quint64 softirq = readNumber(text);
+      const quint64 steal = readNumber(text);
+
+      const quint64 busy = user + nice + system + irq + softirq + steal;
+      const quint64 all = busy + idle + iowait;
+
+      /* Index 0 is the total, the cores go after it */
+      const int index = core + 1;
+      const int usage = getUsage(busy - m_busyTicks[index], all - m_allTicks[index]);
+      if (core < 0)
+      {
+         m_totalUsage = usage;
+         totalTicks = all;
+      }
+
+      else
+         m_coreUsage[core] = usage;
+
+      m_busyTicks[index] = busy;
+      m_allTicks[index] = all;
+
+      /* Go to next line */
+      ++core;
+      line = strchr(text, '\n');
+      if (!line)
+         break;
+
+      ++line;
+   }
+
+   m_coreCount = qMax(0, core);
+   return core >= 0;
+}
+
+/**
+ * Reads the CPU time and the resident memory of this process
+ */
+void CpuSampler::sampleProcess(const quint64 totalTicks)
+{
+   quint64 ticks = 0;
+   if (readFile(m_selfStatFile, m_buffer, sizeof(m_buffer)) > 0 && readProcessTicks(m_buffer, ticks))
+   {
+      m_processUsage = getUsage(ticks - m_processTicks, totalTicks - m_totalTicks);
+      m_processTicks = ticks;
+   }
+
+   if (readFile(m_selfStatmFile, m_buffer, sizeof(m_buffer)) > 0)
+      m_processMemory = readResidentPages(m_buffer) * static_cast<quint64>(m_pageSize);
+}
+
+/**
+ * Reads the CPU time and the resident memory of the child process, the
+ * values are reset once the child exits
+ */
+void CpuSampler::sampleChild(const quint64 totalTicks)
+{
+   quint64 ticks = 0;
+   if (readFile(m_childStatFile, m_buffer, sizeof(m_buffer)) > 0 && readProcessTicks(m_buffer, ticks))
+   {
+      m_childUsage = m_childTicks > 0 ? getUsage(ticks - m_childTicks, totalTicks - m_totalTicks) : 0;
+      m_childTicks = ticks;
+   }
+
+   else
+   {
+      m_childUsage = 0;
+      m_childTicks = 0;
+   }
+
+   if (readFile(m_childStatmFile, m_buffer, sizeof(m_buffer)) > 0)
+      m_childMemory = readResidentPages(m_buffer) * static_cast<quint64>(m_pageSize);
+   else
+      m_childMemory = 0;
+}
+
+/**
+ * Reads the CPU time of each thread of this process. The stat file of each
+ * thread stays open while the thread is alive.
+ */
+void CpuSampler::sampleThreads(const quint64 totalTicks)
+{
+   if (!m_taskDir)
+      return;
+
+   for (int i = 0; i < m_threadCount; ++i)
+      m_threads[i].alive = false;
+
+   /* Find the threads & open the stat file of new threads */
+   rewinddir(m_taskDir);
+   struct dirent *entry;
+   while ((entry = readdir(m_taskDir)) != nullptr)
+   {
+      const int tid = atoi(entry->d_name);
+      if (tid <= 0)
+         continue;
+
+      int index = 0;
+      while (index < m_threadCount && m_threads[index].tid != tid)
+         ++index;
+
+      if (index == m_threadCount)
+      {
+         if (m_threadCount >= MAX_CPU_THREADS)
+            continue;
+
+         char path[64];
+         snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+
+         ThreadUsage &thread = m_threads[m_threadCount++];
+         memset(&thread, 0, sizeof(thread));
+         thread.tid = tid;
+         thread.fd = open(path, O_RDONLY | O_CLOEXEC);
+      }
+
+      m_threads[index].alive = true;
+   }
+
+   /* Read the CPU time & name of each thread, forget about dead threads */
+   int count = 0;
+   for (int i = 0; i < m_threadCount; ++i)
+   {
+      ThreadUsage &thread = m_threads[i];
+      if (!thread.alive || readFile(thread.fd, m_buffer, sizeof(m_buffer)) <= 0)
+      {
+         if (thread.fd >= 0)
+            close(thread.fd);
+
+         continue;
+      }
+
+      const char *start = strchr(m_buffer, '(');
+      const char *end = strrchr(m_buffer, ')');
+      if (start && end && end > start)
+      {
+         const int length = qMin<int>(end - start - 1, sizeof(thread.name) - 1);
+         memcpy(thread.name, start + 1, length);
+         thread.name[length] = '\0';
+
+         const char *text = end + 1;
+         skipFields(text, 11);
+         const quint64 ticks = readNumber(text) + readNumber(text);
+         thread.usage = thread.ticks > 0 ? getUsage(ticks - thread.ticks, totalTicks - m_totalTicks) : 0;
+         thread.ticks = ticks;
+      }
+
+      m_threads[count++] = thread;
+   }
+
+   m_threadCount = count;
+}
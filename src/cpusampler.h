@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_CPU_SAMPLER_H
+#define _QDS_CPU_SAMPLER_H
+
+#include <QtGlobal>
+#include <dirent.h>
+
+/* Limits of the sampler buffers */
+static const int MAX_CPU_CORES = 256;
+static const int MAX_CPU_THREADS = 128;
+
+/**
+ * \brief CPU usage of a thread of this process
+ */
+struct ThreadUsage
+{
+   int tid;
+   int fd;
+   int usage;
+   bool alive;
+   char name[16];
+   quint64 ticks;
+};
+
+/**
+ * \brief Samples the CPU usage of the host, of each core and of this process
+ *
+ * All the files in \c /proc are opened once and re-read from the beginning on
+ * each call to \c sample(). The data is parsed into fixed buffers, so taking
+ * a sample does not allocate memory (except when a new thread is spawned).
+ *
+ * The usage of this process and of its threads is expressed as a percentage
+ * of the total CPU time of the machine, so it can be compared directly with
+ * the host CPU usage. The same values are obtained for a child process (the
+ * dashboard) if one is given with \c setChildProcess().
+ */
+class CpuSampler
+{
+public:
+   CpuSampler();
+   ~CpuSampler();
+
+   bool sample();
+
+   int totalUsage() const;
+   int coreCount() const;
+   int coreUsage(const int core) const;
+
+   int processUsage() const;
+   quint64 processMemory() const;
+
+   void setChildProcess(const int pid);
+   int childUsage() const;
+   quint64 childMemory() const;
+
+   int threadCount() const;
+   const ThreadUsage &thread(const int index) const;
+
+private:
+   bool sampleCores(quint64 &totalTicks);
+   void sampleProcess(const quint64 totalTicks);
+   void sampleChild(const quint64 totalTicks);
+   void sampleThreads(const quint64 totalTicks);
+
+private:
+   int m_statFile;
+   int m_selfStatFile;
+   int m_selfStatmFile;
+   int m_childStatFile;
+   int m_childStatmFile;
+   DIR *m_taskDir;
+
+   int m_coreCount;
+   int m_threadCount;
+   int m_totalUsage;
+   int m_processUsage;
+   long m_pageSize;
+   quint64 m_processMemory;
+   quint64 m_processTicks;
+   quint64 m_totalTicks;
+
+   int m_childUsage;
+   quint64 m_childMemory;
+   quint64 m_childTicks;
+
+   int m_coreUsage[MAX_CPU_CORES];
+   quint64 m_busyTicks[MAX_CPU_CORES + 1];
+   quint64 m_allTicks[MAX_CPU_CORES + 1];
+   ThreadUsage m_threads[MAX_CPU_THREADS];
+
+   char m_buffer[32 * 1024];
+};
+
+#endif
@@ -1,105 +1,720 @@
-/*
- * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#include <QDir>
-#include <QDebug>
-#include <QApplication>
-
-#include "dashboards.h"
-
-// *INDENT-OFF*
-#if defined Q_OS_WIN
-#   include <windows.h>
-#   define IS_64_BIT true
-#   if _WIN32
-#      undef IS_64_BIT
-#      define IS_64_BIT GetProcAddress(GetModuleHandle(TEXT("kernel32")), "IsWow64Process")
-#   endif
-#   define PROGRAM_FILES IS_64_BIT ? "C:/Program Files (x86)" : "C:/Program Files"
-#endif
-// *INDENT-ON*
-
-/* Dashboard open commands */
-const QString LVD_COMMAND = "\"%1/FRC Dashboard/Dashboard.exe\"";
-const QString SFX_COMMAND = "java -jar \"%1/wpilib/tools/sfx.jar\"";
-const QString SBD_COMMAND = "java -jar \"%1/wpilib/tools/SmartDashboard.jar\"";
-const QString SHB_COMMAND = "java -jar \"%1/wpilib/tools/shuffleboard.jar\"";
-
-/**
- * Configures the application to close the dashboard when it quits
- */
-Dashboards::Dashboards()
-{
-   connect(qApp, SIGNAL(aboutToQuit()), &m_process, SLOT(kill()));
-}
-
-/**
- * Returns a list with the available dashboards.
- * \note This list may differ from operating system to operating system
- */
-QStringList Dashboards::dashboardList()
-{
-   QStringList list;
-   list.append(tr("None"));
-   list.append(tr("SFX Dashboard"));
-   list.append(tr("SmartDashboard"));
-   list.append(tr("Shuffleboard"));
-
-#if defined Q_OS_WIN
-   list.append(tr("LabVIEW Dashboard"));
-#endif
-
-   return list;
-}
-
-/**
- * Opens the given \a dashboard process
- */
-void Dashboards::openDashboard(int dashboard)
-{
-   m_process.kill();
-   QString command = "";
-
-   switch (dashboard)
-   {
-      case kSFXDashboard:
-         command = SFX_COMMAND.arg(QDir::homePath());
-         break;
-      case kSmartDashboard:
-         command = SBD_COMMAND.arg(QDir::homePath());
-         break;
-      case kShuffleboard:
-         command = SHB_COMMAND.arg(QDir::homePath());
-         break;
-#if defined Q_OS_WIN
-      case kLabVIEWDashboard:
-         command = LVD_COMMAND.arg(PROGRAM_FILES);
-         break;
-#endif
-   }
-
-   if (!command.isEmpty())
-   {
-      m_process.start(command, QStringList(), QIODevice::ReadOnly);
-      qDebug() << "Dashboard command set to:" << command.toStdString().c_str();
-   }
-}
+/*
+ * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <QDir>
+#include <QDebug>
+#include <QThread>
+#include <QStandardPaths>
+
+#include "dashboards.h"
+#include "appsettings.h"
+
+#if defined Q_OS_UNIX
+#   include <sys/resource.h>
+#endif
+
+#if defined Q_OS_LINUX
+#   include <sched.h>
+#endif
+
+// *INDENT-OFF*
+#if defined Q_OS_WIN
+#   include <windows.h>
+#   define IS_64_BIT true
+#   if _WIN32
+#      undef IS_64_BIT
+#      define IS_64_BIT GetProcAddress(GetModuleHandle(TEXT("kernel32")), "IsWow64Process")
+#   endif
+#   define PROGRAM_FILES IS_64_BIT ? "C:/Program Files (x86)" : "C:/Program Files"
+#endif
+// *INDENT-ON*
+
+/* Dashboard open commands */
+const QString LVD_COMMAND = "\"%1/FRC Dashboard/Dashboard.exe\"";
+const QString SFX_COMMAND = "java -jar \"%1/wpilib/tools/sfx.jar\"";
+const QString SBD_COMMAND = "java -jar \"%1/wpilib/tools/SmartDashboard.jar\"";
+const QString SHB_COMMAND = "java -jar \"%1/wpilib/tools/shuffleboard.jar\"";
+
+/* Niceness of the dashboards for each priority */
+static const int NICENESS[] = { 0, 10, 19 };
+
+//------------------------------------------------------------------------------
+// Dashboard process
+//------------------------------------------------------------------------------
+
+/**
+ * Configures a process that runs the given \a command. If \a waitForOutput
+ * is \c false, the dashboard is ready as soon as its process starts.
+ */
+DashboardProcess::DashboardProcess(const QString &command, const bool waitForOutput, QObject *parent)
+   : QObject(parent)
+   , m_state(kStopped)
+   , m_command(command)
+   , m_waitForOutput(waitForOutput)
+   , m_backoff(MinimumBackoff)
+   , m_readyTime(-1)
+   , m_niceness(0)
+   , m_cpuQuota(0)
+   , m_memoryLimit(0)
+   , m_reservedCores(0)
+{
+   /* The output is read (and discarded), so the dashboard never blocks on a full pipe */
+   m_process.setProcessChannelMode(QProcess::MergedChannels);
+   connect(&m_process, SIGNAL(readyRead()), this, SLOT(readOutput()));
+   connect(&m_process, SIGNAL(errorOccurred(QProcess::ProcessError)), this, SLOT(onError(QProcess::ProcessError)));
+   connect(&m_process, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(onFinished(int, QProcess::ExitStatus)));
+   connect(&m_process, SIGNAL(started()), this, SLOT(onStarted()));
+   if (!m_waitForOutput)
+      connect(&m_process, SIGNAL(started()), this, SLOT(markReady()));
+
+   m_restartTimer.setSingleShot(true);
+   connect(&m_restartTimer, SIGNAL(timeout()), this, SLOT(launch()));
+
+   m_stableTimer.setSingleShot(true);
+   m_stableTimer.setInterval(StableTime);
+   connect(&m_stableTimer, SIGNAL(timeout()), this, SLOT(resetBackoff()));
+}
+
+/**
+ * Closes the dashboard
+ */
+DashboardProcess::~DashboardProcess()
+{
+   stop();
+   m_process.waitForFinished(3000);
+}
+
+/**
+ * Returns the current state of the dashboard
+ */
+DashboardProcess::State DashboardProcess::state() const
+{
+   return m_state;
+}
+
+/**
+ * Returns \c true if the dashboard is starting, running or waiting to be
+ * restarted after a crash
+ */
+bool DashboardProcess::isRunning() const
+{
+   return m_state == kStarting || m_state == kReady || m_state == kRestarting;
+}
+
+/**
+ * Returns the ID of the dashboard process, or 0 if it is not running
+ */
+qint64 DashboardProcess::processId() const
+{
+   return m_process.processId();
+}
+
+/**
+ * Returns the time (in milliseconds) between the last launch and the moment
+ * in which the dashboard was ready, or -1 if it is not ready yet
+ */
+qint64 DashboardProcess::readyTime() const
+{
+   return m_readyTime;
+}
+
+/**
+ * Returns the time (in milliseconds) to wait before the next restart
+ */
+int DashboardProcess::restartDelay() const
+{
+   return m_restartTimer.interval();
+}
+
+/**
+ * Sets the \a niceness (0 to 19) of the dashboard, mapped to a priority
+ * class on Windows
+ */
+void DashboardProcess::setNiceness(const int niceness)
+{
+   m_niceness = niceness;
+}
+
+/**
+ * Keeps the given number of CPU \a cores free from the dashboard
+ */
+void DashboardProcess::setReservedCores(const int cores)
+{
+   m_reservedCores = cores;
+}
+
+/**
+ * Runs the dashboard in a cgroup v2 scope limited to \a cpuQuota percent of
+ * a core and \a memoryLimit MB of memory. The limits are disabled with 0.
+ * \note This requires \c systemd-run and is only supported on GNU/Linux
+ */
+void DashboardProcess::setResourceLimits(const int cpuQuota, const int memoryLimit)
+{
+   m_cpuQuota = cpuQuota;
+   m_memoryLimit = memoryLimit;
+}
+
+/**
+ * Launches the dashboard, unless it is already running
+ */
+void DashboardProcess::start()
+{
+   if (isRunning())
+      return;
+
+   m_backoff = MinimumBackoff;
+   launch();
+}
+
+/**
+ * Closes the dashboard, it will not be restarted
+ */
+void DashboardProcess::stop()
+{
+   setState(kStopped);
+   m_stableTimer.stop();
+   m_restartTimer.stop();
+
+   if (m_process.state() != QProcess::NotRunning)
+      m_process.kill();
+}
+
+/**
+ * Starts the dashboard process & the launch-to-ready clock
+ */
+void DashboardProcess::launch()
+{
+   QStringList arguments = QProcess::splitCommand(m_command);
+   if (arguments.isEmpty())
+      return;
+
+   QString program = arguments.takeFirst();
+
+   /* Let systemd create a cgroup with the CPU & memory limits for the dashboard */
+#if defined Q_OS_LINUX
+   if (m_cpuQuota > 0 || m_memoryLimit > 0)
+   {
+      const QString systemdRun = QStandardPaths::findExecutable("systemd-run");
+      if (systemdRun.isEmpty())
+         qWarning() << "Cannot limit the dashboard resources, systemd-run not found";
+
+      else
+      {
+         QStringList scope;
+         scope << "--user" << "--scope" << "--quiet";
+         if (m_cpuQuota > 0)
+            scope << "-p" << QString("CPUQuota=%1%").arg(m_cpuQuota);
+         if (m_memoryLimit > 0)
+            scope << "-p" << QString("MemoryMax=%1M").arg(m_memoryLimit);
+
+         scope << "--" << program;
+         arguments = scope + arguments;
+         program = systemdRun;
+      }
+   }
+#endif
+
+   /* Lower the priority & affinity in the child process, before the
+    * dashboard is executed (only async-signal-safe calls are allowed) */
+#if defined Q_OS_UNIX
+   const int niceness = qBound(0, m_niceness, 19);
+
+#   if defined Q_OS_LINUX
+   cpu_set_t affinity;
+   CPU_ZERO(&affinity);
+   const int count = qMin(QThread::idealThreadCount(), CPU_SETSIZE);
+   for (int i = m_reservedCores; i < count; ++i)
+      CPU_SET(i, &affinity);
+
+   const bool setAffinity = m_reservedCores > 0 && count > m_reservedCores;
+   m_process.setChildProcessModifier([niceness, setAffinity, affinity]() {
+      if (niceness > 0)
+         setpriority(PRIO_PROCESS, 0, niceness);
+      if (setAffinity)
+         sched_setaffinity(0, sizeof(affinity), &affinity);
+   });
+#   else
+   m_process.setChildProcessModifier([niceness]() {
+      if (niceness > 0)
+         setpriority(PRIO_PROCESS, 0, niceness);
+   });
+#   endif
+#endif
+
+   m_readyTime = -1;
+   m_clock.start();
+   setState(kStarting);
+   m_process.start(program, arguments, QIODevice::ReadOnly);
+   qDebug() << "Dashboard command set to:" << m_command.toStdString().c_str();
+}
+
+/**
+ * Discards the output of the dashboard, the first output marks the
+ * dashboard as ready
+ */
+void DashboardProcess::readOutput()
+{
+   m_process.readAll();
+   markReady();
+}
+
+/**
+ * Records the launch-to-ready time of the dashboard
+ */
+void DashboardProcess::markReady()
+{
+   if (m_state != kStarting)
+      return;
+
+   m_readyTime = m_clock.elapsed();
+   m_stableTimer.start();
+   setState(kReady);
+
+   qDebug() << "Dashboard ready" << m_readyTime << "ms after its launch";
+}
+
+/**
+ * Lowers the priority & affinity of the dashboard on Windows (other systems
+ * apply them in the child process before the dashboard is executed) and
+ * notifies the manager, which samples the new process
+ */
+void DashboardProcess::onStarted()
+{
+#if defined Q_OS_WIN
+   const DWORD access = PROCESS_SET_INFORMATION | PROCESS_QUERY_INFORMATION;
+   HANDLE handle = OpenProcess(access, FALSE, static_cast<DWORD>(m_process.processId()));
+   if (handle)
+   {
+      if (m_niceness >= 19)
+         SetPriorityClass(handle, IDLE_PRIORITY_CLASS);
+      else if (m_niceness > 0)
+         SetPriorityClass(handle, BELOW_NORMAL_PRIORITY_CLASS);
+
+      DWORD_PTR processMask = 0;
+      DWORD_PTR systemMask = 0;
+      if (m_reservedCores > 0 && GetProcessAffinityMask(handle, &processMask, &systemMask))
+      {
+         DWORD_PTR mask = systemMask;
+         for (int i = 0; i < m_reservedCores; ++i)
+            mask &= ~(static_cast<DWORD_PTR>(1) << i);
+
+         if (mask)
+            SetProcessAffinityMask(handle, mask);
+      }
+
+      CloseHandle(handle);
+   }
+#endif
+
+   emit stateChanged();
+}
+
+/**
+ * The dashboard was stable for long enough, the next crash will be restarted
+ * after the minimum delay
+ */
+void DashboardProcess::resetBackoff()
+{
+   m_backoff = MinimumBackoff;
+}
+
+/**
+ * Stops trying if the dashboard cannot be started at all, other errors are
+ * reported by the \c finished() signal of the process
+ */
+void DashboardProcess::onError(QProcess::ProcessError error)
+{
+   if (error != QProcess::FailedToStart || m_state == kStopped)
+      return;
+
+   m_stableTimer.stop();
+   setState(kFailed);
+   qWarning() << "Cannot start dashboard:" << m_process.errorString();
+}
+
+/**
+ * Restarts the dashboard (after the backoff delay) if it crashed
+ */
+void DashboardProcess::onFinished(int exitCode, QProcess::ExitStatus status)
+{
+   m_stableTimer.stop();
+   if (!isRunning())
+      return;
+
+   /* The dashboard was closed by the user */
+   if (status == QProcess::NormalExit && exitCode == 0)
+   {
+      setState(kClosed);
+      return;
+   }
+
+   qWarning() << "Dashboard crashed (exit code" << exitCode << "), restarting in" << m_backoff << "ms";
+
+   m_restartTimer.start(m_backoff);
+   m_backoff = qMin<int>(m_backoff * 2, MaximumBackoff);
+   setState(kRestarting);
+}
+
+/**
+ * Changes the state & notifies the UI
+ */
+void DashboardProcess::setState(const State state)
+{
+   if (m_state != state)
+   {
+      m_state = state;
+      emit stateChanged();
+   }
+}
+
+//------------------------------------------------------------------------------
+// Dashboard manager
+//------------------------------------------------------------------------------
+
+/**
+ * Configures the timer that closes the previous dashboard
+ */
+Dashboards::Dashboards()
+   : m_current(kNone)
+   , m_standby(kNone)
+   , m_processId(0)
+{
+   /* The dashboard may be launched before the settings window is loaded */
+   m_priority = qBound<int>(kNormalPriority, AppSettings::read("SettingsWindow/dashboardPriority").toInt(),
+                            kLowestPriority);
+   m_reserveCore = AppSettings::read("SettingsWindow/dashboardReserveCore").toBool();
+   m_limitResources = AppSettings::read("SettingsWindow/dashboardLimits").toBool();
+   m_keepStandby = AppSettings::read("SettingsWindow/dashboardStandby").toBool();
+
+   m_standbyTimer.setSingleShot(true);
+   m_standbyTimer.setInterval(StandbyTimeout);
+   connect(&m_standbyTimer, SIGNAL(timeout()), this, SLOT(closeStandby()));
+}
+
+/**
+ * Closes the dashboards when the application quits
+ */
+Dashboards::~Dashboards()
+{
+   qDeleteAll(m_processes);
+}
+
+/**
+ * Returns the selected dashboard
+ */
+int Dashboards::current() const
+{
+   return m_current;
+}
+
+/**
+ * Returns the state of the selected dashboard, as shown in the UI
+ */
+QString Dashboards::status() const
+{
+   const DashboardProcess *dashboard = m_processes.value(m_current);
+   if (!dashboard)
+      return QString();
+
+   switch (dashboard->state())
+   {
+      case DashboardProcess::kStarting:
+         return tr("Starting...");
+      case DashboardProcess::kReady:
+         return tr("Ready in %1 s").arg(dashboard->readyTime() / 1000.0, 0, 'f', 1);
+      case DashboardProcess::kRestarting:
+         return tr("Crashed, restarting in %1 s").arg(dashboard->restartDelay() / 1000);
+      case DashboardProcess::kClosed:
+         return tr("Closed");
+      case DashboardProcess::kFailed:
+         return tr("Cannot be started");
+      default:
+         return QString();
+   }
+}
+
+/**
+ * Returns the priority of the dashboards (see \c Priority)
+ */
+int Dashboards::priority() const
+{
+   return m_priority;
+}
+
+/**
+ * Returns \c true if the first CPU core is kept free for the DS
+ */
+bool Dashboards::reserveCore() const
+{
+   return m_reserveCore;
+}
+
+/**
+ * Returns \c true if the dashboards are launched with CPU & memory limits
+ */
+bool Dashboards::limitResources() const
+{
+   return m_limitResources && resourceLimitsAvailable();
+}
+
+/**
+ * Returns \c true if the dashboards can be launched with CPU & memory limits
+ */
+bool Dashboards::resourceLimitsAvailable() const
+{
+#if defined Q_OS_LINUX
+   return !QStandardPaths::findExecutable("systemd-run").isEmpty();
+#else
+   return false;
+#endif
+}
+
+/**
+ * Returns \c true if the previous dashboard is kept running for a while
+ * after switching to another dashboard
+ */
+bool Dashboards::keepStandby() const
+{
+   return m_keepStandby;
+}
+
+/**
+ * Returns a list with the available dashboards.
+ * \note This list may differ from operating system to operating system
+ */
+QStringList Dashboards::dashboardList()
+{
+   QStringList list;
+   list.append(tr("None"));
+   list.append(tr("SFX Dashboard"));
+   list.append(tr("SmartDashboard"));
+   list.append(tr("Shuffleboard"));
+
+#if defined Q_OS_WIN
+   list.append(tr("LabVIEW Dashboard"));
+#endif
+
+   return list;
+}
+
+/**
+ * Opens the dashboard saved by the UI (if enabled in the settings window),
+ * so that it starts while the DS and the QML interface are loaded
+ */
+void Dashboards::prelaunch()
+{
+   if (AppSettings::read("SettingsWindow/prelaunchDashboard").toBool())
+   {
+      const int dashboard = AppSettings::read("dashbaord").toInt();
+      if (dashboard > kNone && dashboard < dashboardList().count())
+         openDashboard(dashboard);
+   }
+}
+
+/**
+ * Opens the given \a dashboard. A dashboard that is already running (or that
+ * is in standby) is reused instead of being restarted. The previous dashboard
+ * is closed, or put in standby if switching to another dashboard with
+ * \c keepStandby enabled.
+ */
+void Dashboards::openDashboard(int dashboard)
+{
+   if (dashboard != m_current)
+   {
+      if (m_standby != kNone && m_standby != dashboard && m_processes.contains(m_standby))
+         m_processes.value(m_standby)->stop();
+
+      m_standby = kNone;
+      m_standbyTimer.stop();
+
+      /* Keep the previous dashboard for a while, in case it is selected again */
+      DashboardProcess *previous = m_processes.value(m_current);
+      if (previous && previous->isRunning())
+      {
+         if (m_keepStandby && dashboard != kNone)
+         {
+            m_standby = m_current;
+            m_standbyTimer.start();
+         }
+
+         else
+            previous->stop();
+      }
+
+      m_current = dashboard;
+   }
+
+   DashboardProcess *selected = process(dashboard);
+   if (selected)
+      selected->start();
+
+   updateProcessId();
+   emit statusChanged();
+}
+
+/**
+ * Changes the \a priority of the dashboards launched from now on
+ */
+void Dashboards::setPriority(const int priority)
+{
+   m_priority = qBound<int>(kNormalPriority, priority, kLowestPriority);
+   foreach (DashboardProcess *process, m_processes)
+      configure(process);
+
+   emit limitsChanged();
+}
+
+/**
+ * Keeps (or not) the first CPU core free from the dashboards launched from
+ * now on
+ */
+void Dashboards::setReserveCore(const bool reserve)
+{
+   m_reserveCore = reserve;
+   foreach (DashboardProcess *process, m_processes)
+      configure(process);
+
+   emit limitsChanged();
+}
+
+/**
+ * Enables or disables the CPU & memory limits of the dashboards launched
+ * from now on
+ */
+void Dashboards::setLimitResources(const bool limit)
+{
+   m_limitResources = limit;
+   foreach (DashboardProcess *process, m_processes)
+      configure(process);
+
+   emit limitsChanged();
+}
+
+/**
+ * Keeps (or not) the previous dashboard running for a while after switching
+ * to another dashboard, the dashboard in standby is closed when disabled
+ */
+void Dashboards::setKeepStandby(const bool keep)
+{
+   if (keep != m_keepStandby)
+   {
+      m_keepStandby = keep;
+      if (!m_keepStandby)
+      {
+         m_standbyTimer.stop();
+         closeStandby();
+      }
+
+      emit standbyChanged();
+   }
+}
+
+/**
+ * Closes the previous dashboard once it was not selected for a while
+ */
+void Dashboards::closeStandby()
+{
+   if (m_standby != kNone && m_processes.contains(m_standby))
+      m_processes.value(m_standby)->stop();
+
+   m_standby = kNone;
+}
+
+/**
+ * Notifies the UI when the selected dashboard changes its state
+ */
+void Dashboards::onStateChanged()
+{
+   if (sender() != m_processes.value(m_current))
+      return;
+
+   updateProcessId();
+   emit statusChanged();
+}
+
+/**
+ * Reports the ID of the selected dashboard process when it changes, so that
+ * the resources that it uses can be sampled
+ */
+void Dashboards::updateProcessId()
+{
+   const DashboardProcess *selected = m_processes.value(m_current);
+   const qint64 pid = selected && selected->isRunning() ? selected->processId() : 0;
+   if (pid != m_processId)
+   {
+      m_processId = pid;
+      emit processIdChanged(pid);
+   }
+}
+
+/**
+ * Applies the priority, affinity & resource limits to the given \a process
+ */
+void Dashboards::configure(DashboardProcess *process) const
+{
+   process->setNiceness(NICENESS[m_priority]);
+   process->setReservedCores(m_reserveCore ? 1 : 0);
+   if (limitResources())
+      process->setResourceLimits(CpuQuota, MemoryLimit);
+   else
+      process->setResourceLimits(0, 0);
+}
+
+/**
+ * Returns the process of the given \a dashboard, which is created the first
+ * time that the dashboard is used. Returns \c Q_NULLPTR for \c kNone.
+ */
+DashboardProcess *Dashboards::process(const int dashboard)
+{
+   if (m_processes.contains(dashboard))
+      return m_processes.value(dashboard);
+
+   QString command;
+   bool waitForOutput = true;
+   switch (dashboard)
+   {
+      case kSFXDashboard:
+         command = SFX_COMMAND.arg(QDir::homePath());
+         break;
+      case kSmartDashboard:
+         command = SBD_COMMAND.arg(QDir::homePath());
+         break;
+      case kShuffleboard:
+         command = SHB_COMMAND.arg(QDir::homePath());
+         break;
+#if defined Q_OS_WIN
+      case kLabVIEWDashboard:
+         waitForOutput = false;
+         command = LVD_COMMAND.arg(PROGRAM_FILES);
+         break;
+#endif
+   }
+
+   if (command.isEmpty())
+      return Q_NULLPTR;
+
+   DashboardProcess *process = new DashboardProcess(command, waitForOutput);
+   connect(process, SIGNAL(stateChanged()), this, SLOT(onStateChanged()));
+   configure(process);
+   m_processes.insert(dashboard, process);
+   return process;
+}
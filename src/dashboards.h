@@ -1,57 +1,221 @@
-﻿/*
- * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#ifndef _QDS_DASHBOARDS_H
-#define _QDS_DASHBOARDS_H
-
-#include <QProcess>
-
-/**
- * \brief Opens and closes the available FRC Dashboards
- */
-class Dashboards : public QObject
-{
-   Q_OBJECT
-   Q_ENUMS(DashboardTypes)
-
-public:
-   explicit Dashboards();
-
-   enum DashboardTypes
-   {
-      kNone = 0,
-      kSFXDashboard = 1,
-      kSmartDashboard = 2,
-      kShuffleboard = 3,
-      kLabVIEWDashboard = 4,
-   };
-
-   Q_INVOKABLE QStringList dashboardList();
-
-public slots:
-   void openDashboard(int dashboard);
-
-private:
-   QProcess m_process;
-};
-
-#endif
+﻿/*
+ * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_DASHBOARDS_H
+#define _QDS_DASHBOARDS_H
+
+#include <QHash>
+#include <QTimer>
+#include <QProcess>
+#include <QElapsedTimer>
+
+/**
+ * \brief Runs a dashboard process and keeps it alive
+ *
+ * The process is considered ready when it writes its first line of output
+ * (Java dashboards log while they load), or as soon as it starts for the
+ * dashboards that do not write anything. The time between the launch and
+ * that moment is reported as the launch-to-ready time.
+ *
+ * If the process crashes (or exits with an error) it is started again after
+ * a delay that doubles with every consecutive crash. The delay is reset once
+ * the process stays alive for a while. Processes that exit normally (e.g.
+ * when the user closes the dashboard window) or that cannot be started
+ * (e.g. if Java is not installed) are not started again.
+ */
+class DashboardProcess : public QObject
+{
+   Q_OBJECT
+
+signals:
+   void stateChanged();
+
+public:
+   DashboardProcess(const QString &command, const bool waitForOutput, QObject *parent = Q_NULLPTR);
+   ~DashboardProcess();
+
+   enum State
+   {
+      kStopped,
+      kStarting,
+      kReady,
+      kRestarting,
+      kClosed,
+      kFailed,
+   };
+
+   enum
+   {
+      MinimumBackoff = 1000,
+      MaximumBackoff = 30000,
+      StableTime = 60000,
+   };
+
+   State state() const;
+   bool isRunning() const;
+   qint64 processId() const;
+   qint64 readyTime() const;
+   int restartDelay() const;
+
+   void setNiceness(const int niceness);
+   void setReservedCores(const int cores);
+   void setResourceLimits(const int cpuQuota, const int memoryLimit);
+
+public slots:
+   void start();
+   void stop();
+
+private slots:
+   void launch();
+   void readOutput();
+   void markReady();
+   void onStarted();
+   void resetBackoff();
+   void onError(QProcess::ProcessError error);
+   void onFinished(int exitCode, QProcess::ExitStatus status);
+
+private:
+   void setState(const State state);
+
+private:
+   State m_state;
+   QString m_command;
+   bool m_waitForOutput;
+
+   int m_backoff;
+   qint64 m_readyTime;
+
+   int m_niceness;
+   int m_cpuQuota;
+   int m_memoryLimit;
+   int m_reservedCores;
+
+   QProcess m_process;
+   QElapsedTimer m_clock;
+   QTimer m_stableTimer;
+   QTimer m_restartTimer;
+};
+
+/**
+ * \brief Opens and closes the available FRC Dashboards
+ *
+ * The selected dashboard is kept alive by a \c DashboardProcess, and selecting
+ * it again reuses the running process. When the user selects another
+ * dashboard the previous one is closed, unless \c keepStandby is enabled: in
+ * that case it is kept running for a while, so that switching back does not
+ * pay for another JVM cold start. Selecting "None" always closes it.
+ *
+ * The saved dashboard can be launched before the QML interface is loaded
+ * with \c prelaunch(), so that its cold start overlaps with the DS startup.
+ *
+ * Dashboards (specially the JVM ones while collecting garbage) should not
+ * compete with the DS for the CPU. They are launched with a lower priority,
+ * away from the first CPU core (which is kept for the DS) and optionally in a
+ * cgroup v2 scope with CPU & memory limits (created by \c systemd-run). These
+ * settings are applied when a dashboard is launched.
+ */
+class Dashboards : public QObject
+{
+   Q_OBJECT
+   Q_ENUMS(DashboardTypes)
+   Q_PROPERTY(int current READ current NOTIFY statusChanged)
+   Q_PROPERTY(QString status READ status NOTIFY statusChanged)
+   Q_PROPERTY(int priority READ priority WRITE setPriority NOTIFY limitsChanged)
+   Q_PROPERTY(bool reserveCore READ reserveCore WRITE setReserveCore NOTIFY limitsChanged)
+   Q_PROPERTY(bool limitResources READ limitResources WRITE setLimitResources NOTIFY limitsChanged)
+   Q_PROPERTY(bool keepStandby READ keepStandby WRITE setKeepStandby NOTIFY standbyChanged)
+   Q_PROPERTY(bool resourceLimitsAvailable READ resourceLimitsAvailable CONSTANT)
+
+signals:
+   void statusChanged();
+   void limitsChanged();
+   void standbyChanged();
+   void processIdChanged(const qint64 pid);
+
+public:
+   explicit Dashboards();
+   ~Dashboards();
+
+   enum DashboardTypes
+   {
+      kNone = 0,
+      kSFXDashboard = 1,
+      kSmartDashboard = 2,
+      kShuffleboard = 3,
+      kLabVIEWDashboard = 4,
+   };
+
+   enum Priority
+   {
+      kNormalPriority = 0,
+      kLowPriority = 1,
+      kLowestPriority = 2,
+   };
+
+   enum
+   {
+      StandbyTimeout = 120000,
+      CpuQuota = 50,
+      MemoryLimit = 1024,
+   };
+
+   int current() const;
+   QString status() const;
+
+   int priority() const;
+   bool reserveCore() const;
+   bool limitResources() const;
+   bool resourceLimitsAvailable() const;
+   bool keepStandby() const;
+
+   Q_INVOKABLE QStringList dashboardList();
+
+public slots:
+   void prelaunch();
+   void openDashboard(int dashboard);
+   void setPriority(const int priority);
+   void setReserveCore(const bool reserve);
+   void setLimitResources(const bool limit);
+   void setKeepStandby(const bool keep);
+
+private slots:
+   void closeStandby();
+   void onStateChanged();
+
+private:
+   void updateProcessId();
+   void configure(DashboardProcess *process) const;
+   DashboardProcess *process(const int dashboard);
+
+private:
+   int m_current;
+   int m_standby;
+   int m_priority;
+   bool m_reserveCore;
+   bool m_limitResources;
+   bool m_keepStandby;
+   qint64 m_processId;
+   QTimer m_standbyTimer;
+   QHash<int, DashboardProcess *> m_processes;
+};
+
+#endif
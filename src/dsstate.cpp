@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "dsstate.h"
+
+#include <QDateTime>
+#include <string.h>
+
+#include <DriverStation.h>
+
+/* Names of the columns that do not belong to a joystick */
+static const char *HEADER_COLUMNS[DSState::HeaderColumns] = {
+   "Time",    "Voltage", "Packet Loss", "Control Mode", "Enabled", "E-Stop", "Connected",
+   "CPU",     "RAM",     "CAN",         "Joysticks",
+};
+
+/**
+ * Sets all the values to zero
+ */
+void DSState::clear()
+{
+   memset(this, 0, sizeof(DSState));
+}
+
+/**
+ * Reads the robot status from the \a driverstation, the joystick values are
+ * left untouched. The voltage is stored in hundredths of a volt.
+ */
+void DSState::captureStatus(DriverStation *driverstation)
+{
+   timestamp = QDateTime::currentMSecsSinceEpoch();
+   voltage = static_cast<qint16>(qRound(driverstation->voltage() * 100));
+   packetLoss = static_cast<quint8>(driverstation->robotPacketLoss());
+   controlMode = static_cast<quint8>(driverstation->controlMode());
+   enabled = driverstation->isEnabled();
+   emergencyStopped = driverstation->isEmergencyStopped();
+   connected = driverstation->isConnectedToRobot();
+   cpuUsage = static_cast<quint8>(driverstation->cpuUsage());
+   ramUsage = static_cast<quint8>(driverstation->ramUsage());
+   canUsage = static_cast<quint8>(driverstation->canUsage());
+}
+
+/**
+ * Reads the current status of the \a driverstation and the input state of
+ * the \a joysticks. Axes are stored in thousandths.
+ */
+void DSState::capture(DriverStation *driverstation, const Joysticks *joysticks)
+{
+   clear();
+   captureStatus(driverstation);
+
+   joystickCount = static_cast<quint8>(qMin(joysticks->count(), MAX_JOYSTICKS));
+
+   for (int js = 0; js < joystickCount; ++js)
+   {
+      const JoystickState &state = joysticks->state(js);
+
+      numAxes[js] = static_cast<quint8>(state.numAxes);
+      numHats[js] = static_cast<quint8>(state.numHats);
+      numButtons[js] = static_cast<quint8>(state.numButtons);
+      buttons[js] = state.buttons;
+
+      for (int i = 0; i < state.numAxes; ++i)
+         axes[js][i] = static_cast<qint16>(qRound(state.axes[i] * 1000));
+
+      for (int i = 0; i < state.numHats; ++i)
+         hats[js][i] = state.hats[i];
+   }
+}
+
+/**
+ * Writes the values of the state to the given \a columns, which must have
+ * room for \c ColumnCount values
+ */
+void DSState::toColumns(qint64 *columns) const
+{
+   *columns++ = timestamp;
+   *columns++ = voltage;
+   *columns++ = packetLoss;
+   *columns++ = controlMode;
+   *columns++ = enabled;
+   *columns++ = emergencyStopped;
+   *columns++ = connected;
+   *columns++ = cpuUsage;
+   *columns++ = ramUsage;
+   *columns++ = canUsage;
+   *columns++ = joystickCount;
+
+   for (int js = 0; js < MAX_JOYSTICKS; ++js)
+   {
+      *columns++ = numAxes[js];
+      *columns++ = numHats[js];
+      *columns++ = numButtons[js];
+
+      for (int i = 0; i < MAX_JOYSTICK_AXES; ++i)
+         *columns++ = axes[js][i];
+      for (int i = 0; i < MAX_JOYSTICK_HATS; ++i)
+         *columns++ = hats[js][i];
+
+      *columns++ = buttons[js];
+   }
+}
+
+/**
+ * Reads the values of the state from the given \a columns
+ */
+void DSState::fromColumns(const qint64 *columns)
+{
+   timestamp = *columns++;
+   voltage = static_cast<qint16>(*columns++);
+   packetLoss = static_cast<quint8>(*columns++);
+   controlMode = static_cast<quint8>(*columns++);
+   enabled = static_cast<quint8>(*columns++);
+   emergencyStopped = static_cast<quint8>(*columns++);
+   connected = static_cast<quint8>(*columns++);
+   cpuUsage = static_cast<quint8>(*columns++);
+   ramUsage = static_cast<quint8>(*columns++);
+   canUsage = static_cast<quint8>(*columns++);
+   joystickCount = static_cast<quint8>(*columns++);
+
+   for (int js = 0; js < MAX_JOYSTICKS; ++js)
+   {
+      numAxes[js] = static_cast<quint8>(*columns++);
+      numHats[js] = static_cast<quint8>(*columns++);
+      numButtons[js] = static_cast<quint8>(*columns++);
+
+      for (int i = 0; i < MAX_JOYSTICK_AXES; ++i)
+         axes[js][i] = static_cast<qint16>(*columns++);
+      for (int i = 0; i < MAX_JOYSTICK_HATS; ++i)
+         hats[js][i] = static_cast<qint16>(*columns++);
+
+      buttons[js] = static_cast<quint32>(*columns++);
+   }
+}
+
+/**
+ * Returns the name of the given \a column, used as the CSV header
+ */
+QByteArray DSState::columnName(const int column)
+{
+   if (column < HeaderColumns)
+      return HEADER_COLUMNS[column];
+
+   const int js = (column - HeaderColumns) / JoystickColumns;
+   const int index = (column - HeaderColumns) % JoystickColumns;
+   const QByteArray prefix = "JS" + QByteArray::number(js) + " ";
+
+   if (index == 0)
+      return prefix + "Axes";
+   if (index == 1)
+      return prefix + "POVs";
+   if (index == 2)
+      return prefix + "Buttons";
+   if (index < 3 + MAX_JOYSTICK_AXES)
+      return prefix + "Axis " + QByteArray::number(index - 3);
+   if (index < 3 + MAX_JOYSTICK_AXES + MAX_JOYSTICK_HATS)
+      return prefix + "POV " + QByteArray::number(index - 3 - MAX_JOYSTICK_AXES);
+
+   return prefix + "Button Mask";
+}
+
+/**
+ * Returns the number of decimals of the fixed-point value of the given
+ * \a column (the time is stored in milliseconds)
+ */
+int DSState::columnDecimals(const int column)
+{
+   if (column == 0)
+      return 3;
+   if (column == 1)
+      return 2;
+
+   if (column >= HeaderColumns)
+   {
+      const int index = (column - HeaderColumns) % JoystickColumns;
+      if (index >= 3 && index < 3 + MAX_JOYSTICK_AXES)
+         return 3;
+   }
+
+   return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_DS_STATE_H
+#define _QDS_DS_STATE_H
+
+#include "joysticks.h"
+
+#include <DriverStation.h>
+
+/**
+ * \brief Snapshot of the robot status & joystick input during a control packet
+ *
+ * All values are stored as fixed-point integers, so that they can be stored in
+ * columns and delta-encoded by the recorder.
+ */
+struct DSState
+{
+   enum
+   {
+      HeaderColumns = 11,
+      JoystickColumns = 3 + MAX_JOYSTICK_AXES + MAX_JOYSTICK_HATS + 1,
+      ColumnCount = HeaderColumns + MAX_JOYSTICKS * JoystickColumns,
+   };
+
+   qint64 timestamp;
+   qint16 voltage;
+   quint8 packetLoss;
+   quint8 controlMode;
+   quint8 enabled;
+   quint8 emergencyStopped;
+   quint8 connected;
+   quint8 cpuUsage;
+   quint8 ramUsage;
+   quint8 canUsage;
+   quint8 joystickCount;
+
+   quint8 numAxes[MAX_JOYSTICKS];
+   quint8 numHats[MAX_JOYSTICKS];
+   quint8 numButtons[MAX_JOYSTICKS];
+   qint16 axes[MAX_JOYSTICKS][MAX_JOYSTICK_AXES];
+   qint16 hats[MAX_JOYSTICKS][MAX_JOYSTICK_HATS];
+   quint32 buttons[MAX_JOYSTICKS];
+
+   void clear();
+   void captureStatus(DriverStation *driverstation);
+   void capture(DriverStation *driverstation, const Joysticks *joysticks);
+
+   template <typename Receiver>
+   static void connectStatus(DriverStation *driverstation, Receiver *receiver, void (Receiver::*slot)());
+
+   void toColumns(qint64 *columns) const;
+   void fromColumns(const qint64 *columns);
+
+   static QByteArray columnName(const int column);
+   static int columnDecimals(const int column);
+};
+
+/**
+ * Calls the \a slot of the \a receiver when the DS reports a change in the
+ * values read by \c captureStatus() (except for the robot diagnostics, which
+ * are updated with every status packet)
+ */
+template <typename Receiver>
+void DSState::connectStatus(DriverStation *driverstation, Receiver *receiver, void (Receiver::*slot)())
+{
+   QObject::connect(driverstation, &DriverStation::voltageChanged, receiver, slot);
+   QObject::connect(driverstation, &DriverStation::controlModeChanged, receiver, slot);
+   QObject::connect(driverstation, &DriverStation::enabledChanged, receiver, slot);
+   QObject::connect(driverstation, &DriverStation::emergencyStoppedChanged, receiver, slot);
+   QObject::connect(driverstation, &DriverStation::connectedToRobotChanged, receiver, slot);
+}
+
+#endif
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "floodcontrol.h"
+#include "messagemodel.h"
+
+#include <QDateTime>
+
+/**
+ * Returns the name of the given message source, as shown in the console
+ */
+static QString SourceName(const int source)
+{
+   switch (source)
+   {
+      case MessageModel::kOutput:
+         return QObject::tr("robot output");
+      case MessageModel::kInformation:
+         return QObject::tr("information");
+      case MessageModel::kWarning:
+         return QObject::tr("warning");
+      default:
+         return QObject::tr("error");
+   }
+}
+
+FloodControl::FloodControl()
+   : m_received(0)
+   , m_collapsed(0)
+   , m_dropped(0)
+   , m_changed(false)
+   , m_repeats(0)
+{
+   m_clock.start();
+   for (int i = 0; i < SourceCount; ++i)
+   {
+      m_sources[i].tokens = Burst;
+      m_sources[i].refilled = 0;
+      m_sources[i].dropped = 0;
+   }
+
+   m_timer.setInterval(PublishInterval);
+   m_timer.setTimerType(Qt::CoarseTimer);
+   connect(&m_timer, SIGNAL(timeout()), this, SLOT(publish()));
+   m_timer.start();
+}
+
+/**
+ * Returns the number of messages received from the DS
+ */
+quint64 FloodControl::received() const
+{
+   return m_received;
+}
+
+/**
+ * Returns the number of messages that were collapsed into a previous,
+ * identical message
+ */
+quint64 FloodControl::collapsed() const
+{
+   return m_collapsed;
+}
+
+/**
+ * Returns the number of messages dropped by the rate limit
+ */
+quint64 FloodControl::dropped() const
+{
+   return m_dropped;
+}
+
+/**
+ * Resets the counters and forgets the last message, the messages dropped so
+ * far are still reported
+ */
+void FloodControl::resetCounters()
+{
+   m_repeats = 0;
+   m_last.clear();
+
+   m_received = 0;
+   m_collapsed = 0;
+   m_dropped = 0;
+   m_changed = false;
+
+   emit countersChanged();
+}
+
+/**
+ * Forwards the given \a message to the console, collapses it into the
+ * previous one or drops it
+ */
+void FloodControl::ingest(const QString &message)
+{
+   ++m_received;
+   m_changed = true;
+
+   /* Repetitions do not use tokens, they only update the first message */
+   if (m_repeats > 0 && message == m_last)
+   {
+      ++m_repeats;
+      ++m_collapsed;
+      emit messageRepeated(m_repeats, QDateTime::currentMSecsSinceEpoch());
+      return;
+   }
+
+   /* Drop the message if its source is flooding the console */
+   Source &source = m_sources[MessageModel::severityOf(message)];
+   if (!take(source, m_clock.elapsed()))
+   {
+      ++source.dropped;
+      ++m_dropped;
+      m_repeats = 0;
+      m_last.clear();
+      return;
+   }
+
+   m_last = message;
+   m_repeats = 1;
+   emit messageAccepted(message);
+}
+
+/**
+ * Reports the messages dropped by the sources that can send messages again
+ * and notifies the UI if the counters changed
+ */
+void FloodControl::publish()
+{
+   const qint64 now = m_clock.elapsed();
+   for (int i = 0; i < SourceCount; ++i)
+   {
+      Source &source = m_sources[i];
+      if (source.dropped == 0 || !take(source, now))
+         continue;
+
+      /* The report starts a new entry, so it breaks any repetition */
+      m_repeats = 0;
+      m_last.clear();
+
+      emit messageAccepted(QString("<font color=#888>** <font color=#FC0>%1:</font> %2</font>")
+                              .arg(tr("Warning"))
+                              .arg(tr("%1 %2 messages were suppressed").arg(source.dropped).arg(SourceName(i))));
+      source.dropped = 0;
+   }
+
+   if (m_changed)
+   {
+      m_changed = false;
+      emit countersChanged();
+   }
+}
+
+/**
+ * Refills the bucket of the given \a source and takes a token from it,
+ * returns \c false if the bucket is empty
+ */
+bool FloodControl::take(Source &source, const qint64 now)
+{
+   source.tokens = qMin<double>(Burst, source.tokens + (now - source.refilled) * Rate / 1000.0);
+   source.refilled = now;
+
+   if (source.tokens < 1)
+      return false;
+
+   source.tokens -= 1;
+   return true;
+}
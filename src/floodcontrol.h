@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_FLOOD_CONTROL_H
+#define _QDS_FLOOD_CONTROL_H
+
+#include <QTimer>
+#include <QObject>
+#include <QElapsedTimer>
+
+/**
+ * \brief Ingestion stage between the DS messages and the console
+ *
+ * Consecutive identical messages are collapsed into the first one, which only
+ * gets its counter and the time of the last repetition updated.
+ *
+ * Every message source (robot output, DS information, warnings and errors)
+ * has its own token bucket, so a robot program printing in a loop cannot
+ * push the DS errors out of the console. Messages that arrive while the
+ * bucket of their source is empty are dropped and counted, and a single line
+ * reporting the exact number of dropped messages is shown once the source
+ * calms down.
+ */
+class FloodControl : public QObject
+{
+   Q_OBJECT
+   Q_PROPERTY(quint64 received READ received NOTIFY countersChanged)
+   Q_PROPERTY(quint64 collapsed READ collapsed NOTIFY countersChanged)
+   Q_PROPERTY(quint64 dropped READ dropped NOTIFY countersChanged)
+
+signals:
+   void countersChanged();
+   void messageAccepted(const QString &message);
+   void messageRepeated(const int count, const qint64 time);
+
+public:
+   FloodControl();
+
+   enum
+   {
+      SourceCount = 4,
+      Rate = 50,
+      Burst = 200,
+      PublishInterval = 1000,
+   };
+
+   quint64 received() const;
+   quint64 collapsed() const;
+   quint64 dropped() const;
+
+public slots:
+   void resetCounters();
+   void ingest(const QString &message);
+
+private slots:
+   void publish();
+
+private:
+   /**
+    * \brief Token bucket and drop counter of a message source
+    */
+   struct Source
+   {
+      double tokens;
+      qint64 refilled;
+      quint64 dropped;
+   };
+
+   bool take(Source &source, const qint64 now);
+
+private:
+   quint64 m_received;
+   quint64 m_collapsed;
+   quint64 m_dropped;
+   bool m_changed;
+
+   QString m_last;
+   int m_repeats;
+
+   QTimer m_timer;
+   QElapsedTimer m_clock;
+   Source m_sources[SourceCount];
+};
+
+#endif
@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "headless.h"
+#include "joysticks.h"
+#include "sdlloader.h"
+#include "shortcuts.h"
+#include "utilities.h"
+#include "controlserver.h"
+#include "statepublisher.h"
+#include "floodcontrol.h"
+#include "appsettings.h"
+
+#include <stdio.h>
+
+#include <QTime>
+#include <QSettings>
+#include <QCoreApplication>
+
+#include <DriverStation.h>
+
+/* Names of the status values, in the order used by printStatus() */
+static const char *STATUS_NAMES[Headless::StatusCount] = {
+   "teamNumber", "station",     "connectedToFMS", "connectedToRadio", "connectedToRobot",
+   "robotCode",  "controlMode", "enabled",        "emergencyStopped", "status",
+};
+
+/* Names of the control modes (test, autonomous & teleoperated) */
+static const char *CONTROL_MODES[] = { "Test", "Autonomous", "Teleoperated" };
+
+/**
+ * Returns "true" or "false"
+ */
+static QString Boolean(const bool value)
+{
+   return value ? "true" : "false";
+}
+
+/**
+ * Returns the value given after the \a name option, or an empty string
+ */
+static QString Option(const QStringList &arguments, const QString &name)
+{
+   const int index = arguments.indexOf(name);
+   if (index < 0 || index + 1 >= arguments.count())
+      return QString();
+
+   return arguments.at(index + 1);
+}
+
+/**
+ * Lowercases \a text and removes its spaces, so that "red1" matches "Red 1"
+ */
+static QString Simplified(const QString &text)
+{
+   return text.toLower().remove(' ');
+}
+
+/**
+ * Returns the index of the entry of \a list that is named \a value, or the
+ * only entry that contains \a value (e.g. "2020" for "FRC 2020"), or -1
+ */
+static int Find(const QStringList &list, const QString &value)
+{
+   const QString key = Simplified(value);
+   for (int i = 0; i < list.count(); ++i)
+   {
+      if (Simplified(list.at(i)) == key)
+         return i;
+   }
+
+   int match = -1;
+   for (int i = 0; i < list.count(); ++i)
+   {
+      if (Simplified(list.at(i)).contains(key))
+      {
+         if (match >= 0)
+            return -1;
+
+         match = i;
+      }
+   }
+
+   return match;
+}
+
+/**
+ * Removes the HTML tags used by the DS messages
+ */
+static QString PlainText(const QString &html)
+{
+   QString text;
+   bool tag = false;
+   text.reserve(html.length());
+   for (int i = 0; i < html.length(); ++i)
+   {
+      const QChar c = html.at(i);
+      if (c == '<')
+         tag = true;
+      else if (c == '>')
+         tag = false;
+      else if (!tag)
+         text.append(c);
+   }
+
+   text.replace("&nbsp;", " ");
+   text.replace("&lt;", "<");
+   text.replace("&gt;", ">");
+   text.replace("&amp;", "&");
+   return text.trimmed();
+}
+
+/**
+ * Watches the DS properties that describe the robot status
+ */
+Headless::Headless(DriverStation *driverstation, Utilities *utilities)
+   : m_driverstation(driverstation)
+   , m_utilities(utilities)
+   , m_repeats(0)
+   , m_printedRepeats(0)
+   , m_batteryLevel(-1)
+   , m_connectedToAC(false)
+   , m_statusPrinted(false)
+{
+   /* Report the repetitions of a message storm while it is still going on */
+   m_repeatTimer.setSingleShot(true);
+   m_repeatTimer.setInterval(RepeatInterval);
+   connect(&m_repeatTimer, SIGNAL(timeout()), this, SLOT(printRepeats()));
+
+   connect(m_driverstation, &DriverStation::teamNumberChanged, this, &Headless::printStatus);
+   connect(m_driverstation, &DriverStation::stationChanged, this, &Headless::printStatus);
+   connect(m_driverstation, &DriverStation::connectedToFMSChanged, this, &Headless::printStatus);
+   connect(m_driverstation, &DriverStation::connectedToRadioChanged, this, &Headless::printStatus);
+   connect(m_driverstation, &DriverStation::connectedToRobotChanged, this, &Headless::printStatus);
+   connect(m_driverstation, &DriverStation::robotCodeChanged, this, &Headless::printStatus);
+   connect(m_driverstation, &DriverStation::controlModeChanged, this, &Headless::printStatus);
+   connect(m_driverstation, &DriverStation::enabledChanged, this, &Headless::printStatus);
+   connect(m_driverstation, &DriverStation::emergencyStoppedChanged, this, &Headless::printStatus);
+   connect(m_driverstation, &DriverStation::statusChanged, this, &Headless::printStatus);
+
+   connect(m_utilities, SIGNAL(batteryLevelChanged()), this, SLOT(printBattery()));
+   connect(m_utilities, SIGNAL(connectedToACChanged()), this, SLOT(printBattery()));
+}
+
+/**
+ * Applies the team number, protocol, station and game data given in the
+ * command line (or the ones saved by the interface if not given).
+ * Returns \c false if any of the given values is not valid.
+ */
+bool Headless::configure(const QStringList &arguments)
+{
+   QSettings settings(qApp->organizationName(), qApp->applicationName());
+
+   /* Changing the protocol resets the robot address, so it goes first */
+   const QString protocol = Option(arguments, "--protocol");
+   if (!protocol.isEmpty())
+   {
+      const QStringList protocols = m_driverstation->protocols();
+      const int index = Find(protocols, protocol);
+      if (index < 0)
+      {
+         print(tr("Unknown protocol \"%1\", use one of: %2").arg(protocol, protocols.join(", ")));
+         return false;
+      }
+
+      m_driverstation->setProtocol(index);
+   }
+
+   /* Use the robot address set in the settings window */
+   m_driverstation->setCustomRobotAddress(AppSettings::read("SettingsWindow/address").toString());
+
+   /* Team number */
+   const QString team = Option(arguments, "--team");
+   if (!team.isEmpty())
+   {
+      bool ok = false;
+      const int number = team.toInt(&ok);
+      if (!ok || number < 0)
+      {
+         print(tr("Invalid team number \"%1\"").arg(team));
+         return false;
+      }
+
+      m_driverstation->setTeamNumber(number);
+   }
+
+   else if (settings.contains("team"))
+      m_driverstation->setTeamNumber(settings.value("team").toInt());
+
+   /* Team station */
+   const QString station = Option(arguments, "--station");
+   if (!station.isEmpty())
+   {
+      const QStringList stations = m_driverstation->stations();
+      const int index = Find(stations, station);
+      if (index < 0)
+      {
+         print(tr("Unknown station \"%1\", use one of: %2").arg(station, stations.join(", ")));
+         return false;
+      }
+
+      m_driverstation->setStation(index);
+   }
+
+   /* Game data */
+   if (arguments.contains("--game-data"))
+      m_driverstation->setGameData(Option(arguments, "--game-data"));
+   else if (settings.contains("gameDataStr"))
+      m_driverstation->setGameData(settings.value("gameDataStr").toString());
+
+   return true;
+}
+
+/**
+ * Runs the DS, the joysticks and the host probes until the application is
+ * closed, without loading the QML interface or the audio subsystem
+ */
+int Headless::run(const QStringList &arguments)
+{
+   /* Only the joysticks are used, nothing is ever played */
+   SdlLoader sdl(false);
+
+   /* Start the host probes & the DS */
+   Utilities utilities;
+   FloodControl floodControl;
+   DriverStation *driverstation = DriverStation::getInstance();
+   Headless headless(driverstation, &utilities);
+   connect(driverstation, SIGNAL(newMessage(QString)), &floodControl, SLOT(ingest(QString)));
+   connect(&floodControl, SIGNAL(messageAccepted(QString)), &headless, SLOT(printMessage(QString)));
+   connect(&floodControl, SIGNAL(messageRepeated(int, qint64)), &headless, SLOT(printRepeated(int, qint64)));
+   if (!headless.configure(arguments))
+      return EXIT_FAILURE;
+
+   driverstation->start();
+
+   /* Enumerate the joysticks & forward their input to the DS */
+   sdl.wait();
+   Joysticks joysticks;
+
+   /* Trigger the emergency stop with the configured joystick button */
+   Shortcuts shortcuts(driverstation);
+   shortcuts.watchJoysticks();
+
+   /* Publish the robot status & joystick input to local tools */
+   ControlServer controlServer(driverstation, &joysticks);
+   controlServer.listen();
+
+   /* Publish the DS state to other processes through shared memory */
+   StatePublisher statePublisher(driverstation, &joysticks);
+   statePublisher.open();
+
+   /* Print the initial status, then every change */
+   headless.printStatus();
+   return QCoreApplication::exec();
+}
+
+/**
+ * Writes the given DS \a message without its HTML formatting
+ */
+void Headless::printMessage(const QString &message)
+{
+   printRepeats();
+   m_repeatTimer.stop();
+
+   m_repeats = 0;
+   m_printedRepeats = 0;
+   print(PlainText(message));
+}
+
+/**
+ * Counts the repetitions of the last message, the count is written at most
+ * once per \c RepeatInterval and before the next message
+ */
+void Headless::printRepeated(const int count, const qint64 time)
+{
+   Q_UNUSED(time);
+
+   m_repeats = count;
+   if (!m_repeatTimer.isActive())
+      m_repeatTimer.start();
+}
+
+/**
+ * Writes the repetitions of the last message that have not been reported
+ */
+void Headless::printRepeats()
+{
+   if (m_repeats > 1 && m_repeats > m_printedRepeats)
+   {
+      print(tr("Last message repeated %1 times").arg(m_repeats));
+      m_printedRepeats = m_repeats;
+   }
+}
+
+/**
+ * Writes the robot status values that changed since the last call
+ */
+void Headless::printStatus()
+{
+   const int mode = m_driverstation->controlMode();
+   const QString values[StatusCount] = {
+      QString::number(m_driverstation->teamNumber()),
+      m_driverstation->stations().value(m_driverstation->station()),
+      Boolean(m_driverstation->isConnectedToFMS()),
+      Boolean(m_driverstation->isConnectedToRadio()),
+      Boolean(m_driverstation->isConnectedToRobot()),
+      Boolean(m_driverstation->hasRobotCode()),
+      mode >= 0 && mode < 3 ? CONTROL_MODES[mode] : QString::number(mode),
+      Boolean(m_driverstation->isEnabled()),
+      Boolean(m_driverstation->isEmergencyStopped()),
+      m_driverstation->status(),
+   };
+
+   for (int i = 0; i < StatusCount; ++i)
+   {
+      if (m_statusPrinted && m_values[i] == values[i])
+         continue;
+
+      m_values[i] = values[i];
+      print(QString("%1: %2").arg(STATUS_NAMES[i], values[i]));
+   }
+
+   m_statusPrinted = true;
+}
+
+/**
+ * Writes the laptop battery status when the power supply changes or the
+ * battery level crosses a multiple of 10 %
+ */
+void Headless::printBattery()
+{
+   const int level = m_utilities->batteryLevel();
+   const bool ac = m_utilities->isConnectedToAC();
+   if (m_batteryLevel >= 0 && ac == m_connectedToAC && level / 10 == m_batteryLevel / 10)
+      return;
+
+   m_batteryLevel = level;
+   m_connectedToAC = ac;
+   print(tr("Battery: %1 % (%2)").arg(level).arg(ac ? tr("AC") : tr("discharging")));
+}
+
+/**
+ * Writes a timestamped line to the standard output
+ */
+void Headless::print(const QString &text)
+{
+   const QString line = QTime::currentTime().toString("hh:mm:ss.zzz") + "  " + text + "\n";
+   fputs(line.toLocal8Bit().constData(), stdout);
+   fflush(stdout);
+}
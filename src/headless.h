@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_HEADLESS_H
+#define _QDS_HEADLESS_H
+
+#include <QTimer>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class Utilities;
+class DriverStation;
+
+/**
+ * \brief Runs the DS without the QML interface
+ *
+ * The DS, QJoysticks and the host probes run on a \c QCoreApplication, so
+ * no QML engine, window or font is ever created. The team number, protocol,
+ * station and game data are read from the command line and every change in
+ * the robot status is written to the standard output, one line per change.
+ */
+class Headless : public QObject
+{
+   Q_OBJECT
+
+public:
+   enum
+   {
+      StatusCount = 10,
+      RepeatInterval = 1000,
+   };
+
+   explicit Headless(DriverStation *driverstation, Utilities *utilities);
+
+   bool configure(const QStringList &arguments);
+   static int run(const QStringList &arguments);
+
+public slots:
+   void printMessage(const QString &message);
+   void printRepeated(const int count, const qint64 time);
+
+private slots:
+   void printStatus();
+   void printRepeats();
+   void printBattery();
+
+private:
+   void print(const QString &text);
+
+private:
+   DriverStation *m_driverstation;
+   Utilities *m_utilities;
+
+   int m_repeats;
+   int m_printedRepeats;
+   QTimer m_repeatTimer;
+
+   int m_batteryLevel;
+   bool m_connectedToAC;
+
+   bool m_statusPrinted;
+   QString m_values[StatusCount];
+};
+
+#endif
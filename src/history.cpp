@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "history.h"
+#include "dsstate.h"
+#include "utilities.h"
+
+#include <QtMath>
+#include <limits>
+
+/* Index of the buckets that hold no samples */
+static const qint64 INVALID_INDEX = std::numeric_limits<qint64>::min();
+
+/**
+ * Allocates the buckets of all the levels and starts sampling the values of
+ * the given \a driverstation & \a utilities objects
+ */
+History::History(DriverStation *driverstation, Utilities *utilities)
+{
+   m_tick = 0;
+   m_utilities = utilities;
+   m_driverstation = driverstation;
+
+   m_buckets.resize(ChannelCount * LevelCount * BucketCount);
+   clear();
+
+   m_clock.start();
+   m_timer.setInterval(BasePeriod);
+   m_timer.setTimerType(Qt::PreciseTimer);
+   connect(&m_timer, SIGNAL(timeout()), this, SLOT(sample()));
+   m_timer.start();
+}
+
+/**
+ * Returns the index of the newest column that has been completed, when the
+ * last \a seconds are divided in the given number of \a columns. The columns
+ * are aligned to the start of the history, so a column keeps its index (and
+ * its contents) while the window moves.
+ */
+qint64 History::lastColumn(const qreal seconds, const int columns) const
+{
+   if (columns <= 0)
+      return 0;
+
+   const double step = qMax(1.0, seconds * 1000 / BasePeriod) / columns;
+   return qFloor((m_tick + 1) / step) - 1;
+}
+
+/**
+ * Summarizes the samples of the given \a channel, the last \a seconds are
+ * divided in the given number of \a columns and the \a points vector is
+ * filled with the columns that start at the \a first column index. Columns
+ * without samples have a count of zero.
+ */
+void History::read(const int channel, const qreal seconds, const int columns, const qint64 first,
+                   QVector<HistoryPoint> &points) const
+{
+   if (columns <= 0 || channel < 0 || channel >= ChannelCount)
+      return;
+
+   /* Get the number of ticks of the window and of each column */
+   const double span = qMax(1.0, seconds * 1000 / BasePeriod);
+   const double step = span / columns;
+
+   /* Use the finest level that still covers the window, with buckets that
+    * are not longer than a column */
+   int level = 0;
+   while (level < LevelCount - 1
+          && ((qint64(1) << (2 * (level + 1))) <= step || (qint64(BucketCount) << (2 * level)) < span))
+      ++level;
+
+   /* Combine the buckets of each column */
+   const int shift = 2 * level;
+   for (int i = 0; i < points.count(); ++i)
+   {
+      const qint64 from = qFloor((first + i) * step);
+      const qint64 to = qMax<qint64>(from, qFloor((first + i + 1) * step) - 1);
+
+      float sum = 0;
+      HistoryPoint &point = points[i];
+      point.min = 0;
+      point.max = 0;
+      point.mean = 0;
+      point.count = 0;
+
+      /* The column is older than the history */
+      if (to < 0)
+         continue;
+
+      for (qint64 index = qMax<qint64>(0, from) >> shift; index <= (to >> shift); ++index)
+      {
+         const Bucket *b = bucket(channel, level, index);
+         if (b->index != index || b->count == 0)
+            continue;
+
+         point.min = point.count ? qMin(point.min, b->min) : b->min;
+         point.max = point.count ? qMax(point.max, b->max) : b->max;
+         point.count += b->count;
+         sum += b->sum;
+      }
+
+      if (point.count > 0)
+         point.mean = sum / point.count;
+   }
+}
+
+/**
+ * Removes all the stored samples
+ */
+void History::clear()
+{
+   for (int i = 0; i < m_buckets.count(); ++i)
+   {
+      Bucket &b = m_buckets[i];
+      b.index = INVALID_INDEX;
+      b.min = 0;
+      b.max = 0;
+      b.sum = 0;
+      b.count = 0;
+   }
+}
+
+/**
+ * Adds the given \a value to the current bucket of each level of the given
+ * \a channel
+ */
+void History::append(const int channel, const float value)
+{
+   if (channel < 0 || channel >= ChannelCount)
+      return;
+
+   for (int level = 0; level < LevelCount; ++level)
+   {
+      const qint64 index = m_tick >> (2 * level);
+
+      /* The bucket holds an old interval, reuse it */
+      Bucket *b = bucket(channel, level, index);
+      if (b->index != index)
+      {
+         b->index = index;
+         b->min = value;
+         b->max = value;
+         b->sum = 0;
+         b->count = 0;
+      }
+
+      b->min = qMin(b->min, value);
+      b->max = qMax(b->max, value);
+      b->sum += value;
+      ++b->count;
+   }
+}
+
+/**
+ * Reads the current values of the robot & the computer. The time is obtained
+ * from a monotonic clock, so that a late timer does not shift the buckets.
+ */
+void History::sample()
+{
+   m_tick = m_clock.elapsed() / BasePeriod;
+
+   DSState status;
+   status.captureStatus(m_driverstation);
+   if (status.connected)
+   {
+      append(kVoltage, status.voltage / 100.0f);
+      append(kPacketLoss, status.packetLoss);
+      append(kRobotCpu, status.cpuUsage);
+      append(kRobotRam, status.ramUsage);
+   }
+
+   append(kHostCpu, m_utilities->cpuUsage());
+}
+
+/**
+ * Returns the bucket of the given \a level & \a channel used by the interval
+ * with the given \a index
+ */
+History::Bucket *History::bucket(const int channel, const int level, const qint64 index)
+{
+   return m_buckets.data() + ((channel * LevelCount + level) * BucketCount) + (index & (BucketCount - 1));
+}
+
+/**
+ * Returns the bucket of the given \a level & \a channel used by the interval
+ * with the given \a index
+ */
+const History::Bucket *History::bucket(const int channel, const int level, const qint64 index) const
+{
+   return m_buckets.constData() + ((channel * LevelCount + level) * BucketCount) + (index & (BucketCount - 1));
+}
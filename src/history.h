@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_HISTORY_H
+#define _QDS_HISTORY_H
+
+#include <QTimer>
+#include <QVector>
+#include <QObject>
+#include <QElapsedTimer>
+
+class Utilities;
+class DriverStation;
+
+/**
+ * \brief Summary of the samples of a time interval
+ */
+struct HistoryPoint
+{
+   float min;
+   float max;
+   float mean;
+   quint32 count;
+};
+
+/**
+ * \brief Fixed-memory store of the robot & host telemetry
+ *
+ * Each channel is sampled every 50 ms. The samples are summarized (min, max
+ * and mean) in several levels, the first level holds a bucket for every
+ * 50 ms and each next level holds buckets four times longer than the ones of
+ * the previous level. Each level is a ring of 2048 buckets, so the first level
+ * covers about 100 seconds and the last level covers more than seven hours.
+ *
+ * Any time window can be drawn by reading the level whose buckets are closest
+ * to the duration of a column, so the raw samples are never scanned again.
+ * The columns are aligned to the start of the history, so a chart only has to
+ * read the columns completed since its last read.
+ * Robot values are only stored while the DS is connected to the robot, the
+ * buckets without samples are reported as gaps.
+ */
+class History : public QObject
+{
+   Q_OBJECT
+   Q_ENUMS(Channels)
+
+public:
+   explicit History(DriverStation *driverstation, Utilities *utilities);
+
+   enum Channels
+   {
+      kVoltage = 0,
+      kPacketLoss = 1,
+      kRobotCpu = 2,
+      kRobotRam = 3,
+      kHostCpu = 4,
+   };
+
+   enum
+   {
+      ChannelCount = 5,
+      LevelCount = 5,
+      BucketCount = 2048,
+      BasePeriod = 50,
+   };
+
+   qint64 lastColumn(const qreal seconds, const int columns) const;
+   void read(const int channel, const qreal seconds, const int columns, const qint64 first,
+             QVector<HistoryPoint> &points) const;
+
+public slots:
+   void clear();
+   void append(const int channel, const float value);
+
+private slots:
+   void sample();
+
+private:
+   /**
+    * \brief Summary of the samples of a bucket of a level
+    */
+   struct Bucket
+   {
+      qint64 index;
+      float min;
+      float max;
+      float sum;
+      quint32 count;
+   };
+
+   Bucket *bucket(const int channel, const int level, const qint64 index);
+   const Bucket *bucket(const int channel, const int level, const qint64 index) const;
+
+private:
+   qint64 m_tick;
+   QTimer m_timer;
+   QElapsedTimer m_clock;
+   QVector<Bucket> m_buckets;
+
+   Utilities *m_utilities;
+   DriverStation *m_driverstation;
+};
+
+#endif
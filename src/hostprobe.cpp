@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "hostprobe.h"
+
+#include <QProcess>
+
+#if defined Q_OS_LINUX
+#   include "cpusampler.h"
+#   include "powersupply.h"
+#endif
+
+//------------------------------------------------------------------------------
+// Windows hacks
+//------------------------------------------------------------------------------
+
+#if defined Q_OS_WIN
+#   include <pdh.h>
+#   include <tchar.h>
+#   include <windows.h>
+#   include <windowsx.h>
+
+static PDH_HQUERY cpuQuery;
+static PDH_HCOUNTER cpuTotal;
+static SYSTEM_POWER_STATUS power;
+#endif
+
+//------------------------------------------------------------------------------
+// Mac OS hacks
+//------------------------------------------------------------------------------
+
+#if defined Q_OS_MAC
+static const QString CPU_CMD = "bash -c \"ps -A -o %cpu | "
+                               "awk '{s+=$1} END {print s}'\"";
+static const QString BTY_CMD = "pmset -g batt";
+static const QString PWR_CMD = "pmset -g batt";
+#endif
+
+//------------------------------------------------------------------------------
+// Ensure that application compiles even if OS is not supported
+//------------------------------------------------------------------------------
+
+#if !defined Q_OS_WIN && !defined Q_OS_MAC && !defined Q_OS_LINUX
+static const QString CPU_CMD = "";
+static const QString BTY_CMD = "";
+static const QString PWR_CMD = "";
+#endif
+
+//------------------------------------------------------------------------------
+// Start class code
+//------------------------------------------------------------------------------
+
+/**
+ * Initializes the sample values. The probes themselves are created by the
+ * \c start() function, so that they belong to the thread of the probe.
+ */
+HostProbe::HostProbe()
+{
+   m_timer = Q_NULLPTR;
+   m_dashboardPid = 0;
+   m_cpuSampler = Q_NULLPTR;
+   m_powerSupply = Q_NULLPTR;
+   m_cpuProcess = Q_NULLPTR;
+   m_batteryLevelProcess = Q_NULLPTR;
+   m_connectedToACProcess = Q_NULLPTR;
+
+   m_published.cpuUsage = -1;
+   m_published.batteryLevel = -1;
+}
+
+/**
+ * Kills the probing processes and releases the OS-specific probes
+ */
+HostProbe::~HostProbe()
+{
+#if defined Q_OS_WIN
+   if (m_timer)
+      PdhCloseQuery(cpuQuery);
+#endif
+
+   if (m_cpuProcess)
+      m_cpuProcess->kill();
+   if (m_batteryLevelProcess)
+      m_batteryLevelProcess->kill();
+   if (m_connectedToACProcess)
+      m_connectedToACProcess->kill();
+
+#if defined Q_OS_LINUX
+   delete m_cpuSampler;
+#endif
+}
+
+/**
+ * Creates the OS-specific probes and starts the sampling loop.
+ * \note This function must be called from the thread of the probe
+ */
+void HostProbe::start()
+{
+   if (m_timer)
+      return;
+
+   /* Configure Windows */
+#if defined Q_OS_WIN
+   PdhOpenQuery(0, 0, &cpuQuery);
+   PdhAddCounter(cpuQuery, L"\\Processor(_Total)\\% Processor Time", 0, &cpuTotal);
+   PdhCollectQueryData(cpuQuery);
+#endif
+
+   /* Battery information is pushed by the power supply class on GNU/Linux */
+#if defined Q_OS_LINUX
+   m_cpuSampler = new CpuSampler;
+   m_cpuSampler->setChildProcess(static_cast<int>(m_dashboardPid));
+   m_powerSupply = new PowerSupply;
+   m_powerSupply->setParent(this);
+   connect(m_powerSupply, SIGNAL(changed()), this, SLOT(readPowerSupply()));
+   m_sample.batteryLevel = m_powerSupply->batteryLevel();
+   m_sample.connectedToAC = m_powerSupply->isConnectedToAC();
+#else
+   /* Read process data when they finish */
+   m_cpuProcess = new QProcess(this);
+   m_batteryLevelProcess = new QProcess(this);
+   m_connectedToACProcess = new QProcess(this);
+   connect(m_cpuProcess, SIGNAL(finished(int)), this, SLOT(readCpuUsageProcess(int)));
+   connect(m_batteryLevelProcess, SIGNAL(finished(int)), this, SLOT(readBatteryLevelProcess(int)));
+   connect(m_connectedToACProcess, SIGNAL(finished(int)), this, SLOT(readConnectedToACProcess(int)));
+#endif
+
+   /* Start loop */
+   m_timer = new QTimer(this);
+   m_timer->setInterval(1000);
+   m_timer->setTimerType(Qt::PreciseTimer);
+   connect(m_timer, SIGNAL(timeout()), this, SLOT(update()));
+   m_timer->start();
+   update();
+}
+
+/**
+ * Samples the CPU & memory usage of the dashboard process with the given
+ * \a pid, or stops sampling it if \a pid is 0.
+ * \note The dashboard is only sampled on GNU/Linux
+ */
+void HostProbe::setDashboardProcess(const qint64 pid)
+{
+   m_dashboardPid = pid;
+
+#if defined Q_OS_LINUX
+   if (m_cpuSampler)
+      m_cpuSampler->setChildProcess(static_cast<int>(pid));
+#endif
+}
+
+/**
+ * Queries the synchronous probes, publishes the results obtained since the
+ * last call and launches the asynchronous probes. The results of the probing
+ * processes are published on the next call to this function.
+ */
+void HostProbe::update()
+{
+#if defined Q_OS_WIN
+   PDH_FMT_COUNTERVALUE counterVal;
+   PdhCollectQueryData(cpuQuery);
+   PdhGetFormattedCounterValue(cpuTotal, PDH_FMT_DOUBLE, 0, &counterVal);
+   GetSystemPowerStatus(&power);
+   m_sample.cpuUsage = static_cast<int>(counterVal.doubleValue);
+   m_sample.batteryLevel = static_cast<int>(power.BatteryLifePercent);
+   m_sample.connectedToAC = (power.ACLineStatus != 0);
+#elif defined Q_OS_LINUX
+   if (m_cpuSampler->sample())
+   {
+      m_sample.cpuUsage = m_cpuSampler->totalUsage();
+      m_sample.processCpuUsage = m_cpuSampler->processUsage();
+      m_sample.processMemoryUsage = static_cast<int>(m_cpuSampler->processMemory() / (1024 * 1024));
+      m_sample.dashboardCpuUsage = m_cpuSampler->childUsage();
+      m_sample.dashboardMemoryUsage = static_cast<int>(m_cpuSampler->childMemory() / (1024 * 1024));
+
+      m_sample.cpuCoreUsage.clear();
+      for (int i = 0; i < m_cpuSampler->coreCount(); ++i)
+         m_sample.cpuCoreUsage.append(m_cpuSampler->coreUsage(i));
+
+      m_sample.threadCpuUsage.clear();
+      for (int i = 0; i < m_cpuSampler->threadCount(); ++i)
+      {
+         const ThreadUsage &thread = m_cpuSampler->thread(i);
+
+         QVariantMap map;
+         map.insert("tid", thread.tid);
+         map.insert("usage", thread.usage);
+         map.insert("name", QString::fromLocal8Bit(thread.name));
+         m_sample.threadCpuUsage.append(map);
+      }
+   }
+#endif
+
+   publish();
+
+#if !defined Q_OS_WIN && !defined Q_OS_LINUX
+   m_cpuProcess->terminate();
+   m_cpuProcess->startCommand(CPU_CMD, QIODevice::ReadOnly);
+   m_batteryLevelProcess->terminate();
+   m_batteryLevelProcess->startCommand(BTY_CMD, QIODevice::ReadOnly);
+   m_connectedToACProcess->terminate();
+   m_connectedToACProcess->startCommand(PWR_CMD, QIODevice::ReadOnly);
+#endif
+}
+
+/**
+ * Sends all the values that changed since the last sample in a single signal.
+ * Nothing is sent if none of the values changed.
+ */
+void HostProbe::publish()
+{
+   m_sample.changes = 0;
+
+   if (m_sample.cpuUsage != m_published.cpuUsage)
+      m_sample.changes |= HostSample::CpuUsageChanged;
+
+   if (m_sample.processCpuUsage != m_published.processCpuUsage
+       || m_sample.processMemoryUsage != m_published.processMemoryUsage
+       || m_sample.cpuCoreUsage != m_published.cpuCoreUsage
+       || m_sample.threadCpuUsage != m_published.threadCpuUsage)
+      m_sample.changes |= HostSample::CpuDetailsChanged;
+
+   if (m_sample.dashboardCpuUsage != m_published.dashboardCpuUsage
+       || m_sample.dashboardMemoryUsage != m_published.dashboardMemoryUsage)
+      m_sample.changes |= HostSample::DashboardUsageChanged;
+
+   if (m_sample.batteryLevel != m_published.batteryLevel)
+      m_sample.changes |= HostSample::BatteryLevelChanged;
+
+   if (m_sample.connectedToAC != m_published.connectedToAC)
+      m_sample.changes |= HostSample::ConnectedToACChanged;
+
+   if (m_sample.changes)
+   {
+      m_published = m_sample;
+      emit sampled(m_sample);
+   }
+}
+
+/**
+ * Reads the output of the process launched to get the CPU usage
+ */
+void HostProbe::readCpuUsageProcess(int exit_code)
+{
+   if (exit_code == EXIT_FAILURE)
+      return;
+
+#if defined Q_OS_MAC
+   m_sample.cpuUsage = 0;
+   m_cpuProcess->terminate();
+   QByteArray data = m_cpuProcess->readAll();
+
+   if (!data.isEmpty() && data.length() >= 2)
+   {
+      /* Parse the digits of the percentage */
+      int t = data.at(0) - '0'; // Tens
+      int u = data.at(1) - '0'; // Units
+
+      /* Check if process data is invalid */
+      if (t < 0)
+         t = 0;
+      if (u < 0)
+         u = 0;
+
+      /* Update information */
+      m_sample.cpuUsage = (t * 10) + u;
+   }
+#endif
+}
+
+/**
+ * Reads the output of the process launched to get the battery level
+ */
+void HostProbe::readBatteryLevelProcess(int exit_code)
+{
+   if (exit_code == EXIT_FAILURE)
+      return;
+
+#if defined Q_OS_MAC
+   m_sample.batteryLevel = 0;
+   m_batteryLevelProcess->terminate();
+   QByteArray data = m_batteryLevelProcess->readAll();
+
+   if (!data.isEmpty())
+   {
+      /* Parse the digits of the percentage */
+      int h = data.at(data.indexOf("%") - 3) - '0'; // Hundreds
+      int t = data.at(data.indexOf("%") - 2) - '0'; // Tens
+      int u = data.at(data.indexOf("%") - 1) - '0'; // Units
+
+      /* Check if process data is invalid */
+      if (h < 0)
+         h = 0;
+      if (t < 0)
+         t = 0;
+      if (u < 0)
+         u = 0;
+
+      /* Update information */
+      m_sample.batteryLevel = (h * 100) + (t * 10) + u;
+   }
+#endif
+}
+
+/**
+ * Reads the output of the process launched to get the AC power source status
+ */
+void HostProbe::readConnectedToACProcess(int exit_code)
+{
+   if (exit_code == EXIT_FAILURE)
+      return;
+
+#if defined Q_OS_MAC
+   m_sample.connectedToAC = false;
+   m_connectedToACProcess->terminate();
+   QByteArray data = m_connectedToACProcess->readAll();
+
+   if (!data.isEmpty())
+      m_sample.connectedToAC = !data.contains("discharging");
+#endif
+}
+
+/**
+ * Publishes the battery level & AC state as soon as the sysfs reports a
+ * change, so that plugging in the charger is shown without waiting for the
+ * next sample.
+ */
+void HostProbe::readPowerSupply()
+{
+#if defined Q_OS_LINUX
+   m_sample.batteryLevel = m_powerSupply->batteryLevel();
+   m_sample.connectedToAC = m_powerSupply->isConnectedToAC();
+   publish();
+#endif
+}
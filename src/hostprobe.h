@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_HOST_PROBE_H
+#define _QDS_HOST_PROBE_H
+
+#include <QTimer>
+#include <QObject>
+#include <QVariant>
+
+class QProcess;
+class CpuSampler;
+class PowerSupply;
+
+/**
+ * \brief Host telemetry values obtained by the \c HostProbe
+ */
+struct HostSample
+{
+   enum Changes
+   {
+      CpuUsageChanged = 1 << 0,
+      BatteryLevelChanged = 1 << 1,
+      ConnectedToACChanged = 1 << 2,
+      CpuDetailsChanged = 1 << 3,
+      DashboardUsageChanged = 1 << 4,
+   };
+
+   HostSample()
+      : changes(0)
+      , cpuUsage(0)
+      , batteryLevel(0)
+      , connectedToAC(false)
+      , processCpuUsage(0)
+      , processMemoryUsage(0)
+      , dashboardCpuUsage(0)
+      , dashboardMemoryUsage(0)
+   {
+   }
+
+   int changes;
+   int cpuUsage;
+   int batteryLevel;
+   bool connectedToAC;
+   int processCpuUsage;
+   int processMemoryUsage;
+   int dashboardCpuUsage;
+   int dashboardMemoryUsage;
+   QVariantList cpuCoreUsage;
+   QVariantList threadCpuUsage;
+};
+
+Q_DECLARE_METATYPE(HostSample)
+
+/**
+ * \brief Probes the CPU usage & battery state of the computer
+ *
+ * This class is meant to live in its own thread, so that slow probes (such as
+ * waiting for an external process) never delay the GUI thread. All the values
+ * are sent together through the \c sampled() signal, which is only emitted
+ * when at least one of the values changed.
+ */
+class HostProbe : public QObject
+{
+   Q_OBJECT
+
+signals:
+   void sampled(const HostSample &sample);
+
+public:
+   explicit HostProbe();
+   ~HostProbe();
+
+public slots:
+   void start();
+   void setDashboardProcess(const qint64 pid);
+
+private slots:
+   void update();
+   void publish();
+   void readCpuUsageProcess(int exit_code = 0);
+   void readBatteryLevelProcess(int exit_code = 0);
+   void readConnectedToACProcess(int exit_code = 0);
+   void readPowerSupply();
+
+private:
+   QTimer *m_timer;
+   HostSample m_sample;
+   HostSample m_published;
+
+   qint64 m_dashboardPid;
+   CpuSampler *m_cpuSampler;
+   PowerSupply *m_powerSupply;
+
+   QProcess *m_cpuProcess;
+   QProcess *m_batteryLevelProcess;
+   QProcess *m_connectedToACProcess;
+};
+
+#endif
@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "inputlog.h"
+#include "joysticks.h"
+#include "varint.h"
+
+#include <QDebug>
+#include <QtEndian>
+#include <QDateTime>
+
+#include <stdio.h>
+#include <string.h>
+
+/* Magic number & version of the input files */
+static const quint32 FILE_MAGIC = 0x49534451; // "QDSI"
+static const quint16 FILE_VERSION = 1;
+static const int FILE_HEADER_SIZE = 16;
+
+/* The player waits actively during the last millisecond before an event */
+static const qint64 SPIN_TIME = 1000 * 1000;
+
+/* Maximum time that the player sleeps before checking if it must stop */
+static const qint64 MAX_SLEEP_TIME = 100 * 1000 * 1000;
+
+static_assert(sizeof(InputEvent::layout) / sizeof(InputEvent::layout[0]) == MAX_JOYSTICKS,
+              "The input event layout must hold all the joysticks");
+
+//------------------------------------------------------------------------------
+// Recorder
+//------------------------------------------------------------------------------
+
+/**
+ * Configures the flush timer, the file is created by \c open()
+ */
+InputRecorder::InputRecorder()
+{
+   m_lastTime = 0;
+   m_buffer.reserve(64 * 1024);
+
+   m_timer.setInterval(1000);
+   connect(&m_timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+/**
+ * Writes the pending events and closes the file
+ */
+InputRecorder::~InputRecorder()
+{
+   close();
+}
+
+/**
+ * Creates the input file at the given \a path and writes its header
+ */
+bool InputRecorder::open(const QString &path)
+{
+   close();
+
+   m_file.setFileName(path);
+   if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+   {
+      qWarning() << "Cannot create input recording" << path << m_file.errorString();
+      return false;
+   }
+
+   uchar header[FILE_HEADER_SIZE];
+   memset(header, 0, sizeof(header));
+   qToLittleEndian<quint32>(FILE_MAGIC, header);
+   qToLittleEndian<quint16>(FILE_VERSION, header + 4);
+   qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + 8);
+   m_file.write(reinterpret_cast<const char *>(header), sizeof(header));
+
+   m_lastTime = LatencyHistogram::timestamp() / 1000;
+   m_timer.start();
+   return true;
+}
+
+/**
+ * Adds an axis, POV or button event, timestamped with the current time
+ */
+void InputRecorder::append(const int type, const int js, const int index, const qint32 value)
+{
+   if (!m_file.isOpen())
+      return;
+
+   InputEvent event;
+   event.type = static_cast<quint8>(type);
+   event.js = static_cast<quint8>(js);
+   event.index = static_cast<quint8>(index);
+   event.value = value;
+   event.time = LatencyHistogram::timestamp();
+   writeEvent(event);
+}
+
+/**
+ * Adds a layout event with the number of axes, POVs & buttons of the given
+ * joystick \a states
+ */
+void InputRecorder::appendLayout(const JoystickState *states, const int count)
+{
+   if (!m_file.isOpen())
+      return;
+
+   InputEvent event;
+   memset(&event, 0, sizeof(event));
+   event.type = InputEvent::Layout;
+   event.index = static_cast<quint8>(qMin(count, MAX_JOYSTICKS));
+   event.time = LatencyHistogram::timestamp();
+
+   for (int i = 0; i < event.index; ++i)
+   {
+      event.layout[i][0] = static_cast<quint8>(states[i].numAxes);
+      event.layout[i][1] = static_cast<quint8>(states[i].numHats);
+      event.layout[i][2] = static_cast<quint8>(states[i].numButtons);
+   }
+
+   writeEvent(event);
+}
+
+/**
+ * Writes the buffered events to the file
+ */
+void InputRecorder::flush()
+{
+   if (m_file.isOpen() && !m_buffer.isEmpty())
+   {
+      m_file.write(m_buffer);
+      m_file.flush();
+      m_buffer.clear();
+   }
+}
+
+/**
+ * Writes the pending events and closes the file
+ */
+void InputRecorder::close()
+{
+   flush();
+   m_timer.stop();
+   m_file.close();
+}
+
+/**
+ * Encodes the given \a event and adds it to the buffer
+ */
+void InputRecorder::writeEvent(const InputEvent &event)
+{
+   uchar data[32 + MAX_JOYSTICKS * 3];
+   uchar *out = data;
+
+   /* Write the time since the last event (in microseconds) */
+   const qint64 time = event.time / 1000;
+   out = writeVarint(out, time - m_lastTime);
+   m_lastTime = time;
+
+   /* Write the type, joystick & index */
+   *out++ = static_cast<uchar>((event.type << 4) | (event.js & 0x0f));
+   *out++ = event.index;
+
+   /* Write the value or the layout */
+   if (event.type == InputEvent::Layout)
+   {
+      for (int i = 0; i < event.index; ++i)
+      {
+         *out++ = event.layout[i][0];
+         *out++ = event.layout[i][1];
+         *out++ = event.layout[i][2];
+      }
+   }
+
+   else
+      out = writeVarint(out, event.value);
+
+   m_buffer.append(reinterpret_cast<const char *>(data), static_cast<int>(out - data));
+}
+
+//------------------------------------------------------------------------------
+// Player
+//------------------------------------------------------------------------------
+
+/**
+ * Creates a player that hands the events to the given \a joysticks bridge
+ */
+InputPlayer::InputPlayer(Joysticks *joysticks)
+{
+   m_dropped = 0;
+   m_joysticks = joysticks;
+}
+
+/**
+ * Stops the playback
+ */
+InputPlayer::~InputPlayer()
+{
+   requestStop();
+   wait();
+}
+
+/**
+ * Reads all the events of the input file at the given \a path
+ */
+bool InputPlayer::load(const QString &path)
+{
+   QFile file(path);
+   if (!file.open(QIODevice::ReadOnly))
+   {
+      qWarning() << "Cannot open input recording" << path << file.errorString();
+      return false;
+   }
+
+   const QByteArray data = file.readAll();
+   const uchar *in = reinterpret_cast<const uchar *>(data.constData());
+   const uchar *end = in + data.size();
+   if (data.size() < FILE_HEADER_SIZE || qFromLittleEndian<quint32>(in) != FILE_MAGIC
+       || qFromLittleEndian<quint16>(in + 4) != FILE_VERSION)
+   {
+      qWarning() << path << "is not a supported input recording";
+      return false;
+   }
+
+   /* Decode the events, the times are converted to nanoseconds */
+   qint64 time = 0;
+   m_events.clear();
+   in += FILE_HEADER_SIZE;
+   while (in < end)
+   {
+      InputEvent event;
+      memset(&event, 0, sizeof(event));
+
+      qint64 delta = 0;
+      in = readVarint(in, end, delta);
+      if (!in || end - in < 2)
+         break;
+
+      time += delta;
+      event.time = time * 1000;
+      event.type = *in >> 4;
+      event.js = *in++ & 0x0f;
+      event.index = *in++;
+
+      if (event.type == InputEvent::Layout)
+      {
+         if (event.index > MAX_JOYSTICKS || end - in < event.index * 3)
+            break;
+
+         for (int i = 0; i < event.index; ++i)
+         {
+            event.layout[i][0] = *in++;
+            event.layout[i][1] = *in++;
+            event.layout[i][2] = *in++;
+         }
+      }
+
+      else
+      {
+         qint64 value = 0;
+         in = readVarint(in, end, value);
+         if (!in)
+            break;
+
+         event.value = static_cast<qint32>(value);
+      }
+
+      m_events.append(event);
+   }
+
+   return !m_events.isEmpty();
+}
+
+/**
+ * Returns the number of loaded events
+ */
+int InputPlayer::eventCount() const
+{
+   return m_events.count();
+}
+
+/**
+ * Tells the thread to stop the playback
+ */
+void InputPlayer::requestStop()
+{
+   m_stop.storeRelease(1);
+}
+
+/**
+ * Returns the histogram of the difference between the scheduled and the
+ * actual time of each event
+ */
+const LatencyHistogram &InputPlayer::timingError() const
+{
+   return m_timingError;
+}
+
+/**
+ * Hands each event to the joysticks bridge at its original time (relative to
+ * the first event). The event is given its scheduled time, so that the bridge
+ * can measure when it actually reached the DS.
+ */
+void InputPlayer::run()
+{
+   if (m_events.isEmpty())
+      return;
+
+   m_dropped = 0;
+   m_timingError.reset();
+   const qint64 origin = LatencyHistogram::timestamp() - m_events.first().time;
+
+   for (int i = 0; i < m_events.count() && !m_stop.loadAcquire(); ++i)
+   {
+      const qint64 due = origin + m_events.at(i).time;
+      qint64 now = LatencyHistogram::timestamp();
+
+      /* Sleep until we are close to the event */
+      while (due - now > SPIN_TIME && !m_stop.loadAcquire())
+      {
+         usleep(qMin(due - now - SPIN_TIME, MAX_SLEEP_TIME) / 1000);
+         now = LatencyHistogram::timestamp();
+      }
+
+      /* Wait actively during the last moments */
+      while (now < due)
+         now = LatencyHistogram::timestamp();
+
+      InputEvent event = m_events.at(i);
+      event.time = due;
+      if (!m_joysticks->pushReplayEvent(event))
+         ++m_dropped;
+
+      m_timingError.record(now - due);
+   }
+}
+
+/**
+ * Prints the timing accuracy of the playback: the error of the player thread
+ * when handing the events to the bridge, and the delivery error of the events
+ * when they reach the DS (which happens at the next latch of the bridge)
+ */
+void InputPlayer::printSummary()
+{
+   const LatencyHistogram &delivery = m_joysticks->replayDelivery();
+   printf("Input replay: %d events, %d dropped\n", m_events.count(), m_dropped);
+   printf("  Hand-off error: p50 %.1f us, p99 %.1f us, max %.1f us\n", m_timingError.percentile(50) / 1000.0,
+          m_timingError.percentile(99) / 1000.0, m_timingError.maximum() / 1000.0);
+   printf("  Delivery to DS: p50 %.1f ms, p99 %.1f ms, max %.1f ms\n", delivery.percentile(50) / 1e6,
+          delivery.percentile(99) / 1e6, delivery.maximum() / 1e6);
+   fflush(stdout);
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_INPUT_LOG_H
+#define _QDS_INPUT_LOG_H
+
+#include <QFile>
+#include <QTimer>
+#include <QThread>
+#include <QObject>
+#include <QVector>
+#include <QAtomicInt>
+
+#include "latency.h"
+
+class Joysticks;
+struct JoystickState;
+
+/**
+ * \brief A single joystick input event (or joystick layout change)
+ *
+ * Axis values are stored in 1/32767 units, POV values are stored in degrees
+ * and button values are 0 or 1. Layout events hold the number of joysticks in
+ * \c index, and the number of axes, POVs & buttons of each joystick in the
+ * \c layout array.
+ */
+struct InputEvent
+{
+   enum Types
+   {
+      Axis = 0,
+      Pov = 1,
+      Button = 2,
+      Layout = 3,
+   };
+
+   qint64 time;
+   quint8 type;
+   quint8 js;
+   quint8 index;
+   qint32 value;
+   quint8 layout[6][3];
+};
+
+/**
+ * \brief Writes the joystick input events to a compact file
+ *
+ * Each event is stored as the time elapsed since the previous event (in
+ * microseconds), the event type & joystick, the axis/POV/button index and the
+ * value, using varints. Events are buffered and written to the file every
+ * second.
+ */
+class InputRecorder : public QObject
+{
+   Q_OBJECT
+
+public:
+   explicit InputRecorder();
+   ~InputRecorder();
+
+   bool open(const QString &path);
+   void append(const int type, const int js, const int index, const qint32 value);
+   void appendLayout(const JoystickState *states, const int count);
+
+public slots:
+   void flush();
+   void close();
+
+private:
+   void writeEvent(const InputEvent &event);
+
+private:
+   QFile m_file;
+   QTimer m_timer;
+   qint64 m_lastTime;
+   QByteArray m_buffer;
+};
+
+/**
+ * \brief Plays a recorded input stream at its original timing
+ *
+ * The events are loaded in memory before playback. The thread sleeps until
+ * shortly before each event and then waits actively, so that events are
+ * handed to the joysticks bridge with sub-millisecond accuracy. The
+ * difference between the scheduled and the actual hand-off time of each
+ * event is recorded.
+ *
+ * The bridge applies the events at its next latch (once per control packet),
+ * so the events reach the DS up to a packet interval later. The bridge
+ * measures that delivery error separately, and both are printed by
+ * \c printSummary() when playback finishes.
+ */
+class InputPlayer : public QThread
+{
+   Q_OBJECT
+
+public:
+   explicit InputPlayer(Joysticks *joysticks);
+   ~InputPlayer();
+
+   bool load(const QString &path);
+   int eventCount() const;
+
+   void requestStop();
+   const LatencyHistogram &timingError() const;
+
+public slots:
+   void printSummary();
+
+protected:
+   void run() override;
+
+private:
+   int m_dropped;
+   QAtomicInt m_stop;
+   Joysticks *m_joysticks;
+   LatencyHistogram m_timingError;
+   QVector<InputEvent> m_events;
+};
+
+#endif
@@ -0,0 +1,499 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "joysticks.h"
+
+#include <limits.h>
+#include <string.h>
+
+#include <QUrl>
+#include <QDebug>
+#include <QDateTime>
+#include <QDesktopServices>
+#include <QStandardPaths>
+
+#include <QJoysticks.h>
+#include <DriverStation.h>
+
+/* Interval between control packets (in milliseconds) */
+static const int PACKET_INTERVAL = 20;
+
+/**
+ * Connects the QJoysticks input signals to the joystick state blocks
+ */
+Joysticks::Joysticks()
+{
+   m_count = 0;
+   m_connected = false;
+   m_latching = false;
+   m_latencySamples = 0;
+   m_replaying = false;
+   m_replaceInput = false;
+   m_inputRecorder = nullptr;
+   m_joysticks = QJoysticks::getInstance();
+   m_driverStation = DriverStation::getInstance();
+   memset(m_states, 0, sizeof(m_states));
+
+   /* Send the joystick states to the DS at the control packet rate */
+   m_latchTimer.setInterval(PACKET_INTERVAL);
+   m_latchTimer.setTimerType(Qt::PreciseTimer);
+   connect(&m_latchTimer, SIGNAL(timeout()), this, SLOT(latch()));
+
+   /* Refresh the latency readouts every second */
+   m_latencyTimer.setInterval(1000);
+   connect(&m_latencyTimer, SIGNAL(timeout()), this, SLOT(updateLatency()));
+   m_latencyTimer.start();
+
+   /* Update the DS joysticks & blacklist cache when a joystick is (un)plugged */
+   connect(m_joysticks, SIGNAL(countChanged()), this, SLOT(registerJoysticks()));
+
+   /* Register the joysticks that are already attached & forward their input */
+   registerJoysticks();
+   setConnected(true);
+}
+
+/**
+ * Returns the number of joysticks registered with the DriverStation
+ */
+int Joysticks::count() const
+{
+   return m_count;
+}
+
+/**
+ * Returns \c true if joystick input is being forwarded to the DriverStation
+ */
+bool Joysticks::isConnected() const
+{
+   return m_connected;
+}
+
+/**
+ * Returns the state block of the given joystick
+ */
+const JoystickState &Joysticks::state(const int js) const
+{
+   Q_ASSERT(js >= 0 && js < MAX_JOYSTICKS);
+   return m_states[js];
+}
+
+/**
+ * Returns the median input latency (in milliseconds)
+ */
+qreal Joysticks::latencyP50() const
+{
+   return m_latency.percentile(50) / 1e6;
+}
+
+/**
+ * Returns the 99th percentile of the input latency (in milliseconds)
+ */
+qreal Joysticks::latencyP99() const
+{
+   return m_latency.percentile(99) / 1e6;
+}
+
+/**
+ * Returns the maximum input latency (in milliseconds)
+ */
+qreal Joysticks::latencyMax() const
+{
+   return m_latency.maximum() / 1e6;
+}
+
+/**
+ * Returns the number of samples in the input latency histogram
+ */
+int Joysticks::latencySamples() const
+{
+   return static_cast<int>(qMin<quint64>(m_latency.count(), INT_MAX));
+}
+
+/**
+ * Returns the histogram of the time elapsed between an input event and the
+ * moment in which it was handed to the DriverStation
+ */
+const LatencyHistogram &Joysticks::latency() const
+{
+   return m_latency;
+}
+
+/**
+ * Sends the values that changed since the last call to the DriverStation.
+ * This is called once per control packet while the joysticks are being used,
+ * the timer is stopped when there are no more changes to send.
+ */
+void Joysticks::latch()
+{
+   bool changed = false;
+   m_latching = true;
+
+   /* Apply the events of the input replay, their time is the scheduled time */
+   InputEvent event;
+   while (m_replay.pop(event))
+   {
+      applyReplayEvent(event);
+      m_replayDelivery.record(LatencyHistogram::timestamp() - event.time);
+   }
+
+   for (int js = 0; js < m_count; ++js)
+   {
+      JoystickState &state = m_states[js];
+      if (!state.changedAxes && !state.changedHats && !state.changedButtons)
+         continue;
+
+      for (int i = 0; i < state.numAxes; ++i)
+      {
+         if (state.changedAxes & (1u << i))
+            m_driverStation->setJoystickAxis(js, i, state.axes[i]);
+      }
+
+      for (int i = 0; i < state.numHats; ++i)
+      {
+         if (state.changedHats & (1u << i))
+            m_driverStation->setJoystickHat(js, i, state.hats[i]);
+      }
+
+      for (int i = 0; i < state.numButtons; ++i)
+      {
+         if (state.changedButtons & (1u << i))
+            m_driverStation->setJoystickButton(js, i, (state.buttons & (1u << i)) != 0);
+      }
+
+      changed = true;
+      state.changedAxes = 0;
+      state.changedHats = 0;
+      state.changedButtons = 0;
+      m_latency.record(LatencyHistogram::timestamp() - state.changedSince);
+   }
+
+   m_latching = false;
+
+   if (changed)
+      emit inputLatched();
+   else if (!m_replaying)
+      m_latchTimer.stop();
+}
+
+/**
+ * Returns the histogram of the time elapsed between the scheduled time of
+ * each replayed event and the latch that handed it to the DriverStation
+ */
+const LatencyHistogram &Joysticks::replayDelivery() const
+{
+   return m_replayDelivery;
+}
+
+/**
+ * Hands an event of the input replay to the bridge, the event is applied
+ * before the next latch. Returns \c false if the replay ring is full.
+ * \note This function is called from the \c InputPlayer thread
+ */
+bool Joysticks::pushReplayEvent(const InputEvent &event)
+{
+   return m_replay.push(event);
+}
+
+/**
+ * Starts writing the input events (and joystick layout changes) to the
+ * given file
+ */
+bool Joysticks::startInputRecording(const QString &path)
+{
+   if (!m_inputRecorder)
+   {
+      m_inputRecorder = new InputRecorder;
+      m_inputRecorder->setParent(this);
+   }
+
+   if (!m_inputRecorder->open(path))
+      return false;
+
+   m_inputRecorder->appendLayout(m_states, m_count);
+   return true;
+}
+
+/**
+ * Prepares the bridge for an input replay. If \a replace is \c true, the
+ * live input is ignored and the joysticks are registered with the layout of
+ * the recording, otherwise the replayed events are mixed with the live input.
+ */
+void Joysticks::startReplay(const bool replace)
+{
+   m_replaying = true;
+   m_replayDelivery.reset();
+   m_replaceInput = replace;
+
+   if (replace)
+      setConnected(false);
+
+   m_latchTimer.start();
+}
+
+/**
+ * Goes back to forwarding the live input after an input replay
+ */
+void Joysticks::stopReplay()
+{
+   /* Send the last replayed events before the live input is restored */
+   latch();
+   m_replaying = false;
+
+   if (m_replaceInput)
+   {
+      m_replaceInput = false;
+      registerJoysticks();
+      setConnected(true);
+   }
+}
+
+/**
+ * Removes all the samples from the input latency histogram
+ */
+void Joysticks::resetLatency()
+{
+   m_latency.reset();
+   updateLatency();
+}
+
+/**
+ * Saves the input latency histogram as a CSV file in the documents folder
+ * and opens it with the default application
+ */
+void Joysticks::exportLatency()
+{
+   const QString date = QDateTime::currentDateTime().toString("yyyy-MM-dd hh-mm-ss");
+   const QString path = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)
+                        + "/QDriverStation Input Latency " + date + ".csv";
+
+   if (m_latency.save(path))
+      QDesktopServices::openUrl(QUrl::fromLocalFile(path));
+   else
+      qWarning() << "Cannot save input latency histogram to" << path;
+}
+
+/**
+ * Notifies the UI if new samples were added to the input latency histogram
+ */
+void Joysticks::updateLatency()
+{
+   if (m_latency.count() != m_latencySamples)
+   {
+      m_latencySamples = m_latency.count();
+      emit latencyChanged();
+   }
+}
+
+/**
+ * Enables or disables the forwarding of joystick input to the DriverStation.
+ * \note This is used by the benchmarks to compare the QML & C++ input paths
+ */
+void Joysticks::setConnected(const bool connected)
+{
+   if (m_connected == connected)
+      return;
+
+   m_connected = connected;
+
+   if (connected)
+   {
+      connect(m_joysticks, SIGNAL(povChanged(int, int, int)), this, SLOT(onPovChanged(int, int, int)));
+      connect(m_joysticks, SIGNAL(axisChanged(int, int, qreal)), this, SLOT(onAxisChanged(int, int, qreal)));
+      connect(m_joysticks, SIGNAL(buttonChanged(int, int, bool)), this, SLOT(onButtonChanged(int, int, bool)));
+   }
+
+   else
+   {
+      disconnect(m_joysticks, SIGNAL(povChanged(int, int, int)), this, SLOT(onPovChanged(int, int, int)));
+      disconnect(m_joysticks, SIGNAL(axisChanged(int, int, qreal)), this, SLOT(onAxisChanged(int, int, qreal)));
+      disconnect(m_joysticks, SIGNAL(buttonChanged(int, int, bool)), this, SLOT(onButtonChanged(int, int, bool)));
+   }
+}
+
+/**
+ * Re-registers the attached joysticks with the DriverStation and rebuilds the
+ * joystick state blocks. This is called every time that QJoysticks reports a
+ * change in the joystick list (which includes changes in the blacklist state).
+ */
+void Joysticks::registerJoysticks()
+{
+   /* The joystick layout is given by the input replay */
+   if (m_replaceInput)
+      return;
+
+   m_latchTimer.stop();
+   memset(m_states, 0, sizeof(m_states));
+   m_count = qMin(m_joysticks->count(), MAX_JOYSTICKS);
+
+   m_driverStation->resetJoysticks();
+
+   for (int i = 0; i < m_count; ++i)
+   {
+      JoystickState &state = m_states[i];
+      state.blacklisted = m_joysticks->isBlacklisted(i);
+      state.numAxes = qMin(m_joysticks->getNumAxes(i), MAX_JOYSTICK_AXES);
+      state.numHats = qMin(m_joysticks->getNumPOVs(i), MAX_JOYSTICK_HATS);
+      state.numButtons = qMin(m_joysticks->getNumButtons(i), MAX_JOYSTICK_BUTTONS);
+
+      m_driverStation->addJoystick(state.numAxes, state.numHats, state.numButtons);
+   }
+
+   if (m_inputRecorder)
+      m_inputRecorder->appendLayout(m_states, m_count);
+
+   emit inputLatched();
+}
+
+/**
+ * Updates the POV \a angle in the joystick state block
+ */
+void Joysticks::onPovChanged(const int js, const int pov, const int angle)
+{
+   if (m_inputRecorder)
+      m_inputRecorder->append(InputEvent::Pov, js, pov, angle);
+
+   JoystickState *state = writableState(js);
+   if (state && pov >= 0 && pov < state->numHats)
+   {
+      state->hats[pov] = angle;
+      state->changedHats |= 1u << pov;
+      latchIfIdle();
+   }
+}
+
+/**
+ * Updates the axis \a value in the joystick state block
+ */
+void Joysticks::onAxisChanged(const int js, const int axis, const qreal value)
+{
+   if (m_inputRecorder)
+      m_inputRecorder->append(InputEvent::Axis, js, axis, qRound(value * 32767));
+
+   JoystickState *state = writableState(js);
+   if (state && axis >= 0 && axis < state->numAxes)
+   {
+      state->axes[axis] = value;
+      state->changedAxes |= 1u << axis;
+      latchIfIdle();
+   }
+}
+
+/**
+ * Updates the button state in the joystick state block
+ */
+void Joysticks::onButtonChanged(const int js, const int button, const bool pressed)
+{
+   if (m_inputRecorder)
+      m_inputRecorder->append(InputEvent::Button, js, button, pressed);
+
+   JoystickState *state = writableState(js);
+   if (state && button >= 0 && button < state->numButtons)
+   {
+      if (pressed)
+         state->buttons |= 1u << button;
+      else
+         state->buttons &= ~(1u << button);
+
+      state->changedButtons |= 1u << button;
+      latchIfIdle();
+   }
+}
+
+/**
+ * Applies an event of the input replay as if it was reported by QJoysticks.
+ * Layout events re-register the joysticks when the live input is replaced.
+ * The time of the event is used to measure the input latency.
+ */
+void Joysticks::applyReplayEvent(const InputEvent &event)
+{
+   if (event.type == InputEvent::Layout)
+   {
+      if (!m_replaceInput)
+         return;
+
+      memset(m_states, 0, sizeof(m_states));
+      m_count = qMin<int>(event.index, MAX_JOYSTICKS);
+      m_driverStation->resetJoysticks();
+
+      for (int i = 0; i < m_count; ++i)
+      {
+         JoystickState &state = m_states[i];
+         state.numAxes = qMin<int>(event.layout[i][0], MAX_JOYSTICK_AXES);
+         state.numHats = qMin<int>(event.layout[i][1], MAX_JOYSTICK_HATS);
+         state.numButtons = qMin<int>(event.layout[i][2], MAX_JOYSTICK_BUTTONS);
+
+         m_driverStation->addJoystick(state.numAxes, state.numHats, state.numButtons);
+      }
+
+      return;
+   }
+
+   if (event.js >= m_count)
+      return;
+
+   JoystickState &state = m_states[event.js];
+   const bool pending = state.changedAxes || state.changedHats || state.changedButtons;
+
+   if (event.type == InputEvent::Axis)
+      onAxisChanged(event.js, event.index, event.value / 32767.0);
+   else if (event.type == InputEvent::Pov)
+      onPovChanged(event.js, event.index, event.value);
+   else if (event.type == InputEvent::Button)
+      onButtonChanged(event.js, event.index, event.value != 0);
+
+   if (!pending)
+      state.changedSince = event.time;
+}
+
+/**
+ * Sends the first change after an idle period right away and starts the
+ * latch timer, the changes that follow are sent at the packet rate. The
+ * timer is stopped while idle, so waiting for it would delay the first
+ * change by a full packet interval.
+ */
+void Joysticks::latchIfIdle()
+{
+   if (m_latching || m_latchTimer.isActive())
+      return;
+
+   m_latchTimer.start();
+   latch();
+}
+
+/**
+ * Returns the state block of the given joystick. Blacklisted and unknown joysticks are ignored (so that
+ * they cannot move the robot), in that case this function returns \c nullptr.
+ *
+ * The time of the first change since the last latch is saved in the block,
+ * so that we can measure how long it took to reach the DriverStation.
+ */
+JoystickState *Joysticks::writableState(const int js)
+{
+   if (js < 0 || js >= m_count || m_states[js].blacklisted)
+      return nullptr;
+
+   JoystickState &state = m_states[js];
+   if (!state.changedAxes && !state.changedHats && !state.changedButtons)
+      state.changedSince = LatencyHistogram::timestamp();
+
+   return &state;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_JOYSTICKS_H
+#define _QDS_JOYSTICKS_H
+
+#include <QTimer>
+#include <QObject>
+
+#include "latency.h"
+#include "inputlog.h"
+#include "ringbuffer.h"
+
+class QJoysticks;
+class DriverStation;
+
+/* Limits of the joystick state blocks (same as the FRC protocols) */
+static const int MAX_JOYSTICKS = 6;
+static const int MAX_JOYSTICK_AXES = 12;
+static const int MAX_JOYSTICK_HATS = 4;
+static const int MAX_JOYSTICK_BUTTONS = 32;
+
+/**
+ * \brief Holds the input state of a single joystick
+ *
+ * Input events only write into this block and mark the values that changed,
+ * the changed values are sent to the DriverStation once per control packet.
+ */
+struct JoystickState
+{
+   int numAxes;
+   int numHats;
+   int numButtons;
+   bool blacklisted;
+
+   float axes[MAX_JOYSTICK_AXES];
+   qint16 hats[MAX_JOYSTICK_HATS];
+   quint32 buttons;
+
+   quint32 changedAxes;
+   quint32 changedHats;
+   quint32 changedButtons;
+   qint64 changedSince;
+};
+
+/**
+ * \brief Forwards joystick input from QJoysticks to the DriverStation
+ *
+ * Axis, button and POV events are handled directly from C++, so the QML engine
+ * does not sit between a joystick and the robot. The QML interface only uses
+ * the QJoysticks signals to display the state of the selected joystick.
+ *
+ * Each event is written into the state block of its joystick, and the state
+ * of all joysticks is sent to the DriverStation at the control packet rate.
+ * The first event after an idle period is sent right away.
+ * This way, a stick sweep does not result in hundreds of DS calls, and all
+ * the axes of a joystick are updated together in the same packet.
+ *
+ * The time elapsed between an input event and the moment in which it is
+ * handed to the DriverStation is recorded in a latency histogram, which is
+ * displayed in the diagnostics tab.
+ *
+ * The input events can be recorded to a file, and a recorded stream can be
+ * played back by an \c InputPlayer thread. Replayed events are passed to
+ * this class through a lock-free ring and applied before each latch, either
+ * mixed with the live input or in place of it.
+ */
+class Joysticks : public QObject
+{
+   Q_OBJECT
+   Q_PROPERTY(qreal latencyP50 READ latencyP50 NOTIFY latencyChanged)
+   Q_PROPERTY(qreal latencyP99 READ latencyP99 NOTIFY latencyChanged)
+   Q_PROPERTY(qreal latencyMax READ latencyMax NOTIFY latencyChanged)
+   Q_PROPERTY(int latencySamples READ latencySamples NOTIFY latencyChanged)
+
+signals:
+   void inputLatched();
+   void latencyChanged();
+
+public:
+   explicit Joysticks();
+
+   int count() const;
+   bool isConnected() const;
+   const JoystickState &state(const int js) const;
+
+   qreal latencyP50() const;
+   qreal latencyP99() const;
+   qreal latencyMax() const;
+   int latencySamples() const;
+   const LatencyHistogram &latency() const;
+   const LatencyHistogram &replayDelivery() const;
+
+   bool pushReplayEvent(const InputEvent &event);
+   bool startInputRecording(const QString &path);
+
+public slots:
+   void latch();
+   void resetLatency();
+   void exportLatency();
+   void setConnected(const bool connected);
+   void registerJoysticks();
+   void startReplay(const bool replace);
+   void stopReplay();
+
+private slots:
+   void updateLatency();
+   void onPovChanged(const int js, const int pov, const int angle);
+   void onAxisChanged(const int js, const int axis, const qreal value);
+   void onButtonChanged(const int js, const int button, const bool pressed);
+
+private:
+   void latchIfIdle();
+   void applyReplayEvent(const InputEvent &event);
+   JoystickState *writableState(const int js);
+
+private:
+   int m_count;
+   bool m_connected;
+   bool m_latching;
+   JoystickState m_states[MAX_JOYSTICKS];
+
+   QTimer m_latchTimer;
+   QTimer m_latencyTimer;
+   quint64 m_latencySamples;
+   LatencyHistogram m_latency;
+
+   bool m_replaying;
+   bool m_replaceInput;
+   LatencyHistogram m_replayDelivery;
+   InputRecorder *m_inputRecorder;
+   RingBuffer<InputEvent, 1024> m_replay;
+
+   QJoysticks *m_joysticks;
+   DriverStation *m_driverStation;
+};
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "latency.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QtAlgorithms>
+
+/**
+ * Returns a started timer, used as the reference for all timestamps
+ */
+static QElapsedTimer startClock()
+{
+   QElapsedTimer clock;
+   clock.start();
+   return clock;
+}
+
+/**
+ * Initializes an empty histogram
+ */
+LatencyHistogram::LatencyHistogram()
+{
+   reset();
+}
+
+/**
+ * Returns a monotonic timestamp (in nanoseconds) that can be compared between
+ * threads, used to timestamp the different stages of a measured path.
+ */
+qint64 LatencyHistogram::timestamp()
+{
+   static const QElapsedTimer clock = startClock();
+   return clock.nsecsElapsed();
+}
+
+/**
+ * Removes all the recorded samples
+ */
+void LatencyHistogram::reset()
+{
+   for (int i = 0; i < BucketCount; ++i)
+      m_buckets[i].store(0, std::memory_order_relaxed);
+
+   m_count.store(0, std::memory_order_relaxed);
+   m_maximum.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * Adds the given sample (in \a nanoseconds) to the histogram
+ */
+void LatencyHistogram::record(const qint64 nanoseconds)
+{
+   const quint64 value = static_cast<quint64>(qMax<qint64>(0, nanoseconds));
+
+   m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+   m_count.fetch_add(1, std::memory_order_relaxed);
+
+   quint64 maximum = m_maximum.load(std::memory_order_relaxed);
+   while (value > maximum && !m_maximum.compare_exchange_weak(maximum, value, std::memory_order_relaxed))
+      ;
+}
+
+/**
+ * Returns the number of recorded samples
+ */
+quint64 LatencyHistogram::count() const
+{
+   return m_count.load(std::memory_order_relaxed);
+}
+
+/**
+ * Returns the largest recorded sample (in nanoseconds)
+ */
+qint64 LatencyHistogram::maximum() const
+{
+   return static_cast<qint64>(m_maximum.load(std::memory_order_relaxed));
+}
+
+/**
+ * Returns the value (in nanoseconds) below which the given \a percent of the
+ * samples fall. The upper bound of the matching bucket is reported, so that
+ * the value is never lower than the actual percentile.
+ */
+qint64 LatencyHistogram::percentile(const double percent) const
+{
+   quint64 total = 0;
+   quint32 counts[BucketCount];
+   for (int i = 0; i < BucketCount; ++i)
+   {
+      counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+      total += counts[i];
+   }
+
+   if (total == 0)
+      return 0;
+
+   const quint64 rank = qMax<quint64>(1, static_cast<quint64>(total * qBound(0.0, percent, 100.0) / 100.0 + 0.5));
+
+   quint64 accumulated = 0;
+   for (int i = 0; i < BucketCount; ++i)
+   {
+      accumulated += counts[i];
+      if (accumulated >= rank)
+         return static_cast<qint64>(qMin<quint64>(bucketUpperBound(i), m_maximum.load(std::memory_order_relaxed)));
+   }
+
+   return maximum();
+}
+
+/**
+ * Writes the summary and the non-empty buckets of the histogram to a CSV file
+ */
+bool LatencyHistogram::save(const QString &path) const
+{
+   QFile file(path);
+   if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+      return false;
+
+   QTextStream stream(&file);
+   stream << "# samples," << count() << "\n";
+   stream << "# p50 (ns)," << percentile(50) << "\n";
+   stream << "# p99 (ns)," << percentile(99) << "\n";
+   stream << "# max (ns)," << maximum() << "\n";
+   stream << "lower (ns),upper (ns),count\n";
+
+   for (int i = 0; i < BucketCount; ++i)
+   {
+      const quint32 count = m_buckets[i].load(std::memory_order_relaxed);
+      if (count > 0)
+      {
+         const quint64 lower = i > 0 ? bucketUpperBound(i - 1) + 1 : 0;
+         stream << lower << "," << bucketUpperBound(i) << "," << count << "\n";
+      }
+   }
+
+   return stream.status() == QTextStream::Ok;
+}
+
+/**
+ * Returns the bucket in which the given \a value is stored
+ */
+int LatencyHistogram::bucketIndex(quint64 value)
+{
+   value = qMin<quint64>(value, (Q_UINT64_C(1) << MaxValueBits) - 1);
+   if (value < SubBuckets)
+      return static_cast<int>(value);
+
+   const int msb = 63 - qCountLeadingZeroBits(value);
+   const int shift = msb - SubBucketBits;
+   const int sub = static_cast<int>(value >> shift) - SubBuckets;
+   return SubBuckets + shift * SubBuckets + sub;
+}
+
+/**
+ * Returns the largest value that is stored in the given bucket
+ */
+quint64 LatencyHistogram::bucketUpperBound(const int index)
+{
+   if (index < SubBuckets)
+      return static_cast<quint64>(index);
+
+   const int shift = (index - SubBuckets) / SubBuckets;
+   const int sub = (index - SubBuckets) % SubBuckets;
+   const quint64 lower = static_cast<quint64>(SubBuckets + sub) << shift;
+   return lower + (Q_UINT64_C(1) << shift) - 1;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_LATENCY_H
+#define _QDS_LATENCY_H
+
+#include <atomic>
+#include <QtGlobal>
+
+class QString;
+
+/**
+ * \brief Lock-free histogram of latency samples
+ *
+ * Samples are recorded in nanoseconds into logarithmic buckets (16 buckets for
+ * each power of two), which keeps the relative error of the reported values
+ * under 7% while using a fixed amount of memory. Recording a sample only uses
+ * relaxed atomic operations, so it can be done from any thread without locks.
+ */
+class LatencyHistogram
+{
+public:
+   LatencyHistogram();
+
+   static qint64 timestamp();
+
+   void reset();
+   void record(const qint64 nanoseconds);
+
+   quint64 count() const;
+   qint64 maximum() const;
+   qint64 percentile(const double percent) const;
+
+   bool save(const QString &path) const;
+
+private:
+   static int bucketIndex(quint64 value);
+   static quint64 bucketUpperBound(const int index);
+
+private:
+   enum
+   {
+      SubBucketBits = 4,
+      SubBuckets = 1 << SubBucketBits,
+      MaxValueBits = 36,
+      BucketCount = SubBuckets + (MaxValueBits - SubBucketBits) * SubBuckets
+   };
+
+   std::atomic<quint64> m_count;
+   std::atomic<quint64> m_maximum;
+   std::atomic<quint32> m_buckets[BucketCount];
+};
+
+#endif
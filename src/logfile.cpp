@@ -0,0 +1,447 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "logfile.h"
+
+#include <QDir>
+#include <QtEndian>
+#include <QDateTime>
+#include <QStandardPaths>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits>
+#include <algorithm>
+
+/* Magic numbers of the log, block & index headers */
+static const quint32 FILE_MAGIC = 0x4C534451; // "QDSL"
+static const quint32 BLOCK_MAGIC = 0x5A534451; // "QDSZ"
+static const quint32 INDEX_MAGIC = 0x58534451; // "QDSX"
+
+/* Version of the log & index formats */
+static const quint16 FILE_VERSION = 1;
+
+/* Size of the headers & index entries (in bytes) */
+static const int FILE_HEADER_SIZE = 16;
+static const int BLOCK_HEADER_SIZE = 32;
+static const int INDEX_HEADER_SIZE = 8;
+static const int INDEX_ENTRY_SIZE = 24;
+
+/* Format of the time at the start of each log line */
+static const char *TIME_FORMAT = "yyyy-MM-dd hh:mm:ss.zzz";
+static const int TIME_LENGTH = 23;
+
+/* zlib compression level of the blocks */
+static const int COMPRESSION_LEVEL = 6;
+
+LogFile::LogFile()
+   : m_first(0)
+   , m_last(0)
+   , m_lines(0)
+{
+}
+
+LogFile::~LogFile()
+{
+   close();
+}
+
+/**
+ * Returns \c true if a log file is being written
+ */
+bool LogFile::isOpen() const
+{
+   return m_file.isOpen();
+}
+
+/**
+ * Returns the path of the log file being written
+ */
+QString LogFile::path() const
+{
+   return m_file.fileName();
+}
+
+/**
+ * Starts a new log file (and its index) and removes the old logs
+ */
+bool LogFile::open()
+{
+   close();
+
+   QDir dir(logsPath());
+   if (!dir.exists())
+      dir.mkpath(".");
+
+   const QString name = QDateTime::currentDateTime().toString("yyyy-MM-dd hh-mm-ss");
+   QString path = dir.filePath(name + ".qdsl");
+   for (int i = 2; QFile::exists(path); ++i)
+      path = dir.filePath(QString("%1 (%2).qdsl").arg(name).arg(i));
+
+   m_file.setFileName(path);
+   m_index.setFileName(indexPath(path));
+   if (!m_file.open(QIODevice::WriteOnly) || !m_index.open(QIODevice::WriteOnly))
+   {
+      fprintf(stderr, "Cannot create log file %s\n", qPrintable(path));
+      m_file.close();
+      m_index.close();
+      return false;
+   }
+
+   uchar header[FILE_HEADER_SIZE];
+   qToLittleEndian<quint32>(FILE_MAGIC, header);
+   qToLittleEndian<quint16>(FILE_VERSION, header + 4);
+   qToLittleEndian<quint16>(0, header + 6);
+   qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + 8);
+   m_file.write(reinterpret_cast<const char *>(header), FILE_HEADER_SIZE);
+
+   uchar index[INDEX_HEADER_SIZE];
+   qToLittleEndian<quint32>(INDEX_MAGIC, index);
+   qToLittleEndian<quint16>(FILE_VERSION, index + 4);
+   qToLittleEndian<quint16>(0, index + 6);
+   m_index.write(reinterpret_cast<const char *>(index), INDEX_HEADER_SIZE);
+
+   m_file.flush();
+   m_index.flush();
+
+   removeOldLogs();
+   return true;
+}
+
+/**
+ * Writes the pending block and closes the log
+ */
+void LogFile::close()
+{
+   if (!isOpen())
+      return;
+
+   writeBlock();
+   m_file.close();
+   m_index.close();
+}
+
+/**
+ * Compresses the pending lines and appends them to the log as a new block,
+ * a new log file is started if the current one is too large
+ */
+void LogFile::writeBlock()
+{
+   if (m_block.isEmpty() || !isOpen())
+      return;
+
+   const QByteArray data = qCompress(m_block, COMPRESSION_LEVEL);
+   const qint64 offset = m_file.pos();
+
+   uchar header[BLOCK_HEADER_SIZE];
+   qToLittleEndian<quint32>(BLOCK_MAGIC, header);
+   qToLittleEndian<quint32>(static_cast<quint32>(data.size()), header + 4);
+   qToLittleEndian<quint32>(static_cast<quint32>(m_block.size()), header + 8);
+   qToLittleEndian<quint32>(m_lines, header + 12);
+   qToLittleEndian<qint64>(m_first, header + 16);
+   qToLittleEndian<qint64>(m_last, header + 24);
+   m_file.write(reinterpret_cast<const char *>(header), BLOCK_HEADER_SIZE);
+   m_file.write(data);
+
+   uchar entry[INDEX_ENTRY_SIZE];
+   qToLittleEndian<qint64>(offset, entry);
+   qToLittleEndian<qint64>(m_first, entry + 8);
+   qToLittleEndian<qint64>(m_last, entry + 16);
+   m_index.write(reinterpret_cast<const char *>(entry), INDEX_ENTRY_SIZE);
+
+   m_file.flush();
+   m_index.flush();
+
+   m_lines = 0;
+   m_block.clear();
+
+   if (m_file.pos() >= MaxFileSize)
+      open();
+}
+
+/**
+ * Writes the pending block if its first line is older than the block age
+ */
+void LogFile::tick(const qint64 now)
+{
+   if (!m_block.isEmpty() && now - m_first >= BlockAge)
+      writeBlock();
+}
+
+/**
+ * Adds a \a line logged at the given \a time (in milliseconds since the
+ * epoch) to the pending block, the line must start with its time
+ */
+void LogFile::append(const qint64 time, const QByteArray &line)
+{
+   if (!isOpen() && !open())
+      return;
+
+   if (m_block.isEmpty())
+   {
+      m_block.reserve(BlockSize + 1024);
+      m_first = time;
+   }
+
+   m_last = time;
+   m_block.append(line);
+   ++m_lines;
+
+   if (m_block.size() >= BlockSize)
+      writeBlock();
+}
+
+/**
+ * Returns the folder in which the logs are saved
+ */
+QString LogFile::logsPath()
+{
+   return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/Logs";
+}
+
+/**
+ * Returns the path of the index of the given log file
+ */
+QString LogFile::indexPath(const QString &path)
+{
+   QString index = path;
+   if (index.endsWith(".qdsl"))
+      index.chop(5);
+
+   return index + ".qdsx";
+}
+
+/**
+ * Reads the lines of the given log between the \a from and \a to times (in
+ * milliseconds since the epoch) into \a text. The index is used to find the
+ * first block of the time range, and only the blocks inside the time range
+ * are decompressed.
+ */
+bool LogFile::read(const QString &path, const qint64 from, const qint64 to, QByteArray &text)
+{
+   QFile file(path);
+   if (!file.open(QIODevice::ReadOnly))
+      return false;
+
+   const QByteArray header = file.read(FILE_HEADER_SIZE);
+   if (header.size() != FILE_HEADER_SIZE
+       || qFromLittleEndian<quint32>(header.constData()) != FILE_MAGIC
+       || qFromLittleEndian<quint16>(header.constData() + 4) != FILE_VERSION)
+      return false;
+
+   QVector<IndexEntry> entries;
+   if (!readIndex(path, file, entries))
+      return false;
+
+   /* Find the first block that ends after the start of the range */
+   auto block = std::lower_bound(entries.constBegin(), entries.constEnd(), from,
+                                 [](const IndexEntry &entry, const qint64 time) { return entry.last < time; });
+
+   for (; block != entries.constEnd() && block->first <= to; ++block)
+   {
+      if (!file.seek(block->offset))
+         return false;
+
+      const QByteArray head = file.read(BLOCK_HEADER_SIZE);
+      if (head.size() != BLOCK_HEADER_SIZE || qFromLittleEndian<quint32>(head.constData()) != BLOCK_MAGIC)
+         return false;
+
+      const qint64 size = qFromLittleEndian<quint32>(head.constData() + 4);
+      const QByteArray lines = qUncompress(file.read(size));
+
+      /* The whole block is inside the time range */
+      if (block->first >= from && block->last <= to)
+      {
+         text.append(lines);
+         continue;
+      }
+
+      /* Check the time of each line, continuation lines follow their first line */
+      bool keep = false;
+      int start = 0;
+      while (start < lines.size())
+      {
+         int end = lines.indexOf('\n', start);
+         end = end < 0 ? lines.size() : end + 1;
+
+         if (end - start > TIME_LENGTH)
+         {
+            const QString stamp = QString::fromLatin1(lines.constData() + start, TIME_LENGTH);
+            const QDateTime time = QDateTime::fromString(stamp, TIME_FORMAT);
+            if (time.isValid())
+            {
+               const qint64 ms = time.toMSecsSinceEpoch();
+               keep = ms >= from && ms <= to;
+            }
+         }
+
+         if (keep)
+            text.append(lines.constData() + start, end - start);
+
+         start = end;
+      }
+   }
+
+   return true;
+}
+
+/**
+ * Writes the lines of the given log between the \a from and \a to times (as
+ * ISO 8601 dates, empty strings are ignored) to the standard output
+ */
+int LogFile::print(const QString &path, const QString &from, const QString &to)
+{
+   qint64 min = std::numeric_limits<qint64>::min();
+   qint64 max = std::numeric_limits<qint64>::max();
+
+   if (!from.isEmpty())
+   {
+      const QDateTime time = QDateTime::fromString(from, Qt::ISODate);
+      if (!time.isValid())
+      {
+         fprintf(stderr, "Invalid time %s\n", qPrintable(from));
+         return EXIT_FAILURE;
+      }
+
+      min = time.toMSecsSinceEpoch();
+   }
+
+   if (!to.isEmpty())
+   {
+      const QDateTime time = QDateTime::fromString(to, Qt::ISODate);
+      if (!time.isValid())
+      {
+         fprintf(stderr, "Invalid time %s\n", qPrintable(to));
+         return EXIT_FAILURE;
+      }
+
+      max = time.toMSecsSinceEpoch();
+   }
+
+   QByteArray text;
+   if (!read(path, min, max, text))
+   {
+      fprintf(stderr, "%s is not a readable QDriverStation log\n", qPrintable(path));
+      return EXIT_FAILURE;
+   }
+
+   fwrite(text.constData(), 1, text.size(), stdout);
+   return EXIT_SUCCESS;
+}
+
+/**
+ * Deletes the logs (and their indexes) that are older than the maximum age,
+ * and the oldest logs once the logs folder exceeds its maximum size
+ */
+void LogFile::removeOldLogs() const
+{
+   QDir dir(logsPath());
+   const QDateTime now = QDateTime::currentDateTime();
+   const QFileInfoList logs = dir.entryInfoList(QStringList("*.qdsl"), QDir::Files, QDir::Time);
+
+   qint64 total = 0;
+   foreach (const QFileInfo &log, logs)
+   {
+      const QFileInfo index(indexPath(log.absoluteFilePath()));
+      total += log.size() + index.size();
+
+      if (log.absoluteFilePath() == QFileInfo(m_file.fileName()).absoluteFilePath())
+         continue;
+
+      if (total > MaxFolderSize || log.lastModified().daysTo(now) > MaxAgeDays)
+      {
+         QFile::remove(log.absoluteFilePath());
+         QFile::remove(index.absoluteFilePath());
+      }
+   }
+}
+
+/**
+ * Reads the block positions from the index of the given log. The blocks that
+ * are missing from the index (e.g. if the application crashed while writing
+ * it) are found by reading the block headers that follow the last indexed
+ * block, without decompressing anything.
+ */
+bool LogFile::readIndex(const QString &path, QFile &file, QVector<IndexEntry> &entries)
+{
+   entries.clear();
+
+   QFile index(indexPath(path));
+   if (index.open(QIODevice::ReadOnly))
+   {
+      const QByteArray data = index.readAll();
+      if (data.size() >= INDEX_HEADER_SIZE && qFromLittleEndian<quint32>(data.constData()) == INDEX_MAGIC
+          && qFromLittleEndian<quint16>(data.constData() + 4) == FILE_VERSION)
+      {
+         const int count = (data.size() - INDEX_HEADER_SIZE) / INDEX_ENTRY_SIZE;
+         entries.reserve(count);
+         for (int i = 0; i < count; ++i)
+         {
+            const char *entry = data.constData() + INDEX_HEADER_SIZE + i * INDEX_ENTRY_SIZE;
+            IndexEntry e;
+            e.offset = qFromLittleEndian<qint64>(entry);
+            e.first = qFromLittleEndian<qint64>(entry + 8);
+            e.last = qFromLittleEndian<qint64>(entry + 16);
+            if (e.offset < FILE_HEADER_SIZE || e.offset + BLOCK_HEADER_SIZE > file.size())
+               break;
+
+            entries.append(e);
+         }
+      }
+   }
+
+   /* Find the first block that is not in the index */
+   qint64 offset = FILE_HEADER_SIZE;
+   if (!entries.isEmpty())
+   {
+      if (!file.seek(entries.last().offset))
+         return false;
+
+      const QByteArray head = file.read(BLOCK_HEADER_SIZE);
+      if (head.size() != BLOCK_HEADER_SIZE)
+         return false;
+
+      offset = entries.last().offset + BLOCK_HEADER_SIZE + qFromLittleEndian<quint32>(head.constData() + 4);
+   }
+
+   /* Read the headers of the remaining blocks */
+   while (offset + BLOCK_HEADER_SIZE <= file.size() && file.seek(offset))
+   {
+      const QByteArray head = file.read(BLOCK_HEADER_SIZE);
+      if (head.size() != BLOCK_HEADER_SIZE || qFromLittleEndian<quint32>(head.constData()) != BLOCK_MAGIC)
+         break;
+
+      const qint64 size = qFromLittleEndian<quint32>(head.constData() + 4);
+      if (offset + BLOCK_HEADER_SIZE + size > file.size())
+         break;
+
+      IndexEntry e;
+      e.offset = offset;
+      e.first = qFromLittleEndian<qint64>(head.constData() + 16);
+      e.last = qFromLittleEndian<qint64>(head.constData() + 24);
+      entries.append(e);
+
+      offset += BLOCK_HEADER_SIZE + size;
+   }
+
+   return true;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_LOG_FILE_H
+#define _QDS_LOG_FILE_H
+
+#include <QFile>
+#include <QVector>
+#include <QByteArray>
+
+/**
+ * \brief Compressed application log with a seekable index
+ *
+ * Log lines are collected in blocks of up to 64 KB (or 5 seconds), and each
+ * block is compressed with zlib and appended to the log file after a small
+ * header with its size and time range. The offset and time range of every
+ * block are also appended to a sidecar index file, so a reader can jump to
+ * the blocks of a given time without decompressing the rest of the log.
+ *
+ * A new log file is started when the current one grows too large, and old
+ * logs are deleted when they exceed the maximum age or when the logs folder
+ * exceeds its maximum size. All of this happens on the thread that writes the
+ * log, which is the logger thread of the application.
+ */
+class LogFile
+{
+public:
+   LogFile();
+   ~LogFile();
+
+   enum
+   {
+      BlockSize = 64 * 1024,
+      BlockAge = 5000,
+      MaxFileSize = 16 * 1024 * 1024,
+      MaxFolderSize = 256 * 1024 * 1024,
+      MaxAgeDays = 30,
+   };
+
+   bool isOpen() const;
+   QString path() const;
+
+   bool open();
+   void close();
+   void writeBlock();
+   void tick(const qint64 now);
+   void append(const qint64 time, const QByteArray &line);
+
+   static QString logsPath();
+   static QString indexPath(const QString &path);
+   static bool read(const QString &path, const qint64 from, const qint64 to, QByteArray &text);
+   static int print(const QString &path, const QString &from, const QString &to);
+
+private:
+   /**
+    * \brief Position and time range of a block, as stored in the index
+    */
+   struct IndexEntry
+   {
+      qint64 offset;
+      qint64 first;
+      qint64 last;
+   };
+
+   void removeOldLogs() const;
+   static bool readIndex(const QString &path, QFile &file, QVector<IndexEntry> &entries);
+
+private:
+   QFile m_file;
+   QFile m_index;
+   QByteArray m_block;
+   qint64 m_first;
+   qint64 m_last;
+   quint32 m_lines;
+};
+
+#endif
@@ -1,283 +1,490 @@
-/*
- * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-//------------------------------------------------------------------------------
-// Qt includes
-//------------------------------------------------------------------------------
-
-#include <QTime>
-#include <QtQml>
-#include <QMessageBox>
-#include <QApplication>
-#include <QDesktopServices>
-#include <QQmlApplicationEngine>
-
-#ifdef Q_OS_WIN
-#    include <windows.h>
-#endif
-
-//------------------------------------------------------------------------------
-// Library includes
-//------------------------------------------------------------------------------
-
-#include <stdio.h>
-#include <iostream>
-
-#include <QJoysticks.h>
-#include <EventLogger.h>
-#include <DriverStation.h>
-
-//------------------------------------------------------------------------------
-// Application includes
-//------------------------------------------------------------------------------
-
-#include "beeper.h"
-#include "versions.h"
-#include "shortcuts.h"
-#include "utilities.h"
-#include "dashboards.h"
-
-//------------------------------------------------------------------------------
-// CLI messages
-//------------------------------------------------------------------------------
-
-const QString WEBS = "We instructed your web browser to navigate to:        \n"
-                     "    %1                                                \n"
-                     "If nothing happens, please navigate to that URL.        ";
-
-const QString HELP = "Usage: qdriverstation [ options ... ]                 \n"
-                     "                                                      \n"
-                     "Options include:                                      \n"
-                     "    -b, --bug       Report a bug                      \n"
-                     "    -h, --help      Show this message                 \n"
-                     "    -r, --reset     Reset/clear the settings          \n"
-                     "    -c, --contact   Contact the lead developer        \n"
-                     "    -v, --version   Display the application version   \n"
-                     "    -w, --website   Open a web site of this project   \n";
-
-//------------------------------------------------------------------------------
-// Download joystick drivers if needed
-//------------------------------------------------------------------------------
-
-static void WelcomeMessages()
-{
-   QSettings settings(APP_COMPANY, APP_DSPNAME);
-   if (settings.value("FirstLaunch", true).toBool())
-   {
-      // Download Xbox drivers on Mac
-#ifdef Q_OS_MAC
-      QMessageBox xboxDrivers;
-      xboxDrivers.setIcon(QMessageBox::Question);
-      xboxDrivers.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
-      xboxDrivers.setDefaultButton(QMessageBox::Yes);
-      xboxDrivers.setWindowTitle(QObject::tr("Download Joystick Drivers"));
-      xboxDrivers.setText(QObject::tr("Do you want to install a driver "
-                                      "for Xbox joysticks?"));
-
-      xboxDrivers.setInformativeText(QObject::tr("Clicking \"Yes\" will open a web "
-                                                 "browser to download the drivers"));
-
-      if (xboxDrivers.exec() == QMessageBox::Yes)
-         QDesktopServices::openUrl(QUrl("https://github.com/360Controller/"
-                                        "360Controller/releases/latest"));
-#endif
-
-      settings.setValue("FirstLaunch", false);
-   }
-}
-
-//------------------------------------------------------------------------------
-// Utility functions
-//------------------------------------------------------------------------------
-
-static void showHelp()
-{
-   qDebug() << HELP.toStdString().c_str();
-}
-
-static void resetSettings()
-{
-   QSettings(APP_COMPANY, APP_DSPNAME).clear();
-   qDebug() << "QDriverStation settings cleared!";
-}
-
-static void contact()
-{
-   QString url = "mailto:" + CONTACT_URL;
-   QDesktopServices::openUrl(QUrl(url));
-   qDebug() << WEBS.arg(url).toStdString().c_str();
-}
-
-static void reportBug()
-{
-   QDesktopServices::openUrl(QUrl(APP_REPBUGS));
-   qDebug() << WEBS.arg(APP_REPBUGS).toStdString().c_str();
-}
-
-static void openWebsite()
-{
-   QDesktopServices::openUrl(QUrl(APP_WEBSITE));
-   qDebug() << WEBS.arg(APP_WEBSITE).toStdString().c_str();
-}
-
-static void showVersion()
-{
-   QString appver = APP_DSPNAME + " version " + APP_VERSION;
-   QString author = "Written by Alex Spataru <" + CONTACT_URL + ">";
-
-   qDebug() << appver.toStdString().c_str();
-   qDebug() << author.toStdString().c_str();
-}
-
-//------------------------------------------------------------------------------
-// Application init
-//------------------------------------------------------------------------------
-
-int main(int argc, char *argv[])
-{
-    // Fix console output on Windows (https://stackoverflow.com/a/41701133)
-    // This code will only execute if the application is started from the comamnd prompt
-#ifdef _WIN32
-    if (AttachConsole(ATTACH_PARENT_PROCESS))
-    {
-        // Open the console's active buffer
-        (void)freopen("CONOUT$", "w", stdout);
-        (void)freopen("CONOUT$", "w", stderr);
-
-        // Force print new-line (to avoid printing text over user commands)
-        printf("\n");
-    }
-#endif
-
-   /* Fix scalling issues on Windows */
- #ifndef Q_OS_WIN
-   QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
- #else
-   QApplication::setAttribute(Qt::AA_DisableHighDpiScaling);
- #endif
-
-   /* Set application info */
-   QApplication::setApplicationName(APP_DSPNAME);
-   QApplication::setOrganizationName(APP_COMPANY);
-   QApplication::setApplicationVersion(APP_VERSION);
-   QApplication::setOrganizationDomain(APP_WEBSITE);
-
-   /* Initialize application */
-   QString arguments;
-   QApplication app(argc, argv);
-
-   /* Read command line arguments */
-   if (app.arguments().count() >= 2)
-      arguments = app.arguments().at(1);
-
-   /* We have some arguments, read them */
-   if (!arguments.isEmpty() && arguments.startsWith("-"))
-   {
-      if (arguments == "-b" || arguments == "--bug")
-         reportBug();
-
-      else if (arguments == "-r" || arguments == "--reset")
-         resetSettings();
-
-      else if (arguments == "-c" || arguments == "--contact")
-         contact();
-
-      else if (arguments == "-v" || arguments == "--version")
-         showVersion();
-
-      else if (arguments == "-w" || arguments == "--website")
-         openWebsite();
-
-      else
-         showHelp();
-
-      return EXIT_SUCCESS;
-   }
-
-   /* Start the initialization time clock */
-   QElapsedTimer timer;
-   timer.start();
-
-   /* Initialize OS variables */
-   bool isMac = false;
-   bool isUnx = false;
-   bool isWin = false;
-
-   /* Let QML know the operating system */
-#if defined Q_OS_MAC
-   isMac = true;
-#elif defined Q_OS_WIN
-   isWin = true;
-#else
-   isUnx = true;
-#endif
-
-   /* Install the LibDS event logger */
-   DSEventLogger *CppDSLogger = DSEventLogger::getInstance();
-   qInstallMessageHandler(CppDSLogger->messageHandler);
-
-   /* Initialize application modules */
-   Beeper beeper;
-   Utilities utilities;
-   Shortcuts shortcuts;
-   Dashboards dashboards;
-   QJoysticks *qjoysticks = QJoysticks::getInstance();
-   DriverStation *driverstation = DriverStation::getInstance();
-
-   /* Set virtual joystick axis range */
-   qjoysticks->setVirtualJoystickAxisSensibility(0);
-
-   /* Configure the shortcuts handler and start the DS */
-   app.installEventFilter(&shortcuts);
-   driverstation->declareQML();
-   driverstation->start();
-
-   /* Load the QML interface */
-   QQmlApplicationEngine engine;
-   engine.rootContext()->setContextProperty("CppIsMac", isMac);
-   engine.rootContext()->setContextProperty("CppIsUnix", isUnx);
-   engine.rootContext()->setContextProperty("CppIsWindows", isWin);
-   engine.rootContext()->setContextProperty("CppBeeper", &beeper);
-   engine.rootContext()->setContextProperty("QJoysticks", qjoysticks);
-   engine.rootContext()->setContextProperty("CppUtilities", &utilities);
-   engine.rootContext()->setContextProperty("CppDashboard", &dashboards);
-   engine.rootContext()->setContextProperty("CppAppDspName", APP_DSPNAME);
-   engine.rootContext()->setContextProperty("CppAppVersion", APP_VERSION);
-   engine.rootContext()->setContextProperty("CppAppWebsite", APP_WEBSITE);
-   engine.rootContext()->setContextProperty("CppAppRepBugs", APP_REPBUGS);
-   engine.rootContext()->setContextProperty("CppDSLogger", CppDSLogger);
-   engine.rootContext()->setContextProperty("CppDS", driverstation);
-   engine.load(QUrl(QStringLiteral("qrc:/qml/main.qml")));
-
-   /* QML loading failed, exit the application */
-   if (engine.rootObjects().isEmpty())
-      return EXIT_FAILURE;
-
-   /* Tell user how much time was needed to initialize the app */
-   qDebug() << "Initialized in " << timer.elapsed() << "milliseconds";
-
-   /* Warn first-timers to download the xbox drivers on macOS */
-   WelcomeMessages();
-
-   /* Run normally */
-   return app.exec();
-}
+/*
+ * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+//------------------------------------------------------------------------------
+// Qt includes
+//------------------------------------------------------------------------------
+
+#include <QTime>
+#include <QtQml>
+#include <QMessageBox>
+#include <QApplication>
+#include <QDesktopServices>
+#include <QQmlApplicationEngine>
+
+#ifdef Q_OS_WIN
+#    include <windows.h>
+#endif
+
+//------------------------------------------------------------------------------
+// Library includes
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <iostream>
+
+#include <QJoysticks.h>
+#include <EventLogger.h>
+#include <DriverStation.h>
+
+//------------------------------------------------------------------------------
+// Application includes
+//------------------------------------------------------------------------------
+
+#include "beeper.h"
+#include "versions.h"
+#include "history.h"
+#include "logfile.h"
+#include "asynclogger.h"
+#include "joysticks.h"
+#include "floodcontrol.h"
+#include "messagemodel.h"
+#include "recorder.h"
+#include "controlserver.h"
+#include "statepublisher.h"
+#include "headless.h"
+#include "plotitem.h"
+#include "shortcuts.h"
+#include "sdlloader.h"
+#include "startupprofiler.h"
+#include "utilities.h"
+#include "dashboards.h"
+#include "benchmarks.h"
+#include "appsettings.h"
+
+//------------------------------------------------------------------------------
+// CLI messages
+//------------------------------------------------------------------------------
+
+const QString WEBS = "We instructed your web browser to navigate to:        \n"
+                     "    %1                                                \n"
+                     "If nothing happens, please navigate to that URL.        ";
+
+const QString HELP = "Usage: qdriverstation [ options ... ]                 \n"
+                     "                                                      \n"
+                     "Options include:                                      \n"
+                     "    -b, --bug       Report a bug                      \n"
+                     "    -h, --help      Show this message                 \n"
+                     "    -r, --reset     Reset/clear the settings          \n"
+                     "    -c, --contact   Contact the lead developer        \n"
+                     "    -v, --version   Display the application version   \n"
+                     "    -w, --website   Open a web site of this project   \n"
+                     "    --sync-logging  Write the log from the calling thread\n"
+                     "                                                      \n"
+                     "Headless mode:                                        \n"
+                     "    --headless [--team N] [--protocol P] [--station S] \n"
+                     "               [--game-data D]                        \n"
+                     "        Run the DS & joysticks without the interface  \n"
+                     "        and write the robot status to the standard    \n"
+                     "        output. The protocol & station are given by   \n"
+                     "        name (e.g. \"2020\", \"red1\"). Saved values   \n"
+                     "        are used for the team & game data if omitted  \n"
+                     "                                                      \n"
+                     "Benchmarks:                                           \n"
+                     "    --benchmark-input   Compare the QML & C++ input paths \n"
+                     "    --benchmark-audio   Measure the beeper synthesis time \n"
+                     "    --benchmark-logging Compare the sync & async log handlers\n"
+                     "    --benchmark-startup [N] Profile N cold starts (10) \n"
+                     "    --benchmark-shm     Measure the shared state updates \n"
+                     "                                                      \n"
+                     "Logs:                                                 \n"
+                     "    --read-log <file> [from] [to]                     \n"
+                     "        Write a compressed log (or the part between   \n"
+                     "        the given ISO 8601 times) to the standard     \n"
+                     "        output                                        \n"
+                     "                                                      \n"
+                     "Recordings:                                           \n"
+                     "    --decode-recording <file> [from] [to]             \n"
+                     "        Write a recording (or the part between the    \n"
+                     "        given seconds) to the standard output as CSV  \n"
+                     "    --record-input <file>                             \n"
+                     "        Run normally and write the joystick input to  \n"
+                     "        the given file                                \n"
+                     "    --replay <file> [--replace]                       \n"
+                     "        Run normally and play the given input file,   \n"
+                     "        mixed with (or replacing) the live joysticks  \n";
+
+//------------------------------------------------------------------------------
+// Download joystick drivers if needed
+//------------------------------------------------------------------------------
+
+static void WelcomeMessages()
+{
+   QSettings settings(APP_COMPANY, APP_DSPNAME);
+   if (settings.value("FirstLaunch", true).toBool())
+   {
+      // Download Xbox drivers on Mac
+#ifdef Q_OS_MAC
+      QMessageBox xboxDrivers;
+      xboxDrivers.setIcon(QMessageBox::Question);
+      xboxDrivers.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+      xboxDrivers.setDefaultButton(QMessageBox::Yes);
+      xboxDrivers.setWindowTitle(QObject::tr("Download Joystick Drivers"));
+      xboxDrivers.setText(QObject::tr("Do you want to install a driver "
+                                      "for Xbox joysticks?"));
+
+      xboxDrivers.setInformativeText(QObject::tr("Clicking \"Yes\" will open a web "
+                                                 "browser to download the drivers"));
+
+      if (xboxDrivers.exec() == QMessageBox::Yes)
+         QDesktopServices::openUrl(QUrl("https://github.com/360Controller/"
+                                        "360Controller/releases/latest"));
+#endif
+
+      settings.setValue("FirstLaunch", false);
+   }
+}
+
+//------------------------------------------------------------------------------
+// Utility functions
+//------------------------------------------------------------------------------
+
+static void showHelp()
+{
+   qDebug() << HELP.toStdString().c_str();
+}
+
+static void resetSettings()
+{
+   QSettings(APP_COMPANY, APP_DSPNAME).clear();
+   qDebug() << "QDriverStation settings cleared!";
+}
+
+static void contact()
+{
+   QString url = "mailto:" + CONTACT_URL;
+   QDesktopServices::openUrl(QUrl(url));
+   qDebug() << WEBS.arg(url).toStdString().c_str();
+}
+
+static void reportBug()
+{
+   QDesktopServices::openUrl(QUrl(APP_REPBUGS));
+   qDebug() << WEBS.arg(APP_REPBUGS).toStdString().c_str();
+}
+
+static void openWebsite()
+{
+   QDesktopServices::openUrl(QUrl(APP_WEBSITE));
+   qDebug() << WEBS.arg(APP_WEBSITE).toStdString().c_str();
+}
+
+static void showVersion()
+{
+   QString appver = APP_DSPNAME + " version " + APP_VERSION;
+   QString author = "Written by Alex Spataru <" + CONTACT_URL + ">";
+
+   qDebug() << appver.toStdString().c_str();
+   qDebug() << author.toStdString().c_str();
+}
+
+//------------------------------------------------------------------------------
+// Application init
+//------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+   /* Measure each phase of the startup */
+   StartupProfiler profiler;
+
+    // Fix console output on Windows (https://stackoverflow.com/a/41701133)
+    // This code will only execute if the application is started from the comamnd prompt
+#ifdef _WIN32
+    if (AttachConsole(ATTACH_PARENT_PROCESS))
+    {
+        // Open the console's active buffer
+        (void)freopen("CONOUT$", "w", stdout);
+        (void)freopen("CONOUT$", "w", stderr);
+
+        // Force print new-line (to avoid printing text over user commands)
+        printf("\n");
+    }
+#endif
+
+   /* Fix scalling issues on Windows */
+ #ifndef Q_OS_WIN
+   QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
+ #else
+   QApplication::setAttribute(Qt::AA_DisableHighDpiScaling);
+ #endif
+
+   /* Set application info */
+   QApplication::setApplicationName(APP_DSPNAME);
+   QApplication::setOrganizationName(APP_COMPANY);
+   QApplication::setApplicationVersion(APP_VERSION);
+   QApplication::setOrganizationDomain(APP_WEBSITE);
+
+   /* Run without the interface (and without a GUI application) if asked */
+   bool headless = false;
+   for (int i = 1; i < argc; ++i)
+      headless |= qstrcmp(argv[i], "--headless") == 0;
+
+   /* Initialize application */
+   QString arguments;
+   QScopedPointer<QCoreApplication> application(headless ? new QCoreApplication(argc, argv)
+                                                         : new QApplication(argc, argv));
+   QCoreApplication &app = *application;
+
+   /* Read command line arguments, the flags that can be combined with any
+    * other option are taken out first */
+   QStringList options = app.arguments();
+   const bool syncLogging = options.removeAll("--sync-logging") > 0;
+   options.removeAll("--headless");
+   if (options.count() >= 2)
+      arguments = options.at(1);
+
+   /* Started by --benchmark-startup, report the startup phases and quit */
+   const bool startupReport = arguments == "--startup-report";
+   if (startupReport)
+      arguments.clear();
+
+   /* Input recording & replay options, the application runs normally */
+   bool replaceInput = false;
+   QString replayPath;
+   QString recordInputPath;
+   if ((arguments == "--record-input" || arguments == "--replay") && options.count() >= 3)
+   {
+      if (arguments == "--record-input")
+         recordInputPath = options.at(2);
+      else
+         replayPath = options.at(2);
+
+      replaceInput = options.contains("--replace");
+      arguments.clear();
+   }
+
+   /* We have some arguments, read them (the headless options are read by
+    * the headless runner) */
+   if (!headless && !arguments.isEmpty() && arguments.startsWith("-"))
+   {
+      if (arguments == "-b" || arguments == "--bug")
+         reportBug();
+
+      else if (arguments == "-r" || arguments == "--reset")
+         resetSettings();
+
+      else if (arguments == "-c" || arguments == "--contact")
+         contact();
+
+      else if (arguments == "-v" || arguments == "--version")
+         showVersion();
+
+      else if (arguments == "-w" || arguments == "--website")
+         openWebsite();
+
+      else if (arguments == "--benchmark-input")
+         return benchmarkInput();
+
+      else if (arguments == "--benchmark-audio")
+         return benchmarkAudio();
+
+      else if (arguments == "--benchmark-logging")
+         return benchmarkLogging();
+
+      else if (arguments == "--benchmark-shm")
+         return benchmarkSharedMemory();
+
+      else if (arguments == "--benchmark-startup")
+         return benchmarkStartup(options.value(2).toInt());
+
+      else if (arguments == "--read-log" && options.count() >= 3)
+         return LogFile::print(options.at(2), options.value(3), options.value(4));
+
+      else if (arguments == "--decode-recording" && options.count() >= 3)
+      {
+         const qreal from = options.count() >= 4 ? options.at(3).toDouble() : -1;
+         const qreal to = options.count() >= 5 ? options.at(4).toDouble() : -1;
+         return Recorder::decode(options.at(2), from, to);
+      }
+
+      else
+         showHelp();
+
+      return EXIT_SUCCESS;
+   }
+
+   /* Initialize OS variables */
+   bool isMac = false;
+   bool isUnx = false;
+   bool isWin = false;
+
+   /* Let QML know the operating system */
+#if defined Q_OS_MAC
+   isMac = true;
+#elif defined Q_OS_WIN
+   isWin = true;
+#else
+   isUnx = true;
+#endif
+
+   profiler.mark("Application");
+
+   /* Install the LibDS event logger */
+   DSEventLogger *CppDSLogger = DSEventLogger::getInstance();
+   qInstallMessageHandler(CppDSLogger->messageHandler);
+
+   /* Write the compressed log from a background thread */
+   AsyncLogger logger;
+   if (!syncLogging)
+      logger.install();
+
+   profiler.mark("Logger");
+
+   /* Run the DS, joysticks & host probes without loading the interface */
+   if (headless)
+      return Headless::run(app.arguments());
+
+   /* Open the audio server in the background */
+   SdlLoader sdl;
+   sdl.start();
+
+   /* Initialize the modules that do not use SDL */
+   Beeper beeper;
+   Utilities utilities;
+   AppSettings settings;
+   Dashboards dashboards;
+   DriverStation *driverstation = DriverStation::getInstance();
+   Shortcuts shortcuts(driverstation);
+   QObject::connect(&dashboards, SIGNAL(processIdChanged(qint64)), &utilities, SLOT(setDashboardProcess(qint64)));
+   profiler.mark("Utilities, shortcuts & dashboards");
+
+   /* Keep the telemetry history for the charts */
+   History history(driverstation, &utilities);
+
+   /* Keep the console messages outside of QML, behind the flood control */
+   MessageModel messages;
+   FloodControl floodControl;
+   QObject::connect(driverstation, SIGNAL(newMessage(QString)), &floodControl, SLOT(ingest(QString)));
+   QObject::connect(&floodControl, SIGNAL(messageAccepted(QString)), &messages, SLOT(append(QString)));
+   QObject::connect(&floodControl, SIGNAL(messageRepeated(int, qint64)), &messages, SLOT(repeatLast(int, qint64)));
+
+   /* Start the DS */
+   driverstation->declareQML();
+   driverstation->start();
+   profiler.mark("DriverStation start");
+
+   /* Start the JVM of the saved dashboard while the interface loads */
+   if (!startupReport)
+      dashboards.prelaunch();
+
+   /* Register the C++ QML types */
+   qmlRegisterType<PlotItem>("QDriverStation", 1, 0, "PlotItem");
+   qmlRegisterUncreatableType<History>("QDriverStation", 1, 0, "History", "Use CppHistory");
+   qmlRegisterUncreatableType<MessageModel>("QDriverStation", 1, 0, "MessageModel", "Use CppMessages");
+
+   /* Compile the QML interface on the QML loader thread while SDL starts */
+   const QUrl mainQml(QStringLiteral("qrc:/qml/main.qml"));
+   QScopedPointer<QQmlApplicationEngine> engine(new QQmlApplicationEngine);
+   QScopedPointer<QQmlComponent> preload(new QQmlComponent(engine.data(), mainQml, QQmlComponent::Asynchronous));
+   profiler.mark("QML compilation started");
+
+   /* Enumerate the joysticks on this thread, SDL may be used from now on */
+   sdl.wait();
+   profiler.mark("SDL subsystems");
+
+   /* Forward joystick input to the DS without going through QML */
+   QJoysticks *qjoysticks = QJoysticks::getInstance();
+   Joysticks joysticks;
+
+   /* Trigger the emergency stop as soon as SDL queues the e-stop button */
+   shortcuts.watchJoysticks();
+
+   /* Record the robot status & joystick input while connected */
+   Recorder recorder(driverstation, &joysticks);
+
+   /* Publish the robot status & joystick input to local tools */
+   ControlServer controlServer(driverstation, &joysticks);
+   controlServer.listen();
+
+   /* Publish the DS state to other processes through shared memory */
+   StatePublisher statePublisher(driverstation, &joysticks);
+   statePublisher.open();
+
+   /* Record or play the joystick input stream */
+   InputPlayer player(&joysticks);
+   if (!recordInputPath.isEmpty())
+      joysticks.startInputRecording(recordInputPath);
+   if (!replayPath.isEmpty())
+   {
+      if (!player.load(replayPath))
+         return EXIT_FAILURE;
+
+      QObject::connect(&player, SIGNAL(finished()), &joysticks, SLOT(stopReplay()));
+      QObject::connect(&player, SIGNAL(finished()), &player, SLOT(printSummary()));
+      joysticks.startReplay(replaceInput);
+      player.start(QThread::TimeCriticalPriority);
+   }
+
+   /* Set virtual joystick axis range */
+   qjoysticks->setVirtualJoystickAxisSensibility(0);
+   profiler.mark("QJoysticks & input modules");
+
+   /* Open the audio device, the beeps requested until now are played */
+   beeper.start();
+   profiler.mark("Beeper (audio device)");
+
+   /* Load the QML interface */
+   engine->rootContext()->setContextProperty("CppIsMac", isMac);
+   engine->rootContext()->setContextProperty("CppIsUnix", isUnx);
+   engine->rootContext()->setContextProperty("CppIsWindows", isWin);
+   engine->rootContext()->setContextProperty("CppBeeper", &beeper);
+   engine->rootContext()->setContextProperty("QJoysticks", qjoysticks);
+   engine->rootContext()->setContextProperty("CppJoysticks", &joysticks);
+   engine->rootContext()->setContextProperty("CppShortcuts", &shortcuts);
+   engine->rootContext()->setContextProperty("CppHistory", &history);
+   engine->rootContext()->setContextProperty("CppRecorder", &recorder);
+   engine->rootContext()->setContextProperty("CppControlServer", &controlServer);
+   engine->rootContext()->setContextProperty("CppMessages", &messages);
+   engine->rootContext()->setContextProperty("CppFloodControl", &floodControl);
+   engine->rootContext()->setContextProperty("CppUtilities", &utilities);
+   engine->rootContext()->setContextProperty("CppDashboard", &dashboards);
+   engine->rootContext()->setContextProperty("CppSettings", &settings);
+   engine->rootContext()->setContextProperty("CppAppDspName", APP_DSPNAME);
+   engine->rootContext()->setContextProperty("CppAppVersion", APP_VERSION);
+   engine->rootContext()->setContextProperty("CppAppWebsite", APP_WEBSITE);
+   engine->rootContext()->setContextProperty("CppAppRepBugs", APP_REPBUGS);
+   engine->rootContext()->setContextProperty("CppDSLogger", CppDSLogger);
+   engine->rootContext()->setContextProperty("CppLogger", &logger);
+   engine->rootContext()->setContextProperty("CppDS", driverstation);
+   engine->load(mainQml);
+   preload.reset();
+
+   /* QML loading failed, exit the application */
+   if (engine->rootObjects().isEmpty())
+      return EXIT_FAILURE;
+
+   /* Handle the e-stop & enable keys before they reach the QML items */
+   shortcuts.watchWindows();
+
+   /* Tell user how much time was needed to initialize the app */
+   profiler.mark("QML engine load");
+   profiler.watchFirstFrame(startupReport);
+
+   /* Warn first-timers to download the xbox drivers on macOS */
+   if (!startupReport)
+      WelcomeMessages();
+
+   /* Run normally, the interface is destroyed before the modules it uses */
+   const int exitCode = app.exec();
+   engine.reset();
+   return exitCode;
+}
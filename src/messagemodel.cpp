@@ -0,0 +1,402 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "messagemodel.h"
+
+#include <QDateTime>
+#include <QTextDocumentFragment>
+
+MessageModel::MessageModel(QObject *parent)
+   : QAbstractListModel(parent)
+   , m_filter(kAll)
+   , m_capacity(DefaultCapacity)
+   , m_lastChanged(false)
+   , m_first(0)
+   , m_next(0)
+{
+   reset();
+
+   m_timer.setSingleShot(true);
+   m_timer.setInterval(FlushInterval);
+   connect(&m_timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+/**
+ * Returns the severity shown by the model, or \c kAll if the model is not
+ * filtered
+ */
+int MessageModel::filter() const
+{
+   return m_filter;
+}
+
+/**
+ * Returns the maximum number of messages kept by the model
+ */
+int MessageModel::capacity() const
+{
+   return m_capacity;
+}
+
+/**
+ * Returns the number of messages that match the current filter
+ */
+int MessageModel::rowCount(const QModelIndex &parent) const
+{
+   if (parent.isValid())
+      return 0;
+
+   if (m_filter == kAll)
+      return int(m_next - m_first);
+
+   return m_index[m_filter].count;
+}
+
+/**
+ * Returns the text or the severity of the given row
+ */
+QVariant MessageModel::data(const QModelIndex &index, int role) const
+{
+   if (!index.isValid() || index.row() < 0 || index.row() >= rowCount())
+      return QVariant();
+
+   const Message &msg = message(index.row());
+   switch (role)
+   {
+      case Qt::DisplayRole:
+      case TextRole:
+         return msg.text;
+      case SeverityRole:
+         return msg.severity;
+      case CountRole:
+         return msg.count;
+      case FirstRole:
+         return QDateTime::fromMSecsSinceEpoch(msg.first);
+      case LastRole:
+         return QDateTime::fromMSecsSinceEpoch(msg.last);
+      default:
+         return QVariant();
+   }
+}
+
+/**
+ * Returns the role names used by the QML delegates
+ */
+QHash<int, QByteArray> MessageModel::roleNames() const
+{
+   QHash<int, QByteArray> names;
+   names.insert(TextRole, "text");
+   names.insert(SeverityRole, "severity");
+   names.insert(CountRole, "count");
+   names.insert(FirstRole, "first");
+   names.insert(LastRole, "last");
+   return names;
+}
+
+/**
+ * Returns the messages that match the current filter without HTML tags,
+ * one message per line
+ */
+QString MessageModel::plainText() const
+{
+   QStringList lines;
+   const int rows = rowCount();
+   for (int i = 0; i < rows; ++i)
+   {
+      const Message &msg = message(i);
+      QString line = QTextDocumentFragment::fromHtml(msg.text).toPlainText();
+      if (msg.count > 1)
+         line.append(QString(" (x%1)").arg(msg.count));
+
+      lines.append(line);
+   }
+
+   return lines.join("\n");
+}
+
+/**
+ * Guesses the severity of a message generated by the DS.
+ *
+ * The DS messages start with "** Type:", any message without that prefix is
+ * considered to be output of the robot program. Only the beginning of the
+ * message is read, so long robot prints cost the same as short ones.
+ */
+int MessageModel::severityOf(const QString &message)
+{
+   QString label;
+   bool inTag = false;
+   const int length = qMin(message.length(), 256);
+   for (int i = 0; i < length && label.length() < 48; ++i)
+   {
+      const QChar c = message.at(i);
+      if (c == '<')
+         inTag = true;
+      else if (c == '>')
+         inTag = false;
+      else if (!inTag)
+      {
+         if (c == ':')
+            break;
+
+         label.append(c);
+      }
+   }
+
+   label = label.trimmed();
+   if (!label.startsWith("**"))
+      return kOutput;
+
+   label = label.toLower();
+   if (label.contains("error") || label.contains("fatal") || label.contains("critical"))
+      return kError;
+   if (label.contains("warning"))
+      return kWarning;
+
+   return kInformation;
+}
+
+/**
+ * Removes all the messages, including the ones that are still queued
+ */
+void MessageModel::clear()
+{
+   beginResetModel();
+   m_lastChanged = false;
+   m_pending.clear();
+   reset();
+   endResetModel();
+}
+
+/**
+ * Queues the given \a message, it is added to the model in the next flush
+ */
+void MessageModel::append(const QString &message)
+{
+   Message msg;
+   msg.text = message;
+   msg.severity = severityOf(message);
+   msg.count = 1;
+   msg.first = QDateTime::currentMSecsSinceEpoch();
+   msg.last = msg.first;
+   m_pending.append(msg);
+
+   if (!m_timer.isActive())
+      m_timer.start();
+}
+
+/**
+ * Sets the number of times that the newest message was received and the
+ * \a time of its last repetition, the view is updated in the next flush
+ */
+void MessageModel::repeatLast(const int count, const qint64 time)
+{
+   Message *msg = Q_NULLPTR;
+   if (!m_pending.isEmpty())
+      msg = &m_pending.last();
+   else if (m_next > m_first)
+   {
+      msg = &m_ring[int((m_next - 1) % quint64(m_capacity))];
+      m_lastChanged = true;
+   }
+
+   if (!msg)
+      return;
+
+   msg->count = count;
+   msg->last = time;
+
+   if (!m_timer.isActive())
+      m_timer.start();
+}
+
+/**
+ * Shows only the messages of the given severity, or all of them if \a filter
+ * is \c kAll
+ */
+void MessageModel::setFilter(const int filter)
+{
+   const int value = qBound<int>(kAll, filter, kError);
+   if (m_filter == value)
+      return;
+
+   beginResetModel();
+   m_filter = value;
+   endResetModel();
+
+   emit filterChanged();
+}
+
+/**
+ * Changes the number of messages kept by the model, the newest messages are
+ * preserved
+ */
+void MessageModel::setCapacity(const int capacity)
+{
+   const int value = qMax(capacity, 1);
+   if (m_capacity == value)
+      return;
+
+   QVector<Message> kept;
+   const quint64 stored = m_next - m_first;
+   const quint64 first = m_next - qMin<quint64>(stored, quint64(value));
+   for (quint64 seq = first; seq < m_next; ++seq)
+      kept.append(m_ring.at(int(seq % quint64(m_capacity))));
+
+   beginResetModel();
+   m_capacity = value;
+   reset();
+   foreach (const Message &msg, kept)
+      push(msg);
+   endResetModel();
+
+   emit capacityChanged();
+}
+
+/**
+ * Inserts the queued messages, dropping the oldest messages that no longer
+ * fit in the ring. The views are notified with a single removal and a single
+ * insertion, limited to the rows that match the current filter.
+ */
+void MessageModel::flush()
+{
+   /* Update the repetitions of the newest stored message */
+   if (m_lastChanged && m_next > m_first)
+   {
+      const int row = rowCount() - 1;
+      const int severity = m_ring.at(int((m_next - 1) % quint64(m_capacity))).severity;
+      if (matches(severity))
+         emit dataChanged(index(row), index(row), QVector<int>() << CountRole << LastRole);
+   }
+
+   m_lastChanged = false;
+
+   if (m_pending.isEmpty())
+      return;
+
+   /* Only the newest messages would survive anyway */
+   if (m_pending.count() > m_capacity)
+      m_pending.remove(0, m_pending.count() - m_capacity);
+
+   const int count = m_pending.count();
+   const int stored = int(m_next - m_first);
+   const int evicted = qMax(0, stored + count - m_capacity);
+
+   int removed = 0;
+   for (int i = 0; i < evicted; ++i)
+   {
+      if (matches(m_ring.at(int((m_first + i) % quint64(m_capacity))).severity))
+         ++removed;
+   }
+
+   if (removed > 0)
+      beginRemoveRows(QModelIndex(), 0, removed - 1);
+   for (int i = 0; i < evicted; ++i)
+      evictOldest();
+   if (removed > 0)
+      endRemoveRows();
+
+   int inserted = 0;
+   foreach (const Message &msg, m_pending)
+   {
+      if (matches(msg.severity))
+         ++inserted;
+   }
+
+   const int rows = rowCount();
+   if (inserted > 0)
+      beginInsertRows(QModelIndex(), rows, rows + inserted - 1);
+   foreach (const Message &msg, m_pending)
+      push(msg);
+   if (inserted > 0)
+      endInsertRows();
+
+   m_pending.clear();
+}
+
+/**
+ * Re-allocates the rings for the current capacity, without notifying the
+ * views
+ */
+void MessageModel::reset()
+{
+   m_first = 0;
+   m_next = 0;
+   m_ring = QVector<Message>(m_capacity);
+
+   for (int i = 0; i < SeverityCount; ++i)
+   {
+      m_index[i].head = 0;
+      m_index[i].count = 0;
+      m_index[i].seqs = QVector<quint64>(m_capacity);
+   }
+}
+
+/**
+ * Drops the oldest stored message, its sequence number is always the first
+ * one in the index of its severity
+ */
+void MessageModel::evictOldest()
+{
+   Message &msg = m_ring[int(m_first % quint64(m_capacity))];
+   Index &index = m_index[msg.severity];
+   index.head = (index.head + 1) % m_capacity;
+   --index.count;
+
+   msg.text.clear();
+   ++m_first;
+}
+
+/**
+ * Stores the given message, the ring must have a free slot
+ */
+void MessageModel::push(const Message &message)
+{
+   m_ring[int(m_next % quint64(m_capacity))] = message;
+
+   Index &index = m_index[message.severity];
+   index.seqs[(index.head + index.count) % m_capacity] = m_next;
+   ++index.count;
+   ++m_next;
+}
+
+/**
+ * Returns \c true if messages with the given \a severity are shown
+ */
+bool MessageModel::matches(const int severity) const
+{
+   return m_filter == kAll || m_filter == severity;
+}
+
+/**
+ * Returns the message shown at the given \a row
+ */
+const MessageModel::Message &MessageModel::message(const int row) const
+{
+   quint64 seq = m_first + quint64(row);
+   if (m_filter != kAll)
+   {
+      const Index &index = m_index[m_filter];
+      seq = index.seqs.at((index.head + row) % m_capacity);
+   }
+
+   return m_ring.at(int(seq % quint64(m_capacity)));
+}
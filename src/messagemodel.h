@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_MESSAGE_MODEL_H
+#define _QDS_MESSAGE_MODEL_H
+
+#include <QTimer>
+#include <QVector>
+#include <QAbstractListModel>
+
+/**
+ * \brief Fixed-capacity list of the console messages
+ *
+ * The messages are kept in a ring of \c capacity entries, when the ring is
+ * full the oldest message is dropped. Every message gets a sequence number,
+ * and each severity has its own ring with the sequence numbers of its
+ * messages, so a filtered view maps a row to a message with a single lookup.
+ *
+ * New messages are not inserted immediately, they are queued and inserted in
+ * a single batch once per frame, which keeps the view from re-creating its
+ * delegates for every robot print. Repetitions of the newest message only
+ * update its counter and the time of its last repetition.
+ */
+class MessageModel : public QAbstractListModel
+{
+   Q_OBJECT
+   Q_ENUMS(Severity)
+   Q_PROPERTY(int filter READ filter WRITE setFilter NOTIFY filterChanged)
+   Q_PROPERTY(int capacity READ capacity WRITE setCapacity NOTIFY capacityChanged)
+
+signals:
+   void filterChanged();
+   void capacityChanged();
+
+public:
+   explicit MessageModel(QObject *parent = Q_NULLPTR);
+
+   enum Severity
+   {
+      kAll = -1,
+      kOutput = 0,
+      kInformation = 1,
+      kWarning = 2,
+      kError = 3,
+   };
+
+   enum Roles
+   {
+      TextRole = Qt::UserRole + 1,
+      SeverityRole,
+      CountRole,
+      FirstRole,
+      LastRole,
+   };
+
+   enum
+   {
+      SeverityCount = 4,
+      DefaultCapacity = 2000,
+      FlushInterval = 16,
+   };
+
+   int filter() const;
+   int capacity() const;
+
+   int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+   QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+   QHash<int, QByteArray> roleNames() const override;
+
+   Q_INVOKABLE QString plainText() const;
+   static int severityOf(const QString &message);
+
+public slots:
+   void clear();
+   void append(const QString &message);
+   void repeatLast(const int count, const qint64 time);
+   void setFilter(const int filter);
+   void setCapacity(const int capacity);
+
+private slots:
+   void flush();
+
+private:
+   /**
+    * \brief A message and its severity, as stored in the ring
+    */
+   struct Message
+   {
+      QString text;
+      int severity;
+      int count;
+      qint64 first;
+      qint64 last;
+   };
+
+   /**
+    * \brief Sequence numbers of the stored messages of a single severity
+    */
+   struct Index
+   {
+      QVector<quint64> seqs;
+      int head;
+      int count;
+   };
+
+   void reset();
+   void evictOldest();
+   void push(const Message &message);
+   bool matches(const int severity) const;
+   const Message &message(const int row) const;
+
+private:
+   int m_filter;
+   int m_capacity;
+   bool m_lastChanged;
+
+   quint64 m_first;
+   quint64 m_next;
+   QVector<Message> m_ring;
+   QVector<Message> m_pending;
+   Index m_index[SeverityCount];
+
+   QTimer m_timer;
+};
+
+#endif
@@ -0,0 +1,695 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "plotitem.h"
+
+#include <QtMath>
+#include <QMatrix4x4>
+#include <QQuickWindow>
+#include <QSGGeometryNode>
+#include <QSGTransformNode>
+#include <QSGRectangleNode>
+#include <QSGRendererInterface>
+#include <QSGVertexColorMaterial>
+
+#include <string.h>
+
+/* Number of vertices used to draw a bar (two triangles) */
+static const int VERTICES_PER_BAR = 6;
+
+/**
+ * Sets the default values, which are the same as the ones of the old
+ * canvas-based plot widget
+ */
+PlotItem::PlotItem(QQuickItem *parent)
+   : QQuickItem(parent)
+{
+   m_to = 100;
+   m_from = 0;
+   m_value = 0;
+   m_rectWidth = 2;
+   m_barColor = Qt::white;
+   m_refreshInterval = 50;
+
+   m_channel = 0;
+   m_timeSpan = 60;
+   m_errorLevel = -1;
+   m_warningLevel = -1;
+   m_errorColor = Qt::red;
+   m_warningColor = Qt::yellow;
+
+   m_position = 0;
+   m_uploaded = 0;
+   m_reset = true;
+
+   /* The bars of the scrolled history are drawn beyond the sides */
+   setClip(true);
+   setFlag(ItemHasContents, true);
+
+   m_timer.setInterval(m_refreshInterval);
+   connect(&m_timer, SIGNAL(timeout()), this, SLOT(refresh()));
+   connect(this, SIGNAL(widthChanged()), this, SLOT(resize()));
+   connect(this, SIGNAL(heightChanged()), this, SLOT(resize()));
+}
+
+/**
+ * Returns the current value of the chart
+ */
+qreal PlotItem::value() const
+{
+   return m_value;
+}
+
+/**
+ * Returns the minimum value of the chart
+ */
+qreal PlotItem::from() const
+{
+   return m_from;
+}
+
+/**
+ * Returns the maximum value of the chart
+ */
+qreal PlotItem::to() const
+{
+   return m_to;
+}
+
+/**
+ * Returns the color used to draw the next bars
+ */
+QColor PlotItem::barColor() const
+{
+   return m_barColor;
+}
+
+/**
+ * Returns the width (in pixels) of each bar
+ */
+qreal PlotItem::rectWidth() const
+{
+   return m_rectWidth;
+}
+
+/**
+ * Returns the time (in milliseconds) between two bars
+ */
+int PlotItem::refreshInterval() const
+{
+   return m_refreshInterval;
+}
+
+/**
+ * Returns the history drawn by the item, or \c Q_NULLPTR if the item draws
+ * the values as they are refreshed
+ */
+History *PlotItem::history() const
+{
+   return m_history;
+}
+
+/**
+ * Returns the history channel drawn by the item
+ */
+int PlotItem::channel() const
+{
+   return m_channel;
+}
+
+/**
+ * Returns the time window (in seconds) drawn from the history
+ */
+qreal PlotItem::timeSpan() const
+{
+   return m_timeSpan;
+}
+
+/**
+ * Returns the level (from 0 to 1) below which the warning color is used
+ */
+qreal PlotItem::warningLevel() const
+{
+   return m_warningLevel;
+}
+
+/**
+ * Returns the level (from 0 to 1) below which the error color is used
+ */
+qreal PlotItem::errorLevel() const
+{
+   return m_errorLevel;
+}
+
+/**
+ * Returns the color of the history bars below the warning level
+ */
+QColor PlotItem::warningColor() const
+{
+   return m_warningColor;
+}
+
+/**
+ * Returns the color of the history bars below the error level
+ */
+QColor PlotItem::errorColor() const
+{
+   return m_errorColor;
+}
+
+/**
+ * Removes all the bars and starts drawing from the left side of the item
+ */
+void PlotItem::clear()
+{
+   m_reset = true;
+   m_position = 0;
+   update();
+}
+
+/**
+ * Changes the \a value used to draw the next bars
+ */
+void PlotItem::setValue(const qreal value)
+{
+   if (!qFuzzyCompare(value, m_value))
+   {
+      m_value = value;
+      emit valueChanged();
+   }
+}
+
+/**
+ * Changes the minimum value of the chart
+ */
+void PlotItem::setFrom(const qreal from)
+{
+   if (!qFuzzyCompare(from, m_from))
+   {
+      m_from = from;
+      emit rangeChanged();
+   }
+}
+
+/**
+ * Changes the maximum value of the chart
+ */
+void PlotItem::setTo(const qreal to)
+{
+   if (!qFuzzyCompare(to, m_to))
+   {
+      m_to = to;
+      emit rangeChanged();
+   }
+}
+
+/**
+ * Changes the color used to draw the next bars
+ */
+void PlotItem::setBarColor(const QColor &color)
+{
+   if (color != m_barColor)
+   {
+      m_barColor = color;
+      emit barColorChanged();
+   }
+}
+
+/**
+ * Changes the \a width of the bars, the chart is cleared
+ */
+void PlotItem::setRectWidth(const qreal width)
+{
+   if (width > 0 && !qFuzzyCompare(width, m_rectWidth))
+   {
+      m_rectWidth = width;
+      resize();
+      emit rectWidthChanged();
+   }
+}
+
+/**
+ * Changes the time (in milliseconds) between two bars
+ */
+void PlotItem::setRefreshInterval(const int interval)
+{
+   if (interval != m_refreshInterval)
+   {
+      m_refreshInterval = qMax(1, interval);
+      updateTimer();
+      emit refreshIntervalChanged();
+   }
+}
+
+/**
+ * Draws the given \a history instead of the refreshed values, or goes back
+ * to drawing the refreshed values if \a history is \c Q_NULLPTR
+ */
+void PlotItem::setHistory(History *history)
+{
+   if (history != m_history)
+   {
+      m_history = history;
+      resize();
+      emit historyChanged();
+   }
+}
+
+/**
+ * Changes the history \a channel drawn by the item
+ */
+void PlotItem::setChannel(const int channel)
+{
+   if (channel != m_channel)
+   {
+      m_channel = channel;
+      reloadHistory();
+      emit historyChanged();
+   }
+}
+
+/**
+ * Changes the time window (in \a seconds) drawn from the history
+ */
+void PlotItem::setTimeSpan(const qreal seconds)
+{
+   if (seconds > 0 && !qFuzzyCompare(seconds, m_timeSpan))
+   {
+      m_timeSpan = seconds;
+      reloadHistory();
+      updateTimer();
+      emit historyChanged();
+   }
+}
+
+/**
+ * Changes the level (from 0 to 1) below which the warning color is used,
+ * a negative level disables the warning color
+ */
+void PlotItem::setWarningLevel(const qreal level)
+{
+   if (!qFuzzyCompare(level, m_warningLevel))
+   {
+      m_warningLevel = level;
+      reloadHistory();
+      emit thresholdsChanged();
+   }
+}
+
+/**
+ * Changes the level (from 0 to 1) below which the error color is used,
+ * a negative level disables the error color
+ */
+void PlotItem::setErrorLevel(const qreal level)
+{
+   if (!qFuzzyCompare(level, m_errorLevel))
+   {
+      m_errorLevel = level;
+      reloadHistory();
+      emit thresholdsChanged();
+   }
+}
+
+/**
+ * Changes the color of the history bars below the warning level
+ */
+void PlotItem::setWarningColor(const QColor &color)
+{
+   if (color != m_warningColor)
+   {
+      m_warningColor = color;
+      reloadHistory();
+      emit thresholdsChanged();
+   }
+}
+
+/**
+ * Changes the color of the history bars below the error level
+ */
+void PlotItem::setErrorColor(const QColor &color)
+{
+   if (color != m_errorColor)
+   {
+      m_errorColor = color;
+      reloadHistory();
+      emit thresholdsChanged();
+   }
+}
+
+/**
+ * Starts or stops the refresh timer when the item is shown, hidden or
+ * added to a window
+ */
+void PlotItem::itemChange(ItemChange change, const ItemChangeData &data)
+{
+   QQuickItem::itemChange(change, data);
+
+   if (change == ItemVisibleHasChanged || change == ItemSceneChange)
+      QMetaObject::invokeMethod(this, "updateTimer", Qt::QueuedConnection);
+}
+
+/**
+ * Writes the bars added since the last frame to the scene graph, and scrolls
+ * the history so that the newest bar is on the right side
+ */
+QSGNode *PlotItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+   Q_UNUSED(data);
+
+   if (m_samples.isEmpty())
+   {
+      delete oldNode;
+      return Q_NULLPTR;
+   }
+
+   /* Create the node that scrolls the bars */
+   QSGTransformNode *node = static_cast<QSGTransformNode *>(oldNode);
+   if (!node)
+      node = new QSGTransformNode;
+
+   /* Update the bars */
+   QSGNode *bars = node->firstChild();
+   QSGNode *updated = Q_NULLPTR;
+   if (window()->rendererInterface()->graphicsApi() == QSGRendererInterface::Software)
+      updated = updateRectangleNodes(bars);
+   else
+      updated = updateGeometryNode(bars);
+
+   if (!bars)
+      node->appendChildNode(updated);
+
+   /* Move the oldest column of the history to the left side */
+   QMatrix4x4 matrix;
+   if (m_history)
+      matrix.translate(static_cast<float>(-slot(m_position) * m_rectWidth), 0.0f);
+
+   node->setMatrix(matrix);
+   return node;
+}
+
+/**
+ * Lets QML update the value, adds a bar with the current value & color
+ * and schedules a repaint
+ */
+void PlotItem::refresh()
+{
+   emit refreshed();
+
+   /* Draw the newest values of the history */
+   if (m_history)
+   {
+      readHistory();
+      return;
+   }
+
+   if (m_samples.isEmpty())
+      return;
+
+   /* Reset the graph if it is greater than the width */
+   if (m_position >= m_samples.count())
+   {
+      m_reset = true;
+      m_position = 0;
+   }
+
+   /* Add a single bar */
+   Sample &sample = m_samples[slot(m_position)];
+   sample.level = level(m_value);
+   sample.color = m_barColor.rgba();
+   ++m_position;
+
+   update();
+}
+
+/**
+ * Allocates a bar for each column of the item, the chart is cleared
+ */
+void PlotItem::resize()
+{
+   const int columns = width() > 0 && height() > 0 ? qCeil(width() / m_rectWidth) : 0;
+
+   m_samples.resize(columns);
+   clear();
+
+   readHistory();
+   updateTimer();
+}
+
+/**
+ * Only runs the refresh timer while the item can be seen
+ */
+void PlotItem::updateTimer()
+{
+   /* Add a column of history for each column of the item */
+   if (m_history && !m_samples.isEmpty())
+      m_timer.setInterval(qMax<int>(History::BasePeriod, m_timeSpan * 1000 / m_samples.count()));
+   else
+      m_timer.setInterval(m_refreshInterval);
+
+   if (isVisible() && window())
+   {
+      if (!m_timer.isActive())
+         m_timer.start();
+   }
+
+   else
+      m_timer.stop();
+}
+
+/**
+ * Clears the chart and draws the whole time window from the history again,
+ * used when the channel, the window or the colors of the bars change
+ */
+void PlotItem::reloadHistory()
+{
+   if (m_history)
+   {
+      clear();
+      readHistory();
+   }
+}
+
+/**
+ * Adds the columns of the history that have been completed since the last
+ * read, or fills all the bars with the last \c timeSpan seconds of the
+ * history if the chart was cleared. The newest bar is drawn on the right
+ * side of the item.
+ */
+void PlotItem::readHistory()
+{
+   if (!m_history || m_samples.isEmpty())
+      return;
+
+   /* Get the columns that have not been read yet */
+   const int columns = m_samples.count();
+   const qint64 last = m_history->lastColumn(m_timeSpan, columns);
+   qint64 first = last - columns + 1;
+   if (!m_reset)
+      first = qMax(first, m_position);
+
+   if (first > last)
+      return;
+
+   m_points.resize(static_cast<int>(last - first + 1));
+   m_history->read(m_channel, m_timeSpan, columns, first, m_points);
+
+   for (int i = 0; i < m_points.count(); ++i)
+   {
+      Sample &sample = m_samples[slot(first + i)];
+      const HistoryPoint &point = m_points.at(i);
+
+      /* No samples in this interval, leave a gap */
+      if (point.count == 0)
+      {
+         sample.level = 0;
+         sample.color = m_barColor.rgba();
+         continue;
+      }
+
+      /* Use the minimum value to pick the color, so that dips are shown */
+      const qreal minimum = level(point.min);
+      if (minimum <= m_errorLevel)
+         sample.color = m_errorColor.rgba();
+      else if (minimum <= m_warningLevel)
+         sample.color = m_warningColor.rgba();
+      else
+         sample.color = m_barColor.rgba();
+
+      sample.level = level(point.mean);
+   }
+
+   m_position = last + 1;
+   update();
+}
+
+/**
+ * Returns the bar used by the given \a column, the bars are used as a ring
+ * while the history is drawn
+ */
+int PlotItem::slot(const qint64 column) const
+{
+   const int count = m_samples.count();
+   return static_cast<int>(((column % count) + count) % count);
+}
+
+/**
+ * Calculates the ratio between the given \a value and the maxinum value
+ */
+qreal PlotItem::level(const qreal value) const
+{
+   if (qFuzzyIsNull(m_to))
+      return 0;
+
+   return qBound(0.0, qMax(value / m_to, m_from / m_to), 1.0);
+}
+
+/**
+ * Draws all the bars with a single geometry node, each vertex has the color
+ * of its bar. Only the vertices of the new bars are written, the vertices of
+ * the bars that have not been drawn yet are degenerate triangles. The history
+ * ring is drawn twice, so that the visible bars are always contiguous.
+ */
+QSGNode *PlotItem::updateGeometryNode(QSGNode *oldNode)
+{
+   const int columns = m_samples.count();
+   const int bars = m_history ? 2 * columns : columns;
+   const int vertexCount = bars * VERTICES_PER_BAR;
+   QSGGeometryNode *node = static_cast<QSGGeometryNode *>(oldNode);
+
+   /* Create the node */
+   if (!node)
+   {
+      node = new QSGGeometryNode;
+      node->setMaterial(new QSGVertexColorMaterial);
+      node->setFlag(QSGNode::OwnsMaterial);
+      node->setFlag(QSGNode::OwnsGeometry);
+   }
+
+   /* Allocate a vertex for each bar corner */
+   QSGGeometry *geometry = node->geometry();
+   if (!geometry || geometry->vertexCount() != vertexCount)
+   {
+      geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), vertexCount);
+      geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+      geometry->setVertexDataPattern(QSGGeometry::DynamicPattern);
+      node->setGeometry(geometry);
+      m_reset = true;
+   }
+
+   /* Remove all the bars */
+   QSGGeometry::ColoredPoint2D *vertices = geometry->vertexDataAsColoredPoint2D();
+   if (m_reset)
+   {
+      memset(vertices, 0, vertexCount * sizeof(QSGGeometry::ColoredPoint2D));
+      m_uploaded = 0;
+      m_reset = false;
+   }
+
+   /* Write the new bars */
+   const float h = static_cast<float>(height());
+   for (qint64 i = qMax(m_uploaded, m_position - columns); i < m_position; ++i)
+   {
+      const Sample &sample = m_samples.at(slot(i));
+      const float y = static_cast<float>((1 - sample.level) * h);
+
+      /* The vertex color material expects premultiplied colors */
+      const int a = qAlpha(sample.color);
+      const uchar r = static_cast<uchar>(qRed(sample.color) * a / 255);
+      const uchar g = static_cast<uchar>(qGreen(sample.color) * a / 255);
+      const uchar b = static_cast<uchar>(qBlue(sample.color) * a / 255);
+
+      for (int bar = slot(i); bar < bars; bar += columns)
+      {
+         const float x1 = static_cast<float>(bar * m_rectWidth);
+         const float x2 = static_cast<float>((bar + 1) * m_rectWidth);
+
+         QSGGeometry::ColoredPoint2D *v = vertices + bar * VERTICES_PER_BAR;
+         v[0].set(x1, y, r, g, b, a);
+         v[1].set(x2, y, r, g, b, a);
+         v[2].set(x1, h, r, g, b, a);
+         v[3].set(x2, y, r, g, b, a);
+         v[4].set(x2, h, r, g, b, a);
+         v[5].set(x1, h, r, g, b, a);
+      }
+   }
+
+   m_uploaded = m_position;
+   node->markDirty(QSGNode::DirtyGeometry);
+   return node;
+}
+
+/**
+ * Draws each bar with a rectangle node, used by the software renderer. The
+ * nodes are created once for each bar, only the nodes of the new bars are
+ * changed afterwards.
+ */
+QSGNode *PlotItem::updateRectangleNodes(QSGNode *oldNode)
+{
+   const int columns = m_samples.count();
+   const int bars = m_history ? 2 * columns : columns;
+
+   QSGNode *node = oldNode;
+   if (!node)
+      node = new QSGNode;
+
+   /* Create a node for each bar */
+   if (node->childCount() != bars)
+   {
+      while (QSGNode *child = node->firstChild())
+      {
+         node->removeChildNode(child);
+         delete child;
+      }
+
+      for (int i = 0; i < bars; ++i)
+         node->appendChildNode(window()->createRectangleNode());
+
+      m_reset = true;
+   }
+
+   /* Remove all the bars */
+   if (m_reset)
+   {
+      for (QSGNode *child = node->firstChild(); child; child = child->nextSibling())
+         static_cast<QSGRectangleNode *>(child)->setRect(QRectF());
+
+      m_uploaded = 0;
+      m_reset = false;
+   }
+
+   /* Change the nodes of the new bars */
+   for (qint64 i = qMax(m_uploaded, m_position - columns); i < m_position; ++i)
+   {
+      const Sample &sample = m_samples.at(slot(i));
+      const qreal y = (1 - sample.level) * height();
+
+      for (int bar = slot(i); bar < bars; bar += columns)
+      {
+         QSGRectangleNode *rect = static_cast<QSGRectangleNode *>(node->childAtIndex(bar));
+         rect->setRect(bar * m_rectWidth, y, m_rectWidth, height() - y);
+         rect->setColor(QColor::fromRgba(sample.color));
+      }
+   }
+
+   m_uploaded = m_position;
+   return node;
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_PLOT_ITEM_H
+#define _QDS_PLOT_ITEM_H
+
+#include <QTimer>
+#include <QColor>
+#include <QVector>
+#include <QPointer>
+#include <QQuickItem>
+
+#include "history.h"
+
+/**
+ * \brief Sweeping bar chart rendered with the scene graph
+ *
+ * Every \c refreshInterval milliseconds the item emits \c refreshed() (so that
+ * QML can update the value) and adds a bar of \c rectWidth pixels with the
+ * current value & color. When the bars reach the right side of the item, the
+ * chart is cleared and the sweep starts again from the left.
+ *
+ * Only the new bars are written to the scene graph on each frame, and the
+ * refresh timer is stopped while the item is not visible. The software
+ * renderer cannot draw custom geometry, so a rectangle node is used for each
+ * bar when the software backend is used.
+ *
+ * When a \c History object is set, the item draws the last \c timeSpan
+ * seconds of the selected channel instead, with the newest column on the
+ * right side. Each bar shows the mean of its interval, and is drawn with the
+ * warning or error color when the minimum of the interval falls below the
+ * \c warningLevel or \c errorLevel. Changing the time span redraws the chart
+ * from the history, so no data is lost.
+ *
+ * On each refresh, only the columns completed since the last read are taken
+ * from the history. The bars are kept in a ring that is drawn twice side by
+ * side, and the chart scrolls by moving a transform node, so a new column
+ * only writes its own two bars to the scene graph.
+ */
+class PlotItem : public QQuickItem
+{
+   Q_OBJECT
+   Q_PROPERTY(qreal value READ value WRITE setValue NOTIFY valueChanged)
+   Q_PROPERTY(qreal from READ from WRITE setFrom NOTIFY rangeChanged)
+   Q_PROPERTY(qreal to READ to WRITE setTo NOTIFY rangeChanged)
+   Q_PROPERTY(QColor barColor READ barColor WRITE setBarColor NOTIFY barColorChanged)
+   Q_PROPERTY(qreal rectWidth READ rectWidth WRITE setRectWidth NOTIFY rectWidthChanged)
+   Q_PROPERTY(int refreshInterval READ refreshInterval WRITE setRefreshInterval NOTIFY refreshIntervalChanged)
+   Q_PROPERTY(History *history READ history WRITE setHistory NOTIFY historyChanged)
+   Q_PROPERTY(int channel READ channel WRITE setChannel NOTIFY historyChanged)
+   Q_PROPERTY(qreal timeSpan READ timeSpan WRITE setTimeSpan NOTIFY historyChanged)
+   Q_PROPERTY(qreal warningLevel READ warningLevel WRITE setWarningLevel NOTIFY thresholdsChanged)
+   Q_PROPERTY(qreal errorLevel READ errorLevel WRITE setErrorLevel NOTIFY thresholdsChanged)
+   Q_PROPERTY(QColor warningColor READ warningColor WRITE setWarningColor NOTIFY thresholdsChanged)
+   Q_PROPERTY(QColor errorColor READ errorColor WRITE setErrorColor NOTIFY thresholdsChanged)
+
+signals:
+   void refreshed();
+   void valueChanged();
+   void rangeChanged();
+   void barColorChanged();
+   void rectWidthChanged();
+   void refreshIntervalChanged();
+   void historyChanged();
+   void thresholdsChanged();
+
+public:
+   explicit PlotItem(QQuickItem *parent = Q_NULLPTR);
+
+   qreal value() const;
+   qreal from() const;
+   qreal to() const;
+   QColor barColor() const;
+   qreal rectWidth() const;
+   int refreshInterval() const;
+   History *history() const;
+   int channel() const;
+   qreal timeSpan() const;
+   qreal warningLevel() const;
+   qreal errorLevel() const;
+   QColor warningColor() const;
+   QColor errorColor() const;
+
+public slots:
+   void clear();
+   void setValue(const qreal value);
+   void setFrom(const qreal from);
+   void setTo(const qreal to);
+   void setBarColor(const QColor &color);
+   void setRectWidth(const qreal width);
+   void setRefreshInterval(const int interval);
+   void setHistory(History *history);
+   void setChannel(const int channel);
+   void setTimeSpan(const qreal seconds);
+   void setWarningLevel(const qreal level);
+   void setErrorLevel(const qreal level);
+   void setWarningColor(const QColor &color);
+   void setErrorColor(const QColor &color);
+
+protected:
+   void itemChange(ItemChange change, const ItemChangeData &data) override;
+   QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+
+private slots:
+   void refresh();
+   void resize();
+   void updateTimer();
+
+private:
+   void reloadHistory();
+   void readHistory();
+   int slot(const qint64 column) const;
+   qreal level(const qreal value) const;
+   QSGNode *updateGeometryNode(QSGNode *oldNode);
+   QSGNode *updateRectangleNodes(QSGNode *oldNode);
+
+private:
+   /**
+    * \brief A single bar of the chart
+    */
+   struct Sample
+   {
+      qreal level;
+      QRgb color;
+   };
+
+   qreal m_to;
+   qreal m_from;
+   qreal m_value;
+   qreal m_rectWidth;
+   QColor m_barColor;
+   int m_refreshInterval;
+
+   int m_channel;
+   qreal m_timeSpan;
+   QPointer<History> m_history;
+   QVector<HistoryPoint> m_points;
+
+   qreal m_errorLevel;
+   qreal m_warningLevel;
+   QColor m_errorColor;
+   QColor m_warningColor;
+
+   qint64 m_position;
+   qint64 m_uploaded;
+   bool m_reset;
+
+   QTimer m_timer;
+   QVector<Sample> m_samples;
+};
+
+#endif
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "powersupply.h"
+
+#include <QDir>
+#include <QFile>
+#include <QDebug>
+#include <QSocketNotifier>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+/* Default location of the power supply class in the sysfs */
+static const char *SYSFS_PATH = "/sys/class/power_supply";
+
+/* Battery level polling interval, used in case uevents are not available */
+static const int POLL_INTERVAL = 1000;
+
+/* Battery level polling interval when we receive power supply uevents */
+static const int UEVENT_POLL_INTERVAL = 10000;
+
+/**
+ * Reads the given sysfs attribute from the beginning into \a buffer, which
+ * is always null-terminated. Returns the number of bytes read, or -1 on error.
+ */
+static int readAttribute(const int fd, char *buffer, const int size)
+{
+   const ssize_t bytes = pread(fd, buffer, size - 1, 0);
+   buffer[qMax<ssize_t>(0, bytes)] = '\0';
+   return static_cast<int>(bytes);
+}
+
+/**
+ * Opens the given attribute of a power supply, returns -1 if it does not exist
+ */
+static int openAttribute(const QString &supply, const char *attribute)
+{
+   const QByteArray path = QFile::encodeName(supply + "/" + attribute);
+   return open(path.constData(), O_RDONLY | O_CLOEXEC);
+}
+
+/**
+ * Opens the power supply attributes and starts listening for uevents
+ */
+PowerSupply::PowerSupply(const QString &path)
+{
+   m_path = path;
+   m_batteryLevel = 0;
+   m_ueventSocket = -1;
+   m_connectedToAC = false;
+   m_ueventNotifier = nullptr;
+
+   /* Get the sysfs location */
+   if (m_path.isEmpty())
+      m_path = QString::fromLocal8Bit(qgetenv("QDS_POWER_SUPPLY_PATH"));
+   if (m_path.isEmpty())
+      m_path = SYSFS_PATH;
+
+   /* Re-read the battery level from time to time */
+   connect(&m_timer, SIGNAL(timeout()), this, SLOT(update()));
+
+   openUeventSocket();
+   rescan();
+}
+
+/**
+ * Closes the attribute files and the uevent socket
+ */
+PowerSupply::~PowerSupply()
+{
+   closeFiles();
+
+   if (m_ueventSocket >= 0)
+      close(m_ueventSocket);
+}
+
+/**
+ * Returns the average charge of the batteries (from 0 to 100)
+ */
+int PowerSupply::batteryLevel() const
+{
+   return m_batteryLevel;
+}
+
+/**
+ * Returns \c true if a mains/USB power supply is online. If the system does not
+ * report any external power supply, we return \c true when the batteries are
+ * not discharging.
+ */
+bool PowerSupply::isConnectedToAC() const
+{
+   return m_connectedToAC;
+}
+
+/**
+ * Re-reads the opened attributes and emits \c changed() if the battery level
+ * or the AC state changed since the last update.
+ */
+void PowerSupply::update()
+{
+   char buffer[32];
+
+   /* Get the average battery level */
+   int level = 0;
+   int batteries = 0;
+   for (int i = 0; i < m_capacityFiles.count(); ++i)
+   {
+      if (readAttribute(m_capacityFiles.at(i), buffer, sizeof(buffer)) > 0)
+      {
+         level += qBound(0, atoi(buffer), 100);
+         ++batteries;
+      }
+   }
+
+   if (batteries > 0)
+      level /= batteries;
+
+   /* Check if any external power supply is online */
+   bool connectedToAC = false;
+   for (int i = 0; i < m_onlineFiles.count(); ++i)
+   {
+      if (readAttribute(m_onlineFiles.at(i), buffer, sizeof(buffer)) > 0 && atoi(buffer) > 0)
+         connectedToAC = true;
+   }
+
+   /* No external power supplies, check if the batteries are discharging */
+   if (m_onlineFiles.isEmpty())
+   {
+      connectedToAC = true;
+      for (int i = 0; i < m_statusFiles.count(); ++i)
+      {
+         if (readAttribute(m_statusFiles.at(i), buffer, sizeof(buffer)) > 0
+             && strncmp(buffer, "Discharging", 11) == 0)
+            connectedToAC = false;
+      }
+   }
+
+   /* Notify changes */
+   if (level != m_batteryLevel || connectedToAC != m_connectedToAC)
+   {
+      m_batteryLevel = level;
+      m_connectedToAC = connectedToAC;
+      emit changed();
+   }
+}
+
+/**
+ * Enumerates the power supplies and opens their attributes. This is called
+ * on startup and when a power supply is added or removed.
+ */
+void PowerSupply::rescan()
+{
+   closeFiles();
+
+   QDir dir(m_path);
+   const QStringList supplies = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::System);
+   foreach (const QString &name, supplies)
+   {
+      const QString supply = dir.absoluteFilePath(name);
+
+      /* Get the power supply type */
+      char type[32];
+      const int typeFile = openAttribute(supply, "type");
+      if (typeFile < 0)
+         continue;
+
+      readAttribute(typeFile, type, sizeof(type));
+      close(typeFile);
+
+      /* Batteries report their level & state */
+      if (strncmp(type, "Battery", 7) == 0)
+      {
+         const int scope = openAttribute(supply, "scope");
+         if (scope >= 0)
+         {
+            /* Ignore the batteries of mice, keyboards & joysticks */
+            char buffer[32];
+            readAttribute(scope, buffer, sizeof(buffer));
+            close(scope);
+
+            if (strncmp(buffer, "Device", 6) == 0)
+               continue;
+         }
+
+         const int capacity = openAttribute(supply, "capacity");
+         const int status = openAttribute(supply, "status");
+
+         if (capacity >= 0)
+            m_capacityFiles.append(capacity);
+         if (status >= 0)
+            m_statusFiles.append(status);
+      }
+
+      /* Everything else is an external power source */
+      else
+      {
+         const int online = openAttribute(supply, "online");
+         if (online >= 0)
+            m_onlineFiles.append(online);
+      }
+   }
+
+   /* Poll the battery level (slowly if uevents tell us about AC changes) */
+   m_timer.start(m_ueventSocket >= 0 ? UEVENT_POLL_INTERVAL : POLL_INTERVAL);
+   update();
+}
+
+/**
+ * Reads the pending kernel uevents and updates the power supply information
+ * if any of them comes from the power supply subsystem.
+ */
+void PowerSupply::readUevents()
+{
+   bool changed = false;
+   bool added = false;
+
+   char buffer[4096];
+   ssize_t bytes;
+   while ((bytes = recv(m_ueventSocket, buffer, sizeof(buffer) - 1, MSG_DONTWAIT)) > 0)
+   {
+      /* Uevents are a list of null-terminated strings */
+      buffer[bytes] = '\0';
+      bool powerSupply = false;
+      for (char *line = buffer; line < buffer + bytes; line += strlen(line) + 1)
+      {
+         if (strcmp(line, "SUBSYSTEM=power_supply") == 0)
+            powerSupply = true;
+      }
+
+      if (powerSupply)
+      {
+         changed = true;
+         if (strncmp(buffer, "add@", 4) == 0 || strncmp(buffer, "remove@", 7) == 0)
+            added = true;
+      }
+   }
+
+   if (added)
+      rescan();
+   else if (changed)
+      update();
+}
+
+/**
+ * Closes the opened attribute files
+ */
+void PowerSupply::closeFiles()
+{
+   foreach (const int fd, m_onlineFiles + m_statusFiles + m_capacityFiles)
+      close(fd);
+
+   m_onlineFiles.clear();
+   m_statusFiles.clear();
+   m_capacityFiles.clear();
+}
+
+/**
+ * Subscribes to the kernel uevents, if this fails, we fall back to polling
+ */
+void PowerSupply::openUeventSocket()
+{
+   m_ueventSocket = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+   if (m_ueventSocket < 0)
+      return;
+
+   struct sockaddr_nl address;
+   memset(&address, 0, sizeof(address));
+   address.nl_family = AF_NETLINK;
+   address.nl_groups = 1;
+
+   if (bind(m_ueventSocket, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0)
+   {
+      qWarning() << "Cannot listen for power supply uevents, polling instead";
+      close(m_ueventSocket);
+      m_ueventSocket = -1;
+      return;
+   }
+
+   m_ueventNotifier = new QSocketNotifier(m_ueventSocket, QSocketNotifier::Read, this);
+   connect(m_ueventNotifier, SIGNAL(activated(QSocketDescriptor, QSocketNotifier::Type)), this,
+           SLOT(readUevents()));
+}
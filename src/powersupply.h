@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_POWER_SUPPLY_H
+#define _QDS_POWER_SUPPLY_H
+
+#include <QTimer>
+#include <QObject>
+#include <QVector>
+
+class QSocketNotifier;
+
+/**
+ * \brief Reads the battery level and AC state from the Linux sysfs
+ *
+ * The power supply attributes in \c /sys/class/power_supply are opened once
+ * and re-read through the same file descriptors, so probing the battery does
+ * not spawn any process. Changes in the AC state are obtained by listening
+ * to the kernel uevents of the \c power_supply subsystem, the battery level is
+ * also re-read periodically because not every driver reports its changes.
+ *
+ * The sysfs directory can be replaced with the \c QDS_POWER_SUPPLY_PATH
+ * environment variable, which allows testing this class with a synthetic
+ * power supply tree.
+ */
+class PowerSupply : public QObject
+{
+   Q_OBJECT
+
+signals:
+   void changed();
+
+public:
+   explicit PowerSupply(const QString &path = QString());
+   ~PowerSupply();
+
+   int batteryLevel() const;
+   bool isConnectedToAC() const;
+
+public slots:
+   void update();
+   void rescan();
+
+private slots:
+   void readUevents();
+
+private:
+   void closeFiles();
+   void openUeventSocket();
+
+private:
+   QString m_path;
+   int m_batteryLevel;
+   bool m_connectedToAC;
+
+   int m_ueventSocket;
+   QSocketNotifier *m_ueventNotifier;
+
+   QTimer m_timer;
+   QVector<int> m_onlineFiles;
+   QVector<int> m_statusFiles;
+   QVector<int> m_capacityFiles;
+};
+
+#endif
@@ -0,0 +1,599 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "recorder.h"
+#include "varint.h"
+
+#include <QDir>
+#include <QDebug>
+#include <QtEndian>
+#include <QDateTime>
+#include <QStandardPaths>
+
+#include <stdio.h>
+#include <limits>
+
+//------------------------------------------------------------------------------
+// File format
+//------------------------------------------------------------------------------
+
+/* Magic numbers of the file & block headers */
+static const quint32 FILE_MAGIC = 0x52534451; // "QDSR"
+static const quint32 BLOCK_MAGIC = 0x42534451; // "QDSB"
+
+/* Version of the file format */
+static const quint16 FILE_VERSION = 1;
+
+/* Size of the file & block headers */
+static const int FILE_HEADER_SIZE = 32;
+static const int BLOCK_HEADER_SIZE = 32;
+
+/* Time between two frames (control packet rate) */
+static const int FRAME_PERIOD = 20;
+
+/* Maximum number of frames of a block (about 5 seconds) */
+static const int BLOCK_FRAMES = 256;
+
+/* The file is grown and mapped in chunks of this size */
+static const qint64 CHUNK_SIZE = 4 * 1024 * 1024;
+
+/* Maximum size of an encoded column (first value, mode & deltas) */
+static const int MAX_COLUMN_SIZE = 10 + 1 + (BLOCK_FRAMES - 1) * 10;
+
+/* Column encoding modes */
+static const uchar MODE_CONSTANT = 0;
+static const uchar MODE_DELTA = 1;
+
+/**
+ * Writes the given fixed-point \a value with the given number of \a decimals,
+ * returns the end of the text
+ */
+static char *writeFixed(char *out, qint64 value, const int decimals)
+{
+   char digits[24];
+   quint64 v = value < 0 ? 0 - static_cast<quint64>(value) : static_cast<quint64>(value);
+
+   int count = 0;
+   do
+   {
+      digits[count++] = static_cast<char>('0' + v % 10);
+      v /= 10;
+   } while (v || count <= decimals);
+
+   if (value < 0)
+      *out++ = '-';
+
+   while (count > decimals)
+      *out++ = digits[--count];
+
+   if (decimals > 0)
+   {
+      *out++ = '.';
+      while (count > 0)
+         *out++ = digits[--count];
+   }
+
+   return out;
+}
+
+//------------------------------------------------------------------------------
+// Writer thread
+//------------------------------------------------------------------------------
+
+/**
+ * Allocates the encoding buffers, the file is created by the thread
+ */
+RecorderWriter::RecorderWriter(const QString &path, QObject *parent)
+   : QThread(parent)
+   , m_path(path)
+   , m_file(path)
+{
+   m_map = Q_NULLPTR;
+   m_used = 0;
+   m_frames = 0;
+   m_mapStart = 0;
+   m_mapSize = 0;
+
+   m_columns.resize(BLOCK_FRAMES * DSState::ColumnCount);
+   m_block.resize(BLOCK_HEADER_SIZE + DSState::ColumnCount * MAX_COLUMN_SIZE);
+}
+
+/**
+ * Waits for the thread to write the remaining frames
+ */
+RecorderWriter::~RecorderWriter()
+{
+   requestStop();
+   wait();
+}
+
+/**
+ * Returns the path of the recording written by this thread
+ */
+QString RecorderWriter::path() const
+{
+   return m_path;
+}
+
+/**
+ * Hands the given \a state to the writer thread, returns \c false if the
+ * thread is behind and the frame was dropped.
+ * \note This function must only be called from a single thread
+ */
+bool RecorderWriter::push(const DSState &state)
+{
+   return m_ring.push(state);
+}
+
+/**
+ * Tells the thread to write the remaining frames and to close the file
+ */
+void RecorderWriter::requestStop()
+{
+   m_stop.storeRelease(1);
+}
+
+/**
+ * Creates the file and writes the frames received through the ring until
+ * the thread is told to stop
+ */
+void RecorderWriter::run()
+{
+   if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+   {
+      qWarning() << "Cannot create recording" << m_file.fileName() << m_file.errorString();
+      return;
+   }
+
+   /* Write the file header */
+   uchar header[FILE_HEADER_SIZE];
+   memset(header, 0, sizeof(header));
+   qToLittleEndian<quint32>(FILE_MAGIC, header);
+   qToLittleEndian<quint16>(FILE_VERSION, header + 4);
+   qToLittleEndian<quint16>(DSState::ColumnCount, header + 6);
+   qToLittleEndian<quint32>(FRAME_PERIOD, header + 8);
+   qToLittleEndian<quint32>(BLOCK_FRAMES, header + 12);
+   qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + 16);
+   bool ok = write(header, sizeof(header));
+
+   /* Encode the frames in blocks until we are told to stop */
+   DSState state;
+   while (ok)
+   {
+      const bool stop = m_stop.loadAcquire();
+      while (ok && m_ring.pop(state))
+      {
+         state.toColumns(m_columns.data() + m_frames * DSState::ColumnCount);
+         if (++m_frames == BLOCK_FRAMES)
+            ok = writeBlock();
+      }
+
+      if (stop)
+         break;
+
+      msleep(FRAME_PERIOD / 2);
+   }
+
+   /* Write the last frames & remove the unused space of the file */
+   if (ok)
+      writeBlock();
+
+   if (m_map)
+      m_file.unmap(m_map);
+
+   m_map = Q_NULLPTR;
+   m_file.resize(m_used);
+   m_file.close();
+}
+
+/**
+ * Encodes the pending frames as a block and appends it to the file
+ */
+bool RecorderWriter::writeBlock()
+{
+   if (m_frames == 0)
+      return true;
+
+   const int columns = DSState::ColumnCount;
+   uchar *begin = m_block.data();
+   uchar *out = begin + BLOCK_HEADER_SIZE;
+
+   /* Encode each column as its first value followed by the deltas */
+   for (int c = 0; c < columns; ++c)
+   {
+      const qint64 *values = m_columns.constData() + c;
+      out = writeVarint(out, values[0]);
+
+      bool constant = true;
+      for (int f = 1; f < m_frames && constant; ++f)
+         constant = (values[f * columns] == values[0]);
+
+      if (constant)
+         *out++ = MODE_CONSTANT;
+
+      else
+      {
+         *out++ = MODE_DELTA;
+         for (int f = 1; f < m_frames; ++f)
+            out = writeVarint(out, values[f * columns] - values[(f - 1) * columns]);
+      }
+   }
+
+   /* Write the block header */
+   memset(begin, 0, BLOCK_HEADER_SIZE);
+   qToLittleEndian<quint32>(BLOCK_MAGIC, begin);
+   qToLittleEndian<quint32>(m_frames, begin + 4);
+   qToLittleEndian<quint32>(static_cast<quint32>(out - begin - BLOCK_HEADER_SIZE), begin + 8);
+   qToLittleEndian<qint64>(m_columns.at(0), begin + 16);
+   qToLittleEndian<qint64>(m_columns.at((m_frames - 1) * columns), begin + 24);
+
+   m_frames = 0;
+   return write(begin, out - begin);
+}
+
+/**
+ * Ensures that the mapped region of the file has room for the given number
+ * of \a bytes after the used data, the file is grown if needed
+ */
+bool RecorderWriter::reserve(const qint64 bytes)
+{
+   if (m_map && m_used + bytes <= m_mapStart + m_mapSize)
+      return true;
+
+   if (m_map)
+      m_file.unmap(m_map);
+
+   m_mapStart = m_used;
+   m_mapSize = qMax(CHUNK_SIZE, bytes);
+   m_map = Q_NULLPTR;
+
+   if (m_file.resize(m_mapStart + m_mapSize))
+      m_map = m_file.map(m_mapStart, m_mapSize);
+
+   if (!m_map)
+   {
+      qWarning() << "Cannot map recording" << m_file.fileName() << m_file.errorString();
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * Appends the given \a data to the mapped file
+ */
+bool RecorderWriter::write(const uchar *data, const qint64 bytes)
+{
+   if (!reserve(bytes))
+      return false;
+
+   memcpy(m_map + (m_used - m_mapStart), data, bytes);
+   m_used += bytes;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// Recorder
+//------------------------------------------------------------------------------
+
+/**
+ * Starts capturing frames from the given \a driverstation & \a joysticks at
+ * the control packet rate
+ */
+Recorder::Recorder(DriverStation *driverstation, Joysticks *joysticks)
+{
+   m_dropped = 0;
+   m_enabled = false;
+   m_writer = Q_NULLPTR;
+   m_joysticks = joysticks;
+   m_driverstation = driverstation;
+   m_state.clear();
+
+   m_timer.setInterval(FRAME_PERIOD);
+   m_timer.setTimerType(Qt::PreciseTimer);
+   connect(&m_timer, SIGNAL(timeout()), this, SLOT(capture()));
+}
+
+/**
+ * Stops the current recording, the writer threads are children of this object
+ * and wait until their frames are written when they are destroyed
+ */
+Recorder::~Recorder()
+{
+   stop();
+}
+
+/**
+ * Returns \c true if the recorder is allowed to record
+ */
+bool Recorder::isEnabled() const
+{
+   return m_enabled;
+}
+
+/**
+ * Returns \c true if a recording is in progress
+ */
+bool Recorder::isRecording() const
+{
+   return m_writer != Q_NULLPTR;
+}
+
+/**
+ * Returns the path of the current (or last) recording
+ */
+QString Recorder::path() const
+{
+   return m_path;
+}
+
+/**
+ * Returns the number of frames that were dropped because a writer thread
+ * could not keep up
+ */
+int Recorder::droppedFrames() const
+{
+   return m_dropped;
+}
+
+/**
+ * Returns the folder in which the recordings are saved
+ */
+QString Recorder::recordingsPath()
+{
+   return QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/QDriverStation Recordings";
+}
+
+/**
+ * Writes the frames of the given recording between the \a from and \a to
+ * times (in seconds since the start of the recording, negative values are
+ * ignored) to the standard output as CSV. Blocks outside of the time range
+ * are skipped without being decoded.
+ */
+int Recorder::decode(const QString &path, const qreal from, const qreal to)
+{
+   QFile file(path);
+   if (!file.open(QIODevice::ReadOnly))
+   {
+      fprintf(stderr, "Cannot open %s: %s\n", qPrintable(path), qPrintable(file.errorString()));
+      return EXIT_FAILURE;
+   }
+
+   /* Map the whole file */
+   const qint64 size = file.size();
+   const uchar *data = size >= FILE_HEADER_SIZE ? file.map(0, size) : Q_NULLPTR;
+   if (!data || qFromLittleEndian<quint32>(data) != FILE_MAGIC)
+   {
+      fprintf(stderr, "%s is not a QDriverStation recording\n", qPrintable(path));
+      return EXIT_FAILURE;
+   }
+
+   /* Check that we can read this recording */
+   const int columns = qFromLittleEndian<quint16>(data + 6);
+   if (qFromLittleEndian<quint16>(data + 4) != FILE_VERSION || columns != DSState::ColumnCount)
+   {
+      fprintf(stderr, "%s was created by an unsupported version\n", qPrintable(path));
+      return EXIT_FAILURE;
+   }
+
+   /* Get the time range in milliseconds since the epoch */
+   const qint64 start = qFromLittleEndian<qint64>(data + 16);
+   const qint64 min = from >= 0 ? start + qRound64(from * 1000) : std::numeric_limits<qint64>::min();
+   const qint64 max = to >= 0 ? start + qRound64(to * 1000) : std::numeric_limits<qint64>::max();
+
+   /* Write the CSV header */
+   static char output[1 << 20];
+   setvbuf(stdout, output, _IOFBF, sizeof(output));
+   for (int c = 0; c < columns; ++c)
+      printf(c == 0 ? "%s" : ",%s", DSState::columnName(c).constData());
+   printf("\n");
+
+   QVector<qint64> values(columns * BLOCK_FRAMES);
+   QVector<char> line(columns * 24 + 2);
+
+   /* Read the blocks */
+   qint64 offset = FILE_HEADER_SIZE;
+   while (offset + BLOCK_HEADER_SIZE <= size)
+   {
+      const uchar *block = data + offset;
+      if (qFromLittleEndian<quint32>(block) != BLOCK_MAGIC)
+         break;
+
+      const int frames = static_cast<int>(qFromLittleEndian<quint32>(block + 4));
+      const qint64 payload = qFromLittleEndian<quint32>(block + 8);
+      const qint64 first = qFromLittleEndian<qint64>(block + 16);
+      const qint64 last = qFromLittleEndian<qint64>(block + 24);
+      if (frames <= 0 || frames > BLOCK_FRAMES || offset + BLOCK_HEADER_SIZE + payload > size)
+         break;
+
+      /* Skip the blocks that are outside of the time range */
+      offset += BLOCK_HEADER_SIZE + payload;
+      if (last < min)
+         continue;
+      if (first > max)
+         break;
+
+      /* Decode each column */
+      const uchar *in = block + BLOCK_HEADER_SIZE;
+      const uchar *end = in + payload;
+      for (int c = 0; c < columns && in; ++c)
+      {
+         qint64 *column = values.data() + c * frames;
+         in = readVarint(in, end, column[0]);
+         if (!in || in >= end)
+         {
+            in = Q_NULLPTR;
+            break;
+         }
+
+         if (*in++ == MODE_CONSTANT)
+         {
+            for (int f = 1; f < frames; ++f)
+               column[f] = column[0];
+         }
+
+         else
+         {
+            for (int f = 1; f < frames && in; ++f)
+            {
+               qint64 delta = 0;
+               in = readVarint(in, end, delta);
+               column[f] = column[f - 1] + delta;
+            }
+         }
+      }
+
+      if (!in)
+      {
+         fprintf(stderr, "Recording is corrupted at offset %lld\n", static_cast<long long>(offset));
+         break;
+      }
+
+      /* Write the frames that are inside the time range */
+      for (int f = 0; f < frames; ++f)
+      {
+         const qint64 time = values.at(f);
+         if (time < min || time > max)
+            continue;
+
+         char *out = writeFixed(line.data(), time - start, 3);
+         for (int c = 1; c < columns; ++c)
+         {
+            *out++ = ',';
+            out = writeFixed(out, values.at(c * frames + f), DSState::columnDecimals(c));
+         }
+
+         *out++ = '\n';
+         fwrite(line.constData(), 1, out - line.constData(), stdout);
+      }
+   }
+
+   fflush(stdout);
+   return EXIT_SUCCESS;
+}
+
+/**
+ * Starts or stops recording while connected to a robot
+ */
+void Recorder::setEnabled(const bool enabled)
+{
+   if (m_enabled != enabled)
+   {
+      m_enabled = enabled;
+      if (enabled)
+         m_timer.start();
+
+      else
+      {
+         m_timer.stop();
+         stop();
+      }
+
+      emit statusChanged();
+   }
+}
+
+/**
+ * Captures the current robot status & joystick input, a recording is started
+ * when the DS connects to the robot and stopped when the DS disconnects
+ */
+void Recorder::capture()
+{
+   m_state.capture(m_driverstation, m_joysticks);
+
+   if (m_state.connected)
+   {
+      if (!m_writer)
+         start();
+
+      if (!m_writer->push(m_state))
+         ++m_dropped;
+   }
+
+   else if (m_writer)
+      stop();
+}
+
+/**
+ * Creates a new recording file and starts its writer thread
+ */
+void Recorder::start()
+{
+   QDir dir(recordingsPath());
+   if (!dir.exists())
+      dir.mkpath(".");
+
+   /* A reconnection may happen while the previous writer is still running */
+   const QString name = QDateTime::currentDateTime().toString("yyyy-MM-dd hh-mm-ss-zzz");
+   m_path = dir.filePath(name + ".qdsr");
+   for (int i = 2; QFile::exists(m_path); ++i)
+      m_path = dir.filePath(QString("%1 (%2).qdsr").arg(name).arg(i));
+
+   m_writer = new RecorderWriter(m_path, this);
+   connect(m_writer, SIGNAL(finished()), m_writer, SLOT(deleteLater()));
+   m_writer->start(QThread::LowPriority);
+
+   removeOldRecordings();
+   emit statusChanged();
+}
+
+/**
+ * Tells the writer thread to finish the current recording, the thread is
+ * deleted once it is done (without waiting for it)
+ */
+void Recorder::stop()
+{
+   if (m_writer)
+   {
+      m_writer->requestStop();
+      m_writer = Q_NULLPTR;
+
+      emit statusChanged();
+   }
+}
+
+/**
+ * Removes the recordings that are older than \c MaxAgeDays, and the oldest
+ * recordings once the folder grows beyond \c MaxFolderSize. The recordings
+ * that are still being written are never removed.
+ */
+void Recorder::removeOldRecordings() const
+{
+   QStringList active;
+   foreach (const RecorderWriter *writer, findChildren<RecorderWriter *>())
+      active.append(QFileInfo(writer->path()).absoluteFilePath());
+
+   QDir dir(recordingsPath());
+   const QDateTime now = QDateTime::currentDateTime();
+   const QFileInfoList recordings = dir.entryInfoList(QStringList("*.qdsr"), QDir::Files, QDir::Time);
+
+   qint64 total = 0;
+   foreach (const QFileInfo &recording, recordings)
+   {
+      total += recording.size();
+      if (active.contains(recording.absoluteFilePath()))
+         continue;
+
+      if (total > MaxFolderSize || recording.lastModified().daysTo(now) > MaxAgeDays)
+         QFile::remove(recording.absoluteFilePath());
+   }
+}
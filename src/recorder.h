@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_RECORDER_H
+#define _QDS_RECORDER_H
+
+#include <QFile>
+#include <QTimer>
+#include <QThread>
+#include <QObject>
+#include <QAtomicInt>
+
+#include "dsstate.h"
+#include "ringbuffer.h"
+
+/**
+ * \brief Writes the recorded frames to a memory-mapped file
+ *
+ * Frames are received from the GUI thread through a lock-free ring, grouped
+ * in blocks and encoded in this thread. The file is grown and mapped in
+ * chunks, and truncated to its used size when the thread stops.
+ */
+class RecorderWriter : public QThread
+{
+   Q_OBJECT
+
+public:
+   explicit RecorderWriter(const QString &path, QObject *parent = Q_NULLPTR);
+   ~RecorderWriter();
+
+   QString path() const;
+   bool push(const DSState &state);
+   void requestStop();
+
+protected:
+   void run() override;
+
+private:
+   bool writeBlock();
+   bool reserve(const qint64 bytes);
+   bool write(const uchar *data, const qint64 bytes);
+
+private:
+   const QString m_path;
+
+   QFile m_file;
+   uchar *m_map;
+   qint64 m_used;
+   qint64 m_mapStart;
+   qint64 m_mapSize;
+
+   int m_frames;
+   QVector<uchar> m_block;
+   QVector<qint64> m_columns;
+
+   QAtomicInt m_stop;
+   RingBuffer<DSState, 256> m_ring;
+};
+
+/**
+ * \brief Records the robot status & joystick input while connected to a robot
+ *
+ * A frame with the voltage, packet loss, control mode, enable state, robot
+ * CPU/RAM/CAN usage and joystick state is captured every 20 ms (the control
+ * packet rate) and handed to a \c RecorderWriter thread. A new file is
+ * created for every connection to the robot, and the old recordings are
+ * removed with the same age & size limits as the DS logs.
+ *
+ * Recordings are stored in blocks of up to 256 frames. Each block starts
+ * with a header that holds the time range of the block, followed by the
+ * values of each column. Every column stores its first value followed by the
+ * difference between consecutive values (as zig-zag varints), or only its
+ * first value if it does not change during the block. This way, a decoder
+ * can skip the blocks outside of a time range without decoding them.
+ */
+class Recorder : public QObject
+{
+   Q_OBJECT
+   Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY statusChanged)
+   Q_PROPERTY(bool recording READ isRecording NOTIFY statusChanged)
+   Q_PROPERTY(QString path READ path NOTIFY statusChanged)
+
+signals:
+   void statusChanged();
+
+public:
+   enum
+   {
+      MaxFolderSize = 256 * 1024 * 1024,
+      MaxAgeDays = 30,
+   };
+
+   explicit Recorder(DriverStation *driverstation, Joysticks *joysticks);
+   ~Recorder();
+
+   bool isEnabled() const;
+   bool isRecording() const;
+   QString path() const;
+   int droppedFrames() const;
+
+   static QString recordingsPath();
+   static int decode(const QString &path, const qreal from, const qreal to);
+
+public slots:
+   void setEnabled(const bool enabled);
+
+private slots:
+   void capture();
+
+private:
+   void start();
+   void stop();
+   void removeOldRecordings() const;
+
+private:
+   bool m_enabled;
+   int m_dropped;
+   QString m_path;
+   QTimer m_timer;
+   DSState m_state;
+
+   Joysticks *m_joysticks;
+   RecorderWriter *m_writer;
+   DriverStation *m_driverstation;
+};
+
+#endif
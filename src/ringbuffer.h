@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_RING_BUFFER_H
+#define _QDS_RING_BUFFER_H
+
+#include <QAtomicInt>
+
+/**
+ * \brief Bounded, lock-free queue for one producer thread & one consumer thread
+ *
+ * The producer only writes the head index and the consumer only writes the
+ * tail index, so neither side ever waits for the other and no memory is
+ * allocated after construction. The \a Size must be a power of two, one of
+ * the slots is always left empty to tell a full ring from an empty one.
+ */
+template <typename T, int Size>
+class RingBuffer
+{
+   static_assert(Size > 1 && (Size & (Size - 1)) == 0, "Ring size must be a power of two");
+
+public:
+   RingBuffer()
+      : m_head(0)
+      , m_tail(0)
+   {
+   }
+
+   /**
+    * Appends the given \a item to the ring, returns \c false if the ring is
+    * full. Must only be called from the producer thread.
+    */
+   bool push(const T &item)
+   {
+      const int head = m_head.loadRelaxed();
+      const int next = (head + 1) & (Size - 1);
+      if (next == m_tail.loadAcquire())
+         return false;
+
+      m_items[head] = item;
+      m_head.storeRelease(next);
+      return true;
+   }
+
+   /**
+    * Removes the oldest item of the ring and copies it to \a item, returns
+    * \c false if the ring is empty. Must only be called from the consumer
+    * thread.
+    */
+   bool pop(T &item)
+   {
+      const int tail = m_tail.loadRelaxed();
+      if (tail == m_head.loadAcquire())
+         return false;
+
+      item = m_items[tail];
+      m_tail.storeRelease((tail + 1) & (Size - 1));
+      return true;
+   }
+
+   /**
+    * Returns \c true if the ring has no items, the value may be outdated as
+    * soon as it is returned.
+    */
+   bool isEmpty() const { return m_head.loadAcquire() == m_tail.loadAcquire(); }
+
+   /**
+    * Returns the maximum number of items that the ring can hold
+    */
+   static int capacity() { return Size - 1; }
+
+private:
+   /* Keep the indexes in different cache lines, so that they are not bounced
+    * between the producer and consumer cores on every operation */
+   alignas(64) QAtomicInt m_head;
+   alignas(64) QAtomicInt m_tail;
+   T m_items[Size];
+};
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "sdlloader.h"
+
+#include <QDebug>
+
+#include <SDL.h>
+
+SdlLoader::SdlLoader(const bool audio)
+   : m_audio(audio)
+   , m_thread(Q_NULLPTR)
+   , m_initialized(0)
+{
+}
+
+/**
+ * Waits for the loader thread and releases the subsystems that were
+ * initialized, after the beeper & joysticks were destroyed
+ */
+SdlLoader::~SdlLoader()
+{
+   if (m_thread)
+   {
+      m_thread->wait();
+      delete m_thread;
+   }
+
+   if (m_initialized)
+      SDL_QuitSubSystem(m_initialized);
+}
+
+/**
+ * Starts initializing the SDL audio subsystem on the loader thread
+ */
+void SdlLoader::start()
+{
+   if (m_thread || !m_audio)
+      return;
+
+   m_thread = QThread::create([this]() { initializeAudio(); });
+   m_thread->setObjectName("SDL Loader");
+   m_thread->start();
+}
+
+/**
+ * Blocks until the audio subsystem is initialized and initializes the
+ * joysticks on the calling thread, which must be the main thread. SDL may be
+ * used by the calling thread once this function returns.
+ */
+void SdlLoader::wait()
+{
+   if (m_thread)
+   {
+      m_thread->wait();
+      delete m_thread;
+      m_thread = Q_NULLPTR;
+   }
+
+   if (!(m_initialized & SDL_INIT_JOYSTICK))
+      initializeJoysticks();
+}
+
+/**
+ * Initializes the audio subsystem, called from the loader thread
+ */
+void SdlLoader::initializeAudio()
+{
+   if (SDL_InitSubSystem(SDL_INIT_AUDIO) == 0)
+      m_initialized |= SDL_INIT_AUDIO;
+   else
+      qWarning() << "Cannot initialize SDL audio:" << SDL_GetError();
+}
+
+/**
+ * Initializes the joystick subsystems, called from the main thread
+ */
+void SdlLoader::initializeJoysticks()
+{
+   const quint32 joysticks = SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER;
+   SDL_SetHint(SDL_HINT_JOYSTICK_ALLOW_BACKGROUND_EVENTS, "1");
+   if (SDL_InitSubSystem(joysticks) == 0)
+      m_initialized |= joysticks;
+   else
+      qWarning() << "Cannot initialize SDL joysticks:" << SDL_GetError();
+
+   /* Not every platform supports haptics, QJoysticks works without them */
+   if (SDL_InitSubSystem(SDL_INIT_HAPTIC) == 0)
+      m_initialized |= SDL_INIT_HAPTIC;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_SDL_LOADER_H
+#define _QDS_SDL_LOADER_H
+
+#include <QThread>
+
+/**
+ * \brief Initializes the SDL subsystems at launch, connecting to the audio
+ *        server on a background thread
+ *
+ * Connecting to the audio server can take a long time, specially right after
+ * the computer boots. The loader does it on a background thread while the
+ * main thread starts the DS and compiles the QML interface.
+ *
+ * The joystick & haptic subsystems are initialized by \c wait() on the main
+ * thread, after the audio thread is done. SDL creates the device notification
+ * window, the COM state and (on macOS) the HID run loop source of the joystick
+ * backends on the thread that initializes them, and those must live as long as
+ * the joysticks are used.
+ *
+ * SDL is never used by two threads at the same time and the launch order
+ * stays the same.
+ */
+class SdlLoader
+{
+public:
+   explicit SdlLoader(const bool audio = true);
+   ~SdlLoader();
+
+   void start();
+   void wait();
+
+private:
+   void initializeAudio();
+   void initializeJoysticks();
+
+private:
+   bool m_audio;
+   QThread *m_thread;
+   quint32 m_initialized;
+};
+
+#endif
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_SHARED_STATE_H
+#define _QDS_SHARED_STATE_H
+
+/*
+ * Layout of the shared memory segment where the DS publishes its state, and
+ * a reader for other processes. This header does not depend on Qt, so it can
+ * be copied to any C++11 project.
+ *
+ * Usage:
+ *
+ *    QDSSharedStateReader reader;
+ *    QDSSharedStatus status;
+ *    if (reader.open() && reader.snapshot(status) && !reader.isStale(status))
+ *       printf("Enabled: %d\n", status.enabled);
+ *
+ * The segment outlives a DS that crashed, with the last state that it
+ * published (which may be enabled). The DS publishes its state at least
+ * every QDS_SHARED_HEARTBEAT ms, even if nothing changed, and stores its
+ * process ID in the segment. A status must not be trusted if isStale()
+ * returns true: the DS process is gone, or its update counter did not
+ * change for QDS_SHARED_STALE_TIMEOUT ms (e.g. the DS is frozen).
+ */
+
+#include <atomic>
+#include <chrono>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _WIN32
+#   ifndef NOMINMAX
+#      define NOMINMAX
+#   endif
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <signal.h>
+#   include <unistd.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#endif
+
+#ifdef _WIN32
+#   define QDS_SHARED_STATE_NAME "Local\\qdriverstation-state"
+#else
+#   define QDS_SHARED_STATE_NAME "/qdriverstation-state"
+#endif
+
+enum
+{
+   QDS_SHARED_STATE_MAGIC = 0x53534451, /* "QDSS" */
+   QDS_SHARED_STATE_VERSION = 2,
+   QDS_SHARED_HEARTBEAT = 20,
+   QDS_SHARED_STALE_TIMEOUT = 500,
+   QDS_SHARED_JOYSTICKS = 6,
+   QDS_SHARED_JOYSTICK_AXES = 12,
+   QDS_SHARED_JOYSTICK_HATS = 4,
+};
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "The segment needs lock-free atomics");
+
+/**
+ * \brief Input state of a joystick
+ */
+struct QDSSharedJoystick
+{
+   uint8_t numAxes;
+   uint8_t numHats;
+   uint8_t numButtons;
+   uint8_t reserved;
+   uint32_t buttons;                            /* Bit mask */
+   int16_t axes[QDS_SHARED_JOYSTICK_AXES];      /* Thousandths */
+   int16_t hats[QDS_SHARED_JOYSTICK_HATS];      /* Angle, -1 if centered */
+};
+
+/**
+ * \brief Robot status & joystick input, as seen by the DS
+ */
+struct QDSSharedStatus
+{
+   int64_t timestamp;                           /* ms since epoch of the update */
+   uint64_t updates;                            /* Number of updates */
+   int16_t voltage;                             /* Hundredths of a volt */
+   uint8_t controlMode;                         /* 0: test, 1: auto, 2: teleop */
+   uint8_t enabled;
+   uint8_t emergencyStopped;
+   uint8_t connected;                           /* Connected to the robot */
+   uint8_t alliance;                            /* 0: red, 1: blue */
+   uint8_t position;                            /* 1, 2 or 3 */
+   uint8_t joystickCount;
+   uint8_t reserved[7];
+   QDSSharedJoystick joysticks[QDS_SHARED_JOYSTICKS];
+};
+
+/**
+ * \brief Copy of the status protected by a sequence counter
+ *
+ * The counter is odd while the writer copies the status to the slot.
+ */
+struct QDSSharedSlot
+{
+   std::atomic<uint32_t> sequence;
+   uint32_t reserved;
+   QDSSharedStatus status;
+};
+
+/**
+ * \brief Layout of the shared memory segment
+ *
+ * The DS writes every update to the slot that was not written last (under
+ * its seqlock), and then publishes the index of that slot. A reader copies
+ * the last published slot, which is only written again after the next
+ * update, so a copy can only fail if the DS updates its state twice while
+ * it is being copied. The number of attempts of a reader is bounded, so it
+ * never waits for the DS.
+ */
+struct QDSSharedSegment
+{
+   uint32_t magic;
+   uint16_t version;
+   uint16_t size;                               /* sizeof(QDSSharedSegment) */
+   std::atomic<uint32_t> latest;                /* Last published update */
+   uint32_t pid;                                /* Process ID of the DS, 0 once closed */
+   QDSSharedSlot slots[2];
+
+   /**
+    * Publishes the given \a status, this must only be called by the DS
+    */
+   void write(const QDSSharedStatus &status)
+   {
+      const uint32_t next = latest.load(std::memory_order_relaxed) + 1;
+      QDSSharedSlot &slot = slots[next & 1];
+
+      const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+      slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+
+      memcpy(&slot.status, &status, sizeof(QDSSharedStatus));
+
+      slot.sequence.store(sequence + 2, std::memory_order_release);
+      latest.store(next, std::memory_order_release);
+   }
+
+   /**
+    * Copies the last published status to \a status, returns \c false if no
+    * consistent copy was obtained in the given number of \a attempts
+    */
+   bool read(QDSSharedStatus &status, const int attempts) const
+   {
+      for (int i = 0; i < attempts; ++i)
+      {
+         const QDSSharedSlot &slot = slots[latest.load(std::memory_order_acquire) & 1];
+         const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+         if (sequence & 1)
+            continue;
+
+         memcpy(&status, &slot.status, sizeof(QDSSharedStatus));
+         std::atomic_thread_fence(std::memory_order_acquire);
+
+         if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+            return true;
+      }
+
+      return false;
+   }
+};
+
+/**
+ * \brief Maps the segment published by the DS (read-only)
+ */
+class QDSSharedStateReader
+{
+public:
+   QDSSharedStateReader()
+      : m_segment(nullptr)
+      , m_updates(0)
+#ifdef _WIN32
+      , m_handle(nullptr)
+#endif
+   {
+   }
+
+   ~QDSSharedStateReader() { close(); }
+
+   QDSSharedStateReader(const QDSSharedStateReader &) = delete;
+   QDSSharedStateReader &operator=(const QDSSharedStateReader &) = delete;
+
+   /**
+    * Maps the segment, returns \c false if the DS is not running or its
+    * segment has a different version
+    */
+   bool open(const char *name = QDS_SHARED_STATE_NAME)
+   {
+      close();
+      void *data = nullptr;
+
+#ifdef _WIN32
+      m_handle = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+      if (!m_handle)
+         return false;
+
+      data = MapViewOfFile(m_handle, FILE_MAP_READ, 0, 0, sizeof(QDSSharedSegment));
+      if (!data)
+      {
+         close();
+         return false;
+      }
+#else
+      const int fd = shm_open(name, O_RDONLY, 0);
+      if (fd < 0)
+         return false;
+
+      struct stat info;
+      if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(QDSSharedSegment))
+         data = mmap(nullptr, sizeof(QDSSharedSegment), PROT_READ, MAP_SHARED, fd, 0);
+
+      ::close(fd);
+      if (!data || data == MAP_FAILED)
+         return false;
+#endif
+
+      m_segment = static_cast<const QDSSharedSegment *>(data);
+      if (m_segment->magic != QDS_SHARED_STATE_MAGIC || m_segment->version != QDS_SHARED_STATE_VERSION
+          || m_segment->size != sizeof(QDSSharedSegment))
+      {
+         close();
+         return false;
+      }
+
+      return true;
+   }
+
+   /**
+    * Unmaps the segment
+    */
+   void close()
+   {
+#ifdef _WIN32
+      if (m_segment)
+         UnmapViewOfFile(m_segment);
+      if (m_handle)
+         CloseHandle(m_handle);
+
+      m_handle = nullptr;
+#else
+      if (m_segment)
+         munmap(const_cast<QDSSharedSegment *>(m_segment), sizeof(QDSSharedSegment));
+#endif
+
+      m_segment = nullptr;
+   }
+
+   /**
+    * Returns \c true if the segment is mapped
+    */
+   bool isOpen() const { return m_segment != nullptr; }
+
+   /**
+    * Copies the current DS state to \a status, see \c QDSSharedSegment::read()
+    */
+   bool snapshot(QDSSharedStatus &status, const int attempts = 4) const
+   {
+      return m_segment && m_segment->read(status, attempts);
+   }
+
+   /**
+    * Returns \c true if the DS that publishes the segment is still running
+    */
+   bool writerAlive() const
+   {
+      if (!m_segment || m_segment->pid == 0)
+         return false;
+
+#ifdef _WIN32
+      HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, m_segment->pid);
+      if (!process)
+         return false;
+
+      const bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+      CloseHandle(process);
+      return alive;
+#else
+      return kill(static_cast<pid_t>(m_segment->pid), 0) == 0 || errno == EPERM;
+#endif
+   }
+
+   /**
+    * Returns \c true if the given \a status (obtained with \c snapshot())
+    * must not be trusted, because the DS is not running or did not publish
+    * anything in the last \c QDS_SHARED_STALE_TIMEOUT ms. This should be
+    * called after every snapshot, so that the updates are noticed.
+    */
+   bool isStale(const QDSSharedStatus &status)
+   {
+      const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+      if (status.updates != m_updates)
+      {
+         m_updates = status.updates;
+         m_lastUpdate = now;
+      }
+
+      else if (now - m_lastUpdate > std::chrono::milliseconds(QDS_SHARED_STALE_TIMEOUT))
+         return true;
+
+      return !writerAlive();
+   }
+
+private:
+   const QDSSharedSegment *m_segment;
+   uint64_t m_updates;
+   std::chrono::steady_clock::time_point m_lastUpdate;
+#ifdef _WIN32
+   HANDLE m_handle;
+#endif
+};
+
+#endif
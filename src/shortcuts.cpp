@@ -1,48 +1,324 @@
-/*
- * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#include "shortcuts.h"
-#include <QJoysticks.h>
-#include <DriverStation.h>
-
-bool Shortcuts::eventFilter(QObject *object, QEvent *event)
-{
-   Q_UNUSED(object);
-
-   if (event->type() == QEvent::KeyPress)
-   {
-      switch (static_cast<QKeyEvent *>(event)->key())
-      {
-         case Qt::Key_Space:
-            DriverStation::getInstance()->setEmergencyStopped(true);
-            break;
-         case Qt::Key_Enter:
-            DriverStation::getInstance()->setEnabled(true);
-            break;
-         case Qt::Key_F1:
-            QJoysticks::getInstance()->updateInterfaces();
-            break;
-      }
-   }
-
-   return false;
-}
+/*
+ * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "shortcuts.h"
+#include "appsettings.h"
+
+#include <limits>
+
+#include <QUrl>
+#include <QDebug>
+#include <QWindow>
+#include <QDateTime>
+#include <QGuiApplication>
+#include <QDesktopServices>
+#include <QStandardPaths>
+#include <QInputMethodQueryEvent>
+
+#include <SDL.h>
+#include <QJoysticks.h>
+#include <DriverStation.h>
+
+/* Keys that can trigger the emergency stop (same order as the settings) */
+static const int EMERGENCY_STOP_KEYS[] = {
+   Qt::Key_Space,
+   Qt::Key_Backspace,
+   Qt::Key_Escape,
+   Qt::Key_F12,
+};
+
+/* Offset of an event clock that has not been compared to ours yet */
+static const qint64 NO_OFFSET = std::numeric_limits<qint64>::min();
+
+/* Change of the clock offset considered a jump (e.g. a 32-bit wrap), in ns */
+static const qint64 CLOCK_JUMP = 10000000000LL;
+
+/**
+ * Converts the \a time (in milliseconds) of an input event, taken from the
+ * clock of the windowing system or SDL, to the latency clock.
+ *
+ * The \a offset between both clocks is the smallest difference seen so far,
+ * so the fastest delivery of an event counts as zero and any later delivery
+ * (e.g. to a busy event loop) is included in the measured latency. Events
+ * without a timestamp are considered to be delivered right away.
+ */
+static qint64 EventTime(const qint64 time, qint64 *offset)
+{
+   const qint64 now = LatencyHistogram::timestamp();
+   if (time <= 0)
+      return now;
+
+   const qint64 difference = now - time * 1000000;
+   if (*offset == NO_OFFSET || difference < *offset || difference - *offset > CLOCK_JUMP)
+      *offset = difference;
+
+   return time * 1000000 + *offset;
+}
+
+/**
+ * Returns \c true if the item with the keyboard focus accepts text input
+ * (e.g. the team number or game data fields)
+ */
+static bool FocusAcceptsText()
+{
+   QObject *focus = QGuiApplication::focusObject();
+   if (!focus)
+      return false;
+
+   QInputMethodQueryEvent query(Qt::ImEnabled);
+   QCoreApplication::sendEvent(focus, &query);
+   return query.value(Qt::ImEnabled).toBool();
+}
+
+/**
+ * Loads the emergency stop triggers from the settings and watches the DS
+ * e-stop state to measure the time until the DS reports it
+ */
+Shortcuts::Shortcuts(DriverStation *driverstation)
+   : m_watchingSdl(false)
+   , m_triggered(0)
+   , m_keyClockOffset(NO_OFFSET)
+   , m_sdlClockOffset(NO_OFFSET)
+   , m_driverstation(driverstation)
+{
+   /* The joysticks may be used before the settings window is loaded */
+   setEmergencyStopKey(AppSettings::read("SettingsWindow/emergencyStopKey").toInt());
+   setEmergencyStopButton(AppSettings::read("SettingsWindow/emergencyStopButton").toInt() - 1);
+
+   connect(m_driverstation, &DriverStation::emergencyStoppedChanged, this, &Shortcuts::onEmergencyStoppedChanged);
+}
+
+/**
+ * Stops reading the SDL events
+ */
+Shortcuts::~Shortcuts()
+{
+   if (m_watchingSdl)
+      SDL_DelEventWatch(&Shortcuts::watchSdlEvent, this);
+}
+
+/**
+ * Filters the key events of the application windows, including the windows
+ * that are created later (key events are only sent to the focused window)
+ */
+void Shortcuts::watchWindows()
+{
+   foreach (QWindow *window, QGuiApplication::topLevelWindows())
+      watchWindow(window);
+
+   connect(qApp, SIGNAL(focusWindowChanged(QWindow *)), this, SLOT(watchWindow(QWindow *)));
+}
+
+/**
+ * Reads the joystick buttons from the SDL events as they are queued, so that
+ * the e-stop button does not wait for QJoysticks or the next input latch.
+ * \note SDL must be initialized before calling this function
+ */
+void Shortcuts::watchJoysticks()
+{
+   if (!m_watchingSdl)
+   {
+      SDL_AddEventWatch(&Shortcuts::watchSdlEvent, this);
+      m_watchingSdl = true;
+   }
+}
+/**
+ * Returns the index of the key that triggers the emergency stop
+ */
+int Shortcuts::emergencyStopKey() const
+{
+   return m_key;
+}
+
+/**
+ * Returns the joystick button that triggers the emergency stop, or -1 if
+ * the joysticks cannot trigger it
+ */
+int Shortcuts::emergencyStopButton() const
+{
+   return m_button;
+}
+
+/**
+ * Returns the median of the emergency stop latency (in milliseconds)
+ */
+qreal Shortcuts::latencyP50() const
+{
+   return m_latency.percentile(50) / 1e6;
+}
+
+/**
+ * Returns the 99th percentile of the emergency stop latency (in milliseconds)
+ */
+qreal Shortcuts::latencyP99() const
+{
+   return m_latency.percentile(99) / 1e6;
+}
+
+/**
+ * Returns the maximum emergency stop latency (in milliseconds)
+ */
+qreal Shortcuts::latencyMax() const
+{
+   return m_latency.maximum() / 1e6;
+}
+
+/**
+ * Returns the number of emergency stops that have been measured
+ */
+int Shortcuts::latencySamples() const
+{
+   return static_cast<int>(m_latency.count());
+}
+
+/**
+ * Clears the emergency stop latency histogram
+ */
+void Shortcuts::resetLatency()
+{
+   m_latency.reset();
+   emit latencyChanged();
+}
+
+/**
+ * Saves the emergency stop latency histogram as a CSV file in the documents
+ * folder and opens it with the default application
+ */
+void Shortcuts::exportLatency()
+{
+   const QString date = QDateTime::currentDateTime().toString("yyyy-MM-dd hh-mm-ss");
+   const QString path = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)
+                        + "/QDriverStation E-Stop Latency " + date + ".csv";
+
+   if (m_latency.save(path))
+      QDesktopServices::openUrl(QUrl::fromLocalFile(path));
+   else
+      qWarning() << "Cannot save e-stop latency histogram to" << path;
+}
+
+/**
+ * Changes the key that triggers the emergency stop
+ */
+void Shortcuts::setEmergencyStopKey(const int key)
+{
+   m_key = qBound<int>(kSpace, key, kF12);
+   m_keyCode = EMERGENCY_STOP_KEYS[m_key];
+   emit triggersChanged();
+}
+
+/**
+ * Changes the joystick button that triggers the emergency stop, a negative
+ * value disables the joystick trigger
+ */
+void Shortcuts::setEmergencyStopButton(const int button)
+{
+   m_button = qMax(-1, button);
+   emit triggersChanged();
+}
+
+/**
+ * Installs the key filter on the given \a window
+ */
+void Shortcuts::watchWindow(QWindow *window)
+{
+   if (window)
+      window->installEventFilter(this);
+}
+
+/**
+ * Records the time elapsed between the last e-stop input event and the moment
+ * in which the DS reported the emergency stop
+ */
+void Shortcuts::onEmergencyStoppedChanged()
+{
+   if (m_triggered <= 0 || !m_driverstation->isEmergencyStopped())
+      return;
+
+   m_latency.record(LatencyHistogram::timestamp() - m_triggered);
+   m_triggered = 0;
+   emit latencyChanged();
+}
+
+/**
+ * Sends the emergency stop to the DS, the \a triggered time is used to
+ * measure the e-stop latency
+ */
+void Shortcuts::emergencyStop(const qint64 triggered)
+{
+   if (m_driverstation->isEmergencyStopped())
+      return;
+
+   m_triggered = triggered;
+   m_driverstation->setEmergencyStopped(true);
+}
+
+/**
+ * Handles the key events of the watched windows, before they are delivered
+ * to the QML items. The e-stop keys other than space are ignored while the
+ * user types in a text field.
+ */
+bool Shortcuts::eventFilter(QObject *object, QEvent *event)
+{
+   Q_UNUSED(object);
+
+   if (event->type() != QEvent::KeyPress && event->type() != QEvent::KeyRelease)
+      return false;
+
+   /* Every key event refines the offset between the window system clock & ours */
+   const QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
+   const qint64 time = EventTime(keyEvent->timestamp(), &m_keyClockOffset);
+   if (event->type() != QEvent::KeyPress)
+      return false;
+
+   const int key = keyEvent->key();
+   if (key == m_keyCode)
+   {
+      if (m_keyCode == Qt::Key_Space || !FocusAcceptsText())
+         emergencyStop(time);
+   }
+
+   else if (key == Qt::Key_Enter)
+      m_driverstation->setEnabled(true);
+
+   else if (key == Qt::Key_F1)
+      QJoysticks::getInstance()->updateInterfaces();
+
+   return false;
+}
+
+/**
+ * Triggers the emergency stop when the e-stop button of any joystick is
+ * pressed (including blacklisted joysticks). This is called by SDL on the
+ * thread that pumps the events, as soon as the event is queued.
+ */
+int Shortcuts::watchSdlEvent(void *userdata, SDL_Event *event)
+{
+   if (event->type == SDL_JOYBUTTONDOWN)
+   {
+      Shortcuts *shortcuts = static_cast<Shortcuts *>(userdata);
+      const qint64 time = EventTime(event->jbutton.timestamp, &shortcuts->m_sdlClockOffset);
+      if (event->jbutton.button == shortcuts->m_button)
+         shortcuts->emergencyStop(time);
+   }
+
+   return 1;
+}
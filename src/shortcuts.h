@@ -1,44 +1,120 @@
-/*
- * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#ifndef _QDS_SHORTCUTS_H
-#define _QDS_SHORTCUTS_H
-
-#include <QObject>
-#include <QKeyEvent>
-#include <QApplication>
-
-/**
- * \brief Listens for keyboard events and acts if a shortcut has been activated
- *
- * This allows us to implement safety features, such as triggering an emergency
- * stop when pressing the spacebar, or disabling the robot when pressing enter.
- */
-class Shortcuts : public QObject
-{
-   Q_OBJECT
-
-private:
-   bool eventFilter(QObject *object, QEvent *event);
-};
-
-#endif
+/*
+ * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_SHORTCUTS_H
+#define _QDS_SHORTCUTS_H
+
+#include <QObject>
+#include <QKeyEvent>
+
+#include "latency.h"
+
+class QWindow;
+class DriverStation;
+union SDL_Event;
+
+/**
+ * \brief Listens for keyboard & joystick events and acts if a shortcut has
+ *        been activated
+ *
+ * This allows us to implement safety features, such as triggering an emergency
+ * stop when pressing the spacebar, or enabling the robot when pressing enter.
+ *
+ * The emergency stop does not wait for the rest of the application: the key
+ * events are filtered on the windows themselves (before they are delivered to
+ * the QML items), and the joystick buttons are read from the SDL events as
+ * they are queued, before QJoysticks processes them. The e-stop key and
+ * joystick button can be changed from the settings window.
+ *
+ * Both paths still run on the main thread, because SDL only reads the
+ * joysticks on the thread that pumps its events.
+ *
+ * The time elapsed between an e-stop input event and the moment in which the
+ * DS reports the emergency stop is recorded in a latency histogram, which is
+ * displayed in the diagnostics tab. The packet itself is sent by LibDS on its
+ * next cycle, up to one packet interval later.
+ */
+class Shortcuts : public QObject
+{
+   Q_OBJECT
+   Q_PROPERTY(int emergencyStopKey READ emergencyStopKey WRITE setEmergencyStopKey NOTIFY triggersChanged)
+   Q_PROPERTY(int emergencyStopButton READ emergencyStopButton WRITE setEmergencyStopButton NOTIFY triggersChanged)
+   Q_PROPERTY(qreal latencyP50 READ latencyP50 NOTIFY latencyChanged)
+   Q_PROPERTY(qreal latencyP99 READ latencyP99 NOTIFY latencyChanged)
+   Q_PROPERTY(qreal latencyMax READ latencyMax NOTIFY latencyChanged)
+   Q_PROPERTY(int latencySamples READ latencySamples NOTIFY latencyChanged)
+
+signals:
+   void triggersChanged();
+   void latencyChanged();
+
+public:
+   enum EmergencyStopKey
+   {
+      kSpace,
+      kBackspace,
+      kEscape,
+      kF12
+   };
+
+   explicit Shortcuts(DriverStation *driverstation);
+   ~Shortcuts();
+
+   void watchWindows();
+   void watchJoysticks();
+
+   int emergencyStopKey() const;
+   int emergencyStopButton() const;
+
+   qreal latencyP50() const;
+   qreal latencyP99() const;
+   qreal latencyMax() const;
+   int latencySamples() const;
+
+public slots:
+   void resetLatency();
+   void exportLatency();
+   void setEmergencyStopKey(const int key);
+   void setEmergencyStopButton(const int button);
+
+private slots:
+   void watchWindow(QWindow *window);
+   void onEmergencyStoppedChanged();
+
+private:
+   void emergencyStop(const qint64 triggered);
+   bool eventFilter(QObject *object, QEvent *event) override;
+   static int watchSdlEvent(void *userdata, SDL_Event *event);
+
+private:
+   int m_key;
+   int m_button;
+   int m_keyCode;
+   bool m_watchingSdl;
+   qint64 m_triggered;
+   qint64 m_keyClockOffset;
+   qint64 m_sdlClockOffset;
+   LatencyHistogram m_latency;
+   DriverStation *m_driverstation;
+};
+
+#endif
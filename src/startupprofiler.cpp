@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "startupprofiler.h"
+
+#include <QDebug>
+#include <QWindow>
+#include <QQuickWindow>
+#include <QGuiApplication>
+
+#include <stdio.h>
+
+StartupProfiler::StartupProfiler()
+   : m_quit(false)
+   , m_last(0)
+   , m_firstFrame(0)
+{
+   m_clock.start();
+}
+
+/**
+ * Returns the number of nanoseconds elapsed since the application started
+ */
+qint64 StartupProfiler::elapsed() const
+{
+   return m_clock.nsecsElapsed();
+}
+
+/**
+ * Ends the current startup phase and gives it the given \a phase name
+ */
+void StartupProfiler::mark(const QString &phase)
+{
+   const qint64 now = elapsed();
+
+   Phase p;
+   p.name = phase;
+   p.duration = now - m_last;
+   m_phases.append(p);
+
+   m_last = now;
+}
+
+/**
+ * Waits for the first frame of the visible windows to end the last phase.
+ * If \a quitWhenDone is set, the report is written to the standard output
+ * and the application quits.
+ */
+void StartupProfiler::watchFirstFrame(const bool quitWhenDone)
+{
+   m_quit = quitWhenDone;
+
+   bool watching = false;
+   foreach (QWindow *window, QGuiApplication::topLevelWindows())
+   {
+      QQuickWindow *quickWindow = qobject_cast<QQuickWindow *>(window);
+      if (quickWindow && quickWindow->isVisible())
+      {
+         connect(quickWindow, SIGNAL(frameSwapped()), this, SLOT(onFrameSwapped()), Qt::DirectConnection);
+         watching = true;
+      }
+   }
+
+   if (!watching)
+      QMetaObject::invokeMethod(this, "finish", Qt::QueuedConnection);
+}
+
+/**
+ * Ends the last phase and reports the duration of every phase
+ */
+void StartupProfiler::finish()
+{
+   foreach (QWindow *window, QGuiApplication::topLevelWindows())
+   {
+      QQuickWindow *quickWindow = qobject_cast<QQuickWindow *>(window);
+      if (quickWindow)
+         disconnect(quickWindow, SIGNAL(frameSwapped()), this, SLOT(onFrameSwapped()));
+   }
+
+   const qint64 frame = m_firstFrame.load();
+   if (frame > 0)
+   {
+      Phase p;
+      p.name = "First frame";
+      p.duration = frame - m_last;
+      m_phases.append(p);
+      m_last = frame;
+   }
+
+   if (m_quit)
+   {
+      foreach (const Phase &phase, m_phases)
+         printf("STARTUP\t%s\t%lld\n", qPrintable(phase.name), static_cast<long long>(phase.duration));
+
+      printf("STARTUP\tTotal\t%lld\n", static_cast<long long>(m_last));
+      fflush(stdout);
+      qApp->quit();
+      return;
+   }
+
+   qDebug() << "Initialized in" << m_last / 1000000 << "milliseconds";
+   foreach (const Phase &phase, m_phases)
+      qDebug() << "   " << qPrintable(phase.name.leftJustified(32, '.')) << phase.duration / 1000 / 1000.0 << "ms";
+}
+
+/**
+ * Called by the render thread of each window when a frame is presented, only
+ * the first frame of the first window counts
+ */
+void StartupProfiler::onFrameSwapped()
+{
+   qint64 expected = 0;
+   if (m_firstFrame.compare_exchange_strong(expected, elapsed()))
+      QMetaObject::invokeMethod(this, "finish", Qt::QueuedConnection);
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_STARTUP_PROFILER_H
+#define _QDS_STARTUP_PROFILER_H
+
+#include <atomic>
+#include <QObject>
+#include <QVector>
+#include <QElapsedTimer>
+
+/**
+ * \brief Measures the time spent in each phase of the application startup
+ *
+ * The clock starts when the profiler is created, at the top of \c main().
+ * Each call to \c mark() ends the current phase, and the last phase ends when
+ * the main window presents its first frame. The phases are then written to
+ * the log, or to the standard output (one tab-separated line per phase) when
+ * the application runs as a \c --benchmark-startup child process.
+ */
+class StartupProfiler : public QObject
+{
+   Q_OBJECT
+
+public:
+   StartupProfiler();
+
+   qint64 elapsed() const;
+   void mark(const QString &phase);
+   void watchFirstFrame(const bool quitWhenDone);
+
+private slots:
+   void finish();
+   void onFrameSwapped();
+
+private:
+   /**
+    * \brief Name and duration (in nanoseconds) of a startup phase
+    */
+   struct Phase
+   {
+      QString name;
+      qint64 duration;
+   };
+
+   bool m_quit;
+   qint64 m_last;
+   QElapsedTimer m_clock;
+   QVector<Phase> m_phases;
+   std::atomic<qint64> m_firstFrame;
+};
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "statepublisher.h"
+#include "joysticks.h"
+#include "dsstate.h"
+
+#include <new>
+
+#include <QDebug>
+#include <QDateTime>
+#include <QCoreApplication>
+
+static_assert(QDS_SHARED_JOYSTICKS == MAX_JOYSTICKS, "Joystick count mismatch");
+static_assert(QDS_SHARED_JOYSTICK_AXES == MAX_JOYSTICK_AXES, "Axis count mismatch");
+static_assert(QDS_SHARED_JOYSTICK_HATS == MAX_JOYSTICK_HATS, "Hat count mismatch");
+
+StatePublisher::StatePublisher(DriverStation *driverstation, Joysticks *joysticks)
+   : m_segment(Q_NULLPTR)
+   , m_joysticks(joysticks)
+   , m_driverstation(driverstation)
+#ifdef Q_OS_WIN
+   , m_handle(Q_NULLPTR)
+#endif
+{
+   memset(&m_status, 0, sizeof(m_status));
+
+   /* Update the status when the DS reports a change */
+   DSState::connectStatus(m_driverstation, this, &StatePublisher::updateStatus);
+   connect(m_driverstation, &DriverStation::stationChanged, this, &StatePublisher::updateStatus);
+
+   /* Update the joysticks every time that their input is sent to the DS */
+   connect(m_joysticks, SIGNAL(inputLatched()), this, SLOT(updateJoysticks()));
+
+   /* Publish the state again when nothing changed for a control period */
+   m_heartbeat.setSingleShot(true);
+   m_heartbeat.setInterval(QDS_SHARED_HEARTBEAT);
+   m_heartbeat.setTimerType(Qt::PreciseTimer);
+   connect(&m_heartbeat, SIGNAL(timeout()), this, SLOT(publish()));
+}
+
+/**
+ * Publishes a disabled state & removes the segment
+ */
+StatePublisher::~StatePublisher()
+{
+   close();
+}
+
+/**
+ * Creates the shared memory segment with the given \a name and publishes
+ * the current state in it
+ */
+bool StatePublisher::open(const char *name)
+{
+   close();
+   void *data = Q_NULLPTR;
+
+#ifdef Q_OS_WIN
+   m_handle = CreateFileMappingA(INVALID_HANDLE_VALUE, Q_NULLPTR, PAGE_READWRITE, 0, sizeof(QDSSharedSegment), name);
+   if (m_handle)
+      data = MapViewOfFile(m_handle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(QDSSharedSegment));
+#else
+   /* Other users may read the segment, only the DS writes it */
+   const int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+   if (fd >= 0)
+   {
+      if (ftruncate(fd, sizeof(QDSSharedSegment)) == 0)
+         data = mmap(Q_NULLPTR, sizeof(QDSSharedSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+      ::close(fd);
+      if (data == MAP_FAILED)
+         data = Q_NULLPTR;
+   }
+#endif
+
+   if (!data)
+   {
+      qWarning() << "Cannot create the shared state segment" << name;
+      close();
+      return false;
+   }
+
+   m_name = name;
+   m_segment = new (data) QDSSharedSegment();
+   m_segment->magic = QDS_SHARED_STATE_MAGIC;
+   m_segment->version = QDS_SHARED_STATE_VERSION;
+   m_segment->size = sizeof(QDSSharedSegment);
+   m_segment->pid = static_cast<uint32_t>(QCoreApplication::applicationPid());
+
+   updateJoysticks();
+   updateStatus();
+   return true;
+}
+
+/**
+ * Publishes a disabled & disconnected state, so that readers that keep the
+ * segment mapped do not act on a stale state, and removes the segment
+ */
+void StatePublisher::close()
+{
+   if (m_segment)
+   {
+      const quint64 updates = m_status.updates;
+      memset(&m_status, 0, sizeof(m_status));
+      m_status.updates = updates;
+      publish();
+
+      m_heartbeat.stop();
+      m_segment->pid = 0;
+
+#ifdef Q_OS_WIN
+      UnmapViewOfFile(m_segment);
+#else
+      munmap(m_segment, sizeof(QDSSharedSegment));
+      shm_unlink(m_name.constData());
+#endif
+   }
+
+#ifdef Q_OS_WIN
+   if (m_handle)
+      CloseHandle(m_handle);
+
+   m_handle = Q_NULLPTR;
+#endif
+
+   m_segment = Q_NULLPTR;
+}
+
+/**
+ * Reads the robot status from the DS and publishes it
+ */
+void StatePublisher::updateStatus()
+{
+   DSState status;
+   status.captureStatus(m_driverstation);
+
+   const int station = m_driverstation->station();
+   m_status.voltage = status.voltage;
+   m_status.controlMode = status.controlMode;
+   m_status.enabled = status.enabled;
+   m_status.emergencyStopped = status.emergencyStopped;
+   m_status.connected = status.connected;
+   m_status.alliance = static_cast<uint8_t>(station / 3);
+   m_status.position = static_cast<uint8_t>(station % 3 + 1);
+
+   publish();
+}
+
+/**
+ * Copies the joystick input that was sent to the DS and publishes it
+ */
+void StatePublisher::updateJoysticks()
+{
+   m_status.joystickCount = static_cast<uint8_t>(qMin(m_joysticks->count(), MAX_JOYSTICKS));
+   for (int js = 0; js < m_status.joystickCount; ++js)
+   {
+      const JoystickState &state = m_joysticks->state(js);
+      QDSSharedJoystick &joystick = m_status.joysticks[js];
+
+      joystick.numAxes = static_cast<uint8_t>(state.numAxes);
+      joystick.numHats = static_cast<uint8_t>(state.numHats);
+      joystick.numButtons = static_cast<uint8_t>(state.numButtons);
+      joystick.buttons = state.buttons;
+
+      for (int i = 0; i < state.numAxes; ++i)
+         joystick.axes[i] = static_cast<int16_t>(qRound(state.axes[i] * 1000));
+      for (int i = 0; i < state.numHats; ++i)
+         joystick.hats[i] = state.hats[i];
+   }
+
+   publish();
+}
+
+/**
+ * Writes the status to the segment, and schedules the next heartbeat
+ */
+void StatePublisher::publish()
+{
+   if (!m_segment)
+      return;
+
+   ++m_status.updates;
+   m_status.timestamp = QDateTime::currentMSecsSinceEpoch();
+   m_segment->write(m_status);
+   m_heartbeat.start();
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_STATE_PUBLISHER_H
+#define _QDS_STATE_PUBLISHER_H
+
+#include <QTimer>
+#include <QObject>
+
+#include "sharedstate.h"
+
+class Joysticks;
+class DriverStation;
+
+/**
+ * \brief Publishes the DS state in a shared memory segment
+ *
+ * Processes running in the same computer (e.g. a vision co-processor or a
+ * LED controller) can read the enable state, control mode, alliance and
+ * joystick input of the DS without any socket round trip, by mapping the
+ * segment with the reader in \c sharedstate.h.
+ *
+ * The robot status is updated when the DS reports a change, and the
+ * joystick input is updated every time that it is sent to the DS. Each
+ * update writes the whole status to the segment, readers never block the DS.
+ * If nothing changes, the status is published again every control period,
+ * so that readers can tell a quiet DS from a segment left by a crashed DS.
+ */
+class StatePublisher : public QObject
+{
+   Q_OBJECT
+
+public:
+   explicit StatePublisher(DriverStation *driverstation, Joysticks *joysticks);
+   ~StatePublisher();
+
+   bool open(const char *name = QDS_SHARED_STATE_NAME);
+   void close();
+
+public slots:
+   void updateStatus();
+   void updateJoysticks();
+
+private slots:
+   void publish();
+
+private:
+   QDSSharedStatus m_status;
+   QDSSharedSegment *m_segment;
+   QTimer m_heartbeat;
+
+   Joysticks *m_joysticks;
+   DriverStation *m_driverstation;
+
+   QByteArray m_name;
+#ifdef Q_OS_WIN
+   HANDLE m_handle;
+#endif
+};
+
+#endif
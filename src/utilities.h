@@ -1,88 +1,97 @@
-/*
- * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#ifndef _QDS_UTILITIES_H
-#define _QDS_UTILITIES_H
-
-#include <QProcess>
-
-#if defined Q_OS_LINUX
-#   include <QPair>
-#endif
-
-class QSettings;
-
-/**
- * \brief Provides CPU and Battery information to the QML interface
- */
-class Utilities : public QObject
-{
-   Q_OBJECT
-   Q_PROPERTY(int cpuUsage READ cpuUsage NOTIFY cpuUsageChanged)
-   Q_PROPERTY(int batteryLevel READ batteryLevel NOTIFY batteryLevelChanged)
-   Q_PROPERTY(bool connectedToAC READ isConnectedToAC NOTIFY connectedToACChanged)
-   Q_PROPERTY(qreal scaleRatio READ scaleRatio CONSTANT)
-
-signals:
-   void cpuUsageChanged();
-   void batteryLevelChanged();
-   void connectedToACChanged();
-
-public:
-   explicit Utilities();
-
-   int cpuUsage();
-   int batteryLevel();
-   qreal scaleRatio();
-   bool isConnectedToAC();
-
-public slots:
-   void copy(const QVariant &data);
-   void setAutoScaleEnabled(const bool enabled);
-
-private slots:
-   void updateCpuUsage();
-   void updateBatteryLevel();
-   void updateConnectedToAC();
-   void calculateScaleRatio();
-   void readCpuUsageProcess(int exit_code = 0);
-   void readBatteryLevelProcess(int exit_code = 0);
-   void readConnectedToACProcess(int exit_code = 0);
-
-private:
-#if defined(Q_OS_LINUX)
-   QPair<quint64, quint64> getCpuJiffies();
-   QPair<quint64, quint64> m_pastCpuJiffies { 0, 0 };
-#endif
-
-   qreal m_ratio;
-   int m_cpuUsage;
-   int m_batteryLevel;
-   bool m_connectedToAC;
-
-   QSettings *m_settings;
-   QProcess m_cpuProcess;
-   QProcess m_batteryLevelProcess;
-   QProcess m_connectedToACProcess;
-};
-
-#endif
+/*
+ * Copyright (c) 2015-2020 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_UTILITIES_H
+#define _QDS_UTILITIES_H
+
+#include <QThread>
+#include <QVariant>
+
+#include "hostprobe.h"
+
+class QSettings;
+
+/**
+ * \brief Provides CPU and Battery information to the QML interface
+ *
+ * Besides the host CPU usage, the usage of each CPU core and the CPU & memory
+ * usage of this process (and of each of its threads) are reported on
+ * GNU/Linux. This allows us to know if the DS itself is loading the computer.
+ *
+ * The values are obtained by a \c HostProbe running in a separate thread, so
+ * that probing the OS never blocks the GUI thread.
+ */
+class Utilities : public QObject
+{
+   Q_OBJECT
+   Q_PROPERTY(int cpuUsage READ cpuUsage NOTIFY cpuUsageChanged)
+   Q_PROPERTY(QVariantList cpuCoreUsage READ cpuCoreUsage NOTIFY cpuDetailsChanged)
+   Q_PROPERTY(int processCpuUsage READ processCpuUsage NOTIFY cpuDetailsChanged)
+   Q_PROPERTY(int processMemoryUsage READ processMemoryUsage NOTIFY cpuDetailsChanged)
+   Q_PROPERTY(QVariantList threadCpuUsage READ threadCpuUsage NOTIFY cpuDetailsChanged)
+   Q_PROPERTY(int dashboardCpuUsage READ dashboardCpuUsage NOTIFY dashboardUsageChanged)
+   Q_PROPERTY(int dashboardMemoryUsage READ dashboardMemoryUsage NOTIFY dashboardUsageChanged)
+   Q_PROPERTY(int batteryLevel READ batteryLevel NOTIFY batteryLevelChanged)
+   Q_PROPERTY(bool connectedToAC READ isConnectedToAC NOTIFY connectedToACChanged)
+   Q_PROPERTY(qreal scaleRatio READ scaleRatio CONSTANT)
+
+signals:
+   void cpuUsageChanged();
+   void cpuDetailsChanged();
+   void dashboardUsageChanged();
+   void batteryLevelChanged();
+   void connectedToACChanged();
+
+public:
+   explicit Utilities();
+   ~Utilities();
+
+   int cpuUsage();
+   int batteryLevel();
+   int processCpuUsage();
+   int processMemoryUsage();
+   int dashboardCpuUsage();
+   int dashboardMemoryUsage();
+   QVariantList cpuCoreUsage();
+   QVariantList threadCpuUsage();
+   qreal scaleRatio();
+   bool isConnectedToAC();
+
+public slots:
+   void copy(const QVariant &data);
+   void setDashboardProcess(const qint64 pid);
+   void setAutoScaleEnabled(const bool enabled);
+
+private slots:
+   void calculateScaleRatio();
+   void applySample(const HostSample &sample);
+
+private:
+   qreal m_ratio;
+   HostSample m_sample;
+
+   QThread m_thread;
+   HostProbe *m_probe;
+   QSettings *m_settings;
+};
+
+#endif
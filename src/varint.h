@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2015-2021 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QDS_VARINT_H
+#define _QDS_VARINT_H
+
+#include <QtGlobal>
+
+/**
+ * Writes the given \a value as a zig-zag varint, returns the end of the value
+ */
+inline uchar *writeVarint(uchar *out, const qint64 value)
+{
+   quint64 v = (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+   while (v >= 0x80)
+   {
+      *out++ = static_cast<uchar>(v | 0x80);
+      v >>= 7;
+   }
+
+   *out++ = static_cast<uchar>(v);
+   return out;
+}
+
+/**
+ * Reads a zig-zag varint into \a value, returns the end of the value or
+ * \c Q_NULLPTR if the data is truncated
+ */
+inline const uchar *readVarint(const uchar *in, const uchar *end, qint64 &value)
+{
+   quint64 v = 0;
+   for (int shift = 0; in < end && shift < 64; shift += 7)
+   {
+      const uchar byte = *in++;
+      v |= static_cast<quint64>(byte & 0x7f) << shift;
+
+      if (!(byte & 0x80))
+      {
+         value = static_cast<qint64>(v >> 1) ^ -static_cast<qint64>(v & 1);
+         return in;
+      }
+   }
+
+   return Q_NULLPTR;
+}
+
+#endif